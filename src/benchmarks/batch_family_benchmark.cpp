@@ -0,0 +1,252 @@
+/**
+ * @file	batch_family_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks how TensorRTEngine picks and builds networks for batch sizes
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MockBackend.h"
+#include "TensorRTEngine.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Networks built by the backend factory of an engine. Builds can be
+ * held back and one batch size can be made to fail.
+ */
+struct Family {
+  Family() { failing = 0; }
+
+  ExecutionBackend *build(std::vector<NetworkInput> inputs,
+                          std::vector<NetworkOutput> outputs,
+                          size_t batchSize) {
+    std::shared_future<void> opened;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      requested.push_back(batchSize);
+      opened = gate;
+    }
+
+    if (opened.valid())
+      opened.wait();
+
+    if (batchSize == failing)
+      throw std::runtime_error("Simulated build failure");
+
+    MockBackend *mock = new MockBackend(inputs, outputs);
+    std::lock_guard<std::mutex> lock(mutex);
+    built[batchSize] = mock;
+    return mock;
+  }
+
+  MockBackend *backend(size_t batchSize) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return built.count(batchSize) ? built[batchSize] : NULL;
+  }
+
+  std::vector<size_t> builds() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return requested;
+  }
+
+  void hold(std::shared_future<void> opened) {
+    std::lock_guard<std::mutex> lock(mutex);
+    gate = opened;
+  }
+
+  size_t failing;
+
+private:
+  std::mutex mutex;
+  std::vector<size_t> requested;
+  std::map<size_t, MockBackend *> built;
+  std::shared_future<void> gate;
+};
+
+/**
+ * @brief Engine with a small fixed network which runs on a MockBackend and
+ * builds the networks of its other batch sizes as mocks too
+ */
+class BenchmarkEngine : public TensorRTEngine {
+public:
+  BenchmarkEngine(size_t maxBatchSize, Family &family) {
+    addInput("data", nvinfer1::DimsCHW(3, 8, 8), sizeof(float));
+
+    nvinfer1::Dims outputDims;
+    outputDims.nbDims = 1;
+    outputDims.d[0] = 10;
+    addOutput("prob", outputDims, sizeof(float));
+
+    mock = new MockBackend(networkInputs, networkOutputs);
+    attachBackend(mock, maxBatchSize);
+
+    std::vector<NetworkInput> inputs = networkInputs;
+    std::vector<NetworkOutput> outputs = networkOutputs;
+    setBackendFactory([&family, inputs, outputs](size_t batchSize) {
+      return family.build(inputs, outputs, batchSize);
+    });
+
+    this->inputs = allocInputs(MemoryLocation::HOST);
+    this->outputs = allocOutputs(MemoryLocation::HOST);
+  }
+
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+
+  /**
+   * @brief Runs a batch and checks which network it ran on
+   * @return Whether the batch ran on expected
+   */
+  bool ranOn(MockBackend *expected, size_t batchSize) {
+    if (expected == NULL)
+      return false;
+
+    size_t before = expected->executions();
+
+    LocatedExecutionMemory batchInputs = inputs.view(batchSize);
+    LocatedExecutionMemory batchOutputs = outputs.view(batchSize);
+    predict(batchInputs, batchOutputs);
+
+    return expected->executions() == before + 1;
+  }
+
+  /**
+   * @brief Waits until the network of a batch size is built
+   * @return Whether it was built within a second
+   */
+  bool waitBuilt(size_t batchSize) {
+    for (int wait = 0; wait < 1000; wait++) {
+      std::vector<size_t> built = getBuiltBatchSizes();
+      for (int b = 0; b < built.size(); b++)
+        if (built[b] == batchSize)
+          return true;
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+  }
+
+  MockBackend *mock;
+
+private:
+  LocatedExecutionMemory inputs, outputs;
+};
+
+typedef std::vector<size_t> Sizes;
+
+static bool report(const char *check, bool passed) {
+  printf("%s: %s\n", check, passed ? "ok" : "FAILED");
+  return passed;
+}
+
+/**
+ * @brief Batches are run on the smallest built network which fits them, and
+ * only the best fitting network is built on demand
+ */
+static bool checkSelection() {
+  Family family;
+  BenchmarkEngine engine(8, family);
+  engine.setBatchSizes(Sizes{2, 4});
+
+  // Nothing is built yet, so the first batch runs on the network for 8 and
+  // only queues the network for 4
+  bool ok = report("batch of 3 runs on 8 and builds 4",
+                   engine.ranOn(engine.mock, 3) && engine.waitBuilt(4) &&
+                       family.builds() == Sizes{4});
+
+  // While the network for 2 builds, batches that fit it run on 4
+  std::promise<void> open;
+  family.hold(open.get_future().share());
+
+  ok = report("batches of 1 and 2 run on 4 while 2 builds",
+              engine.ranOn(family.backend(4), 1) &&
+                  engine.ranOn(family.backend(4), 2)) &&
+       ok;
+
+  open.set_value();
+
+  ok = report("batches of 1, 2, 3 and 8 run on 2, 2, 4 and 8",
+              engine.waitBuilt(2) && engine.ranOn(family.backend(2), 1) &&
+                  engine.ranOn(family.backend(2), 2) &&
+                  engine.ranOn(family.backend(4), 3) &&
+                  engine.ranOn(engine.mock, 8)) &&
+       ok;
+
+  return report("every network was built once",
+                family.builds() == Sizes({4, 2})) &&
+         ok;
+}
+
+/**
+ * @brief A batch size whose network fails to build keeps running on the
+ * next larger network and is not built again
+ */
+static bool checkFailure() {
+  Family family;
+  family.failing = 2;
+  BenchmarkEngine engine(8, family);
+  engine.setBatchSizes(Sizes{2, 4});
+
+  bool ok = engine.ranOn(engine.mock, 3) && engine.waitBuilt(4);
+
+  // Queues the network for 2, which fails
+  ok = ok && engine.ranOn(family.backend(4), 1);
+  engine.buildBatchSizes();
+
+  return report("batches of 1 and 2 run on 4 after 2 failed to build",
+                ok && engine.ranOn(family.backend(4), 1) &&
+                    engine.ranOn(family.backend(4), 2) &&
+                    family.builds() == Sizes({4, 2}) &&
+                    engine.getBuiltBatchSizes() == Sizes({4, 8}));
+}
+
+int main() {
+  bool failed = false;
+
+  if (!checkSelection()) {
+    fprintf(stderr, "Batches ran on the wrong network\n");
+    failed = true;
+  }
+
+  if (!checkFailure()) {
+    fprintf(stderr, "Batches did not fall back after a failed build\n");
+    failed = true;
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,319 @@
+/**
+ * @file	batch_scheduler_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks and times BatchScheduler against a MockBackend
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BatchScheduler.h"
+#include "MockBackend.h"
+#include "TensorRTEngine.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Engine with a small fixed network which runs on a MockBackend that
+ * takes the same time for every batch, like a GPU which is not saturated
+ */
+class BenchmarkEngine : public TensorRTEngine {
+public:
+  BenchmarkEngine(size_t maxBatchSize, std::chrono::microseconds latency) {
+    addInput("data", nvinfer1::DimsCHW(3, 8, 8), sizeof(float));
+
+    nvinfer1::Dims outputDims;
+    outputDims.nbDims = 1;
+    outputDims.d[0] = 10;
+    addOutput("prob", outputDims, sizeof(float));
+
+    attachBackend(new MockBackend(networkInputs, networkOutputs, latency),
+                  maxBatchSize);
+  }
+
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+};
+
+/**
+ * @brief One producer's request, with memory of its own like a camera
+ */
+struct Request {
+  Request(size_t inputSize, size_t outputSize, int seed)
+      : input(inputSize), output(outputSize) {
+    for (size_t b = 0; b < inputSize; b++)
+      input[b] = (unsigned char)(seed * 131 + b);
+  }
+
+  std::future<void> submit(BatchScheduler &scheduler) {
+    return scheduler.submit(std::vector<void *>(1, &input[0]),
+                            std::vector<void *>(1, &output[0]));
+  }
+
+  std::vector<unsigned char> input, output;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/**
+ * @brief Submits one request from each of many producers at once, which
+ * should be grouped into full batches
+ */
+static bool checkGrouping(BenchmarkEngine &engine, size_t inputSize,
+                          size_t outputSize) {
+  const int producers = 8, maxBatchSize = 4;
+
+  BatchScheduler scheduler(&engine, MemoryLocation::HOST,
+                           MemoryLocation::HOST, std::chrono::seconds(1),
+                           maxBatchSize);
+
+  std::vector<Request *> requests;
+  for (int p = 0; p < producers; p++)
+    requests.push_back(new Request(inputSize, outputSize, p));
+
+  std::vector<std::future<void>> done;
+  for (int p = 0; p < producers; p++)
+    done.push_back(requests[p]->submit(scheduler));
+  for (int p = 0; p < producers; p++)
+    done[p].get();
+
+  for (int p = 0; p < producers; p++)
+    delete requests[p];
+
+  size_t batches = scheduler.batches();
+  printf("grouping: %d requests in %zu batches of up to %d\n", producers,
+         batches, maxBatchSize);
+
+  return batches == producers / maxBatchSize &&
+         scheduler.requests() == producers;
+}
+
+/**
+ * @brief Submits a lone request, which has to be dispatched once it waited
+ * maxWait although its batch never fills up
+ */
+static bool checkDeadline(BenchmarkEngine &engine, size_t inputSize,
+                          size_t outputSize) {
+  const std::chrono::milliseconds maxWait(20);
+
+  BatchScheduler scheduler(&engine, MemoryLocation::HOST,
+                           MemoryLocation::HOST, maxWait);
+  Request request(inputSize, outputSize, 0);
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  request.submit(scheduler).get();
+  double waited = secondsSince(start);
+
+  printf("deadline: lone request done after %.1f ms, max wait %ld ms\n",
+         waited * 1000, (long)maxWait.count());
+
+  // The mock adds its own latency on top of the wait
+  return waited >= 0.9 * maxWait.count() / 1000.0 && waited < 1.0 &&
+         scheduler.batches() == 1;
+}
+
+/**
+ * @brief Fills a batch while a request is already waiting and submits one
+ * more right after. One worker dispatches the full batch, and the other one
+ * still has to give the last request maxWait, not only until the deadline of
+ * the dispatched requests.
+ */
+static bool checkWorkerDeadline(size_t inputSize, size_t outputSize) {
+  const std::chrono::milliseconds maxWait(200);
+
+  BenchmarkEngine engine(2, std::chrono::microseconds(0));
+  BatchScheduler scheduler(&engine, MemoryLocation::HOST,
+                           MemoryLocation::HOST, maxWait, 2, 2);
+  Request first(inputSize, outputSize, 0), second(inputSize, outputSize, 1),
+      late(inputSize, outputSize, 2);
+
+  std::future<void> firstDone = first.submit(scheduler);
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::future<void> secondDone = second.submit(scheduler);
+  std::future<void> lateDone = late.submit(scheduler);
+  firstDone.get();
+  secondDone.get();
+  lateDone.get();
+  double waited = secondsSince(start);
+
+  printf("worker deadline: request after a full batch done after %.1f ms, "
+         "max wait %ld ms\n",
+         waited * 1000, (long)maxWait.count());
+
+  return waited >= 0.9 * maxWait.count() / 1000.0 && waited < 1.0 &&
+         scheduler.batches() == 2;
+}
+
+/**
+ * @brief Runs many producers concurrently and checks that every one gets
+ * the outputs of its own input back
+ * @return Number of requests whose outputs were wrong
+ */
+static int checkSlices(BenchmarkEngine &engine, BatchScheduler &scheduler,
+                       size_t inputSize, size_t outputSize, int producers,
+                       int perProducer) {
+
+  BenchmarkEngine reference(1, std::chrono::microseconds(0));
+  std::atomic<int> wrong(0);
+  std::vector<std::thread> threads;
+
+  for (int p = 0; p < producers; p++)
+    threads.push_back(std::thread([&, p]() {
+      LocatedExecutionMemory inputs =
+          reference.allocInputs(MemoryLocation::HOST);
+      LocatedExecutionMemory outputs =
+          reference.allocOutputs(MemoryLocation::HOST);
+
+      for (int r = 0; r < perProducer; r++) {
+        Request request(inputSize, outputSize, p * perProducer + r);
+        request.submit(scheduler).get();
+
+        memcpy(inputs[0][0], &request.input[0], inputSize);
+        reference.predict(inputs, outputs);
+
+        if (memcmp(outputs[0][0], &request.output[0], outputSize) != 0)
+          wrong++;
+      }
+
+      inputs.release();
+      outputs.release();
+    }));
+
+  for (int p = 0; p < threads.size(); p++)
+    threads[p].join();
+
+  return wrong;
+}
+
+/**
+ * @brief Runs the same producers with a batch 1 predict() each, the way
+ * callers ran before batching
+ * @return Requests per second
+ */
+static double measureUnbatched(BenchmarkEngine &engine, int producers,
+                               int perProducer) {
+  std::vector<std::thread> threads;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  for (int p = 0; p < producers; p++)
+    threads.push_back(std::thread([&engine, perProducer]() {
+      LocatedExecutionMemory inputs = engine.allocInputs(MemoryLocation::HOST);
+      LocatedExecutionMemory outputs =
+          engine.allocOutputs(MemoryLocation::HOST);
+      LocatedExecutionMemory input = inputs.view(1);
+      LocatedExecutionMemory output = outputs.view(1);
+
+      for (int r = 0; r < perProducer; r++)
+        engine.predict(input, output);
+
+      inputs.release();
+      outputs.release();
+    }));
+
+  for (int p = 0; p < threads.size(); p++)
+    threads[p].join();
+
+  return producers * perProducer / secondsSince(start);
+}
+
+int main(int argc, char **argv) {
+  int producers = argc > 1 ? std::atoi(argv[1]) : 8;
+  int perProducer = argc > 2 ? std::atoi(argv[2]) : 200;
+  if (producers <= 0 || perProducer <= 0) {
+    fprintf(stderr, "Usage: %s [producers [requests per producer]]\n",
+            argv[0]);
+    return 1;
+  }
+
+  const std::chrono::microseconds latency(500);
+  BenchmarkEngine engine(producers, latency);
+
+  size_t inputSize = engine.networkInputs[0].size();
+  size_t outputSize = engine.networkOutputs[0].size();
+
+  bool failed = false;
+
+  if (!checkGrouping(engine, inputSize, outputSize)) {
+    fprintf(stderr, "Requests were not grouped into full batches\n");
+    failed = true;
+  }
+
+  if (!checkDeadline(engine, inputSize, outputSize)) {
+    fprintf(stderr, "Lone request was not dispatched at its deadline\n");
+    failed = true;
+  }
+
+  if (!checkWorkerDeadline(inputSize, outputSize)) {
+    fprintf(stderr, "A worker dispatched a request before its deadline\n");
+    failed = true;
+  }
+
+  // Every producer waits for its request like a camera waits for its frame,
+  // so batches hold at most one request per producer
+  BatchScheduler scheduler(&engine, MemoryLocation::HOST, MemoryLocation::HOST,
+                           std::chrono::milliseconds(2));
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  int wrong = checkSlices(engine, scheduler, inputSize, outputSize, producers,
+                          perProducer);
+  double batchedSeconds = secondsSince(start);
+
+  int total = producers * perProducer;
+  printf("slices: %d producers, %d requests in %zu batches, %.1f "
+         "requests/s\n",
+         producers, total, scheduler.batches(), total / batchedSeconds);
+
+  printf("unbatched: %d producers, %.1f requests/s\n", producers,
+         measureUnbatched(engine, producers, perProducer));
+
+  if (wrong > 0) {
+    fprintf(stderr, "%d of %d requests got outputs of another request\n",
+            wrong, total);
+    failed = true;
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file	cache_contention_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Processes sharing an engine cache, counting how often they build
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "EngineCache.h"
+#include "MockBackend.h"
+
+using namespace jetson_tensorrt;
+
+enum Outcome { LOADED = 0, BUILT = 1, FAILED = 2 };
+
+struct StartResult {
+  Outcome outcome;
+  double seconds;
+};
+
+/**
+ * @brief Fetches the engine the way a node starting up does, with a stub
+ * builder standing in for TensorRT
+ */
+static StartResult start(std::string directory, int buildMillis) {
+  StartResult result;
+  result.outcome = FAILED;
+  result.seconds = -1;
+
+  std::vector<NetworkInput> inputs;
+  inputs.push_back(NetworkInput("data", nvinfer1::DimsCHW(3, 8, 8), 4));
+  std::vector<NetworkOutput> outputs;
+  nvinfer1::Dims outputDims;
+  outputDims.nbDims = 1;
+  outputDims.d[0] = 10;
+  outputs.push_back(NetworkOutput("prob", outputDims, 4));
+
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+
+  try {
+    EngineCache cache(directory);
+    bool built = false;
+
+    ExecutionBackend *backend = cache.fetch(
+        []() {
+          EngineCacheKey key;
+          key.addString("cache_contention_benchmark");
+          return key.str();
+        },
+        [inputs, outputs]() { return new MockBackend(inputs, outputs); },
+        [inputs, outputs, buildMillis, &built]() {
+          std::this_thread::sleep_for(std::chrono::milliseconds(buildMillis));
+          built = true;
+          return new MockBackend(inputs, outputs);
+        });
+
+    delete backend;
+    result.outcome = built ? BUILT : LOADED;
+  } catch (std::exception &e) {
+    fprintf(stderr, "Start failed: %s\n", e.what());
+  }
+
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+  return result;
+}
+
+/**
+ * @brief MockBackend which fails to load for a reason unrelated to the data,
+ * like a device running out of memory
+ */
+class FailingBackend : public MockBackend {
+public:
+  FailingBackend(std::vector<NetworkInput> inputs,
+                 std::vector<NetworkOutput> outputs)
+      : MockBackend(inputs, outputs) {}
+
+  void load(const void *blob, size_t size) {
+    throw std::runtime_error("out of memory");
+  }
+};
+
+/**
+ * @brief Checks that a corrupt entry is rebuilt, while an entry which fails
+ * to load for any other reason is kept
+ */
+static bool checkLoadErrors(std::string directory) {
+  std::vector<NetworkInput> inputs;
+  inputs.push_back(NetworkInput("data", nvinfer1::DimsCHW(3, 8, 8), 4));
+  std::vector<NetworkOutput> outputs;
+  outputs.push_back(NetworkOutput("prob", nvinfer1::DimsCHW(10, 1, 1), 4));
+
+  EngineCache cache(directory);
+  std::function<std::string()> key = []() {
+    EngineCacheKey key;
+    key.addString("cache_contention_benchmark load errors");
+    return key.str();
+  };
+  std::function<ExecutionBackend *()> create = [inputs, outputs]() {
+    return new MockBackend(inputs, outputs);
+  };
+  bool built = false;
+  std::function<ExecutionBackend *()> build = [inputs, outputs, &built]() {
+    built = true;
+    return new MockBackend(inputs, outputs);
+  };
+
+  delete cache.fetch(key, create, build);
+
+  std::ofstream(cache.entryPath(key())) << "not an engine";
+  built = false;
+  delete cache.fetch(key, create, build);
+  if (!built) {
+    fprintf(stderr, "Corrupt entry was not rebuilt\n");
+    return false;
+  }
+
+  bool thrown = false;
+  try {
+    delete cache.fetch(
+        key,
+        [inputs, outputs]() { return new FailingBackend(inputs, outputs); },
+        build);
+  } catch (std::runtime_error &e) {
+    thrown = true;
+  }
+
+  if (!thrown || !cache.lookup(key())) {
+    fprintf(stderr, "Failing to load removed a valid entry\n");
+    return false;
+  }
+
+  cache.remove(key());
+  return true;
+}
+
+/**
+ * @brief Checks that the key is computed once to look up and lock an engine,
+ * and once more to save it after a build which changed it
+ */
+static bool checkKeys(std::string directory) {
+  std::vector<NetworkInput> inputs;
+  inputs.push_back(NetworkInput("data", nvinfer1::DimsCHW(3, 8, 8), 4));
+  std::vector<NetworkOutput> outputs;
+  outputs.push_back(NetworkOutput("prob", nvinfer1::DimsCHW(10, 1, 1), 4));
+
+  EngineCache cache(directory);
+  int computed = 0;
+  bool built = false;
+  std::function<std::string()> key = [&computed, &built]() {
+    computed++;
+    // Like a calibration table written while building
+    EngineCacheKey key;
+    key.addString("cache_contention_benchmark keys");
+    key.addValue(built ? 1 : 0);
+    return key.str();
+  };
+  std::function<ExecutionBackend *()> create = [inputs, outputs]() {
+    return new MockBackend(inputs, outputs);
+  };
+  std::function<ExecutionBackend *()> build = [inputs, outputs, &built]() {
+    built = true;
+    return new MockBackend(inputs, outputs);
+  };
+
+  delete cache.fetch(key, create, build);
+  bool ok = computed == 2;
+
+  EngineCacheKey unbuilt;
+  unbuilt.addString("cache_contention_benchmark keys");
+  unbuilt.addValue(0);
+  ok &= access((directory + "/" + unbuilt.str() + ".lock").c_str(), F_OK) != 0;
+
+  computed = 0;
+  delete cache.fetch(key, create, build);
+  ok &= computed == 1;
+
+  if (!ok)
+    fprintf(stderr, "The key was computed more often than needed\n");
+
+  cache.remove(key());
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "Usage: %s <cache directory> [processes] [build ms] [rounds]\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::string directory = argv[1];
+  int processes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 8;
+  int buildMillis = argc > 3 ? std::max(0, std::atoi(argv[3])) : 500;
+  int rounds = argc > 4 ? std::max(1, std::atoi(argv[4])) : 3;
+
+  bool failed = false;
+
+  printf("%-6s %7s %7s %7s %18s\n", "round", "built", "loaded", "failed",
+         "slowest start (s)");
+
+  for (int r = 0; r < rounds; r++) {
+    // Every round starts from an empty cache, like a freshly changed model
+    {
+      EngineCache cache(directory);
+      EngineCacheKey key;
+      key.addString("cache_contention_benchmark");
+      cache.remove(key.str());
+    }
+
+    std::vector<int> pipes;
+    std::vector<pid_t> children;
+
+    for (int p = 0; p < processes; p++) {
+      int resultPipe[2];
+      if (pipe(resultPipe) != 0) {
+        fprintf(stderr, "Unable to create pipe\n");
+        return 1;
+      }
+
+      pid_t child = fork();
+      if (child < 0) {
+        fprintf(stderr, "Unable to fork\n");
+        return 1;
+      }
+
+      if (child == 0) {
+        close(resultPipe[0]);
+        StartResult result = start(directory, buildMillis);
+        ssize_t written = write(resultPipe[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+      }
+
+      close(resultPipe[1]);
+      pipes.push_back(resultPipe[0]);
+      children.push_back(child);
+    }
+
+    int counts[3] = {0, 0, 0};
+    double slowest = 0;
+
+    for (int p = 0; p < processes; p++) {
+      StartResult result;
+      ssize_t bytesRead = read(pipes[p], &result, sizeof(result));
+      close(pipes[p]);
+      waitpid(children[p], NULL, 0);
+
+      if (bytesRead != sizeof(result))
+        result.outcome = FAILED;
+
+      counts[result.outcome]++;
+      slowest = std::max(slowest, result.seconds);
+    }
+
+    printf("%-6d %7d %7d %7d %18.3f\n", r, counts[BUILT], counts[LOADED],
+           counts[FAILED], slowest);
+
+    // Exactly one process should have built, the rest load its engine
+    failed |= counts[BUILT] != 1 || counts[FAILED] != 0;
+
+    // The build lock of the key is deleted once the engine is saved
+    EngineCacheKey key;
+    key.addString("cache_contention_benchmark");
+    if (access((directory + "/" + key.str() + ".lock").c_str(), F_OK) == 0) {
+      fprintf(stderr, "Build lock of round %d was left behind\n", r);
+      failed = true;
+    }
+  }
+
+  if (failed)
+    fprintf(stderr, "Processes built the engine more than once or failed\n");
+
+  failed |= !checkLoadErrors(directory);
+  failed |= !checkKeys(directory);
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file	cache_load_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Compares loading an engine cache through streams and mmap
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+#include "TensorRTBackend.h"
+#include "TensorRTEngine.h"
+
+using namespace jetson_tensorrt;
+
+struct LoadResult {
+  double seconds;
+  long peakRSSKilobytes;
+};
+
+/**
+ * @brief Loads the cache the way TensorRTEngine::loadCache() used to, through
+ * an ifstream, a stringstream, and a heap copy
+ */
+static void loadStream(ExecutionBackend &backend, std::string cachePath) {
+  std::ifstream cache;
+  cache.open(cachePath);
+  if (!cache.is_open())
+    throw std::runtime_error("Unable to open network cache file");
+
+  std::stringstream gieModelStream;
+  gieModelStream << cache.rdbuf();
+  cache.close();
+
+  gieModelStream.seekg(0, std::ios::end);
+  const size_t modelSize = gieModelStream.tellg();
+  gieModelStream.seekg(0, std::ios::beg);
+
+  void *modelMem = safeMalloc(modelSize);
+  gieModelStream.read((char *)modelMem, modelSize);
+
+  backend.load(modelMem, modelSize);
+  free(modelMem);
+}
+
+static void loadMapped(ExecutionBackend &backend, std::string cachePath) {
+  MappedFile cache(cachePath);
+  backend.load(cache.data(), cache.size());
+}
+
+/**
+ * @brief Runs a load in a child process so its peak RSS is not polluted by
+ * earlier loads
+ */
+static LoadResult measure(void (*load)(ExecutionBackend &, std::string),
+                          std::string cachePath) {
+  int resultPipe[2];
+  if (pipe(resultPipe) != 0)
+    throw std::runtime_error("Unable to create pipe");
+
+  pid_t child = fork();
+  if (child < 0)
+    throw std::runtime_error("Unable to fork");
+
+  if (child == 0) {
+    close(resultPipe[0]);
+
+    LoadResult result;
+    result.seconds = -1;
+
+    try {
+      Logger logger;
+      TensorRTBackend backend(logger);
+
+      std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      load(backend, cachePath);
+      result.seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    } catch (std::exception &e) {
+      fprintf(stderr, "Load failed: %s\n", e.what());
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.peakRSSKilobytes = usage.ru_maxrss;
+
+    ssize_t written = write(resultPipe[1], &result, sizeof(result));
+    _exit(written == sizeof(result) ? 0 : 1);
+  }
+
+  close(resultPipe[1]);
+
+  LoadResult result;
+  ssize_t bytesRead = read(resultPipe[0], &result, sizeof(result));
+  close(resultPipe[0]);
+  waitpid(child, NULL, 0);
+
+  if (bytesRead != sizeof(result) || result.seconds < 0)
+    throw std::runtime_error("Loading " + cachePath + " failed");
+
+  return result;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <engine cache> [repeats]\n", argv[0]);
+    return 1;
+  }
+
+  std::string cachePath = argv[1];
+  int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+
+  const char *names[] = {"stream", "mmap"};
+  void (*loads[])(ExecutionBackend &, std::string) = {loadStream, loadMapped};
+  LoadResult best[2];
+
+  // Alternate the paths so both see the same page cache state
+  for (int r = 0; r < repeats; r++) {
+    for (int p = 0; p < 2; p++) {
+      LoadResult result = measure(loads[p], cachePath);
+
+      if (r == 0 || result.seconds < best[p].seconds)
+        best[p].seconds = result.seconds;
+      if (r == 0 || result.peakRSSKilobytes > best[p].peakRSSKilobytes)
+        best[p].peakRSSKilobytes = result.peakRSSKilobytes;
+    }
+  }
+
+  printf("%-8s %14s %16s\n", "path", "best load (s)", "peak RSS (MB)");
+  for (int p = 0; p < 2; p++)
+    printf("%-8s %14.3f %16.1f\n", names[p], best[p].seconds,
+           best[p].peakRSSKilobytes / 1024.0);
+
+  return 0;
+}
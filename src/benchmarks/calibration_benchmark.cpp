@@ -0,0 +1,198 @@
+/**
+ * @file	calibration_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks the calibration table and image sources on the host
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "CalibrationImages.h"
+#include "CalibrationTable.h"
+
+using namespace jetson_tensorrt;
+
+static const char *HEADER = "TRT-5105-EntropyCalibration";
+
+static bool report(const char *check, bool passed) {
+  printf("%s: %s\n", check, passed ? "ok" : "FAILED");
+  return passed;
+}
+
+static bool sameTable(CalibrationTable &table, std::string expected) {
+  return table.size() == expected.size() &&
+         memcmp(table.data(), expected.data(), expected.size()) == 0;
+}
+
+static bool checkTable(std::string directory) {
+  std::string path = directory + "/calibration.table";
+  std::string written =
+      std::string(HEADER) + "\ndata: 3c008912\nconv1: 3d9b2c6a\n";
+
+  remove(path.c_str());
+  CalibrationTable missing(path, HEADER);
+  bool ok = report("a missing table is not loaded",
+                   !missing.load() && missing.data() == NULL);
+
+  CalibrationTable saved(path, HEADER);
+  saved.save(written.data(), written.size());
+
+  CalibrationTable loaded(path, HEADER);
+  ok = report("a saved table loads back unchanged",
+              loaded.load() && sameTable(loaded, written)) &&
+       ok;
+
+  CalibrationTable other(path, "TRT-4002-EntropyCalibration2");
+  bool rejected = false;
+  try {
+    other.load();
+  } catch (std::runtime_error &e) {
+    rejected = true;
+  }
+  ok = report("a table of another version or algorithm is rejected",
+              rejected && other.size() == 0 && other.data() == NULL) &&
+       ok;
+
+  CalibrationTable any(path);
+  return report("a table without an expected header accepts any table",
+                any.load() && sameTable(any, written)) &&
+         ok;
+}
+
+static void writePPM(std::string path, unsigned char value) {
+  std::ofstream file(path, std::ios::binary);
+  file << "P6\n# calibration image\n2 1\n255\n";
+  for (int b = 0; b < 6; b++)
+    file.put(value);
+}
+
+static bool checkPPMBatches(std::string directory) {
+  std::string images = directory + "/images";
+  if (mkdir(images.c_str(), 0755) != 0 && errno != EEXIST)
+    throw std::runtime_error("Unable to create " + images + ": " +
+                             std::string(strerror(errno)));
+
+  // Written out of name order, which is the order they are read in
+  for (int i = 6; i >= 0; i--)
+    writePPM(images + "/image_" + std::to_string(i) + ".ppm", i);
+  std::ofstream(images + "/labels.txt") << "ignored\n";
+
+  PPMDirectorySource source(images);
+  ImageBatcher batcher(&source, 3);
+
+  std::vector<int> values, positions;
+  bool shapes = true;
+  ImageBatcher::ImageFunction consume = [&](const HostImage &image,
+                                            size_t position) {
+    shapes = shapes && image.width == 2 && image.height == 1 &&
+             image.data.size() == 6;
+    values.push_back(image.data[5]);
+    positions.push_back(position);
+  };
+
+  bool complete = batcher.next(consume) && batcher.next(consume);
+  bool ok = report("7 images are read as 2 batches of 3 in name order",
+                   source.size() == 7 && complete && shapes &&
+                       values == std::vector<int>({0, 1, 2, 3, 4, 5}) &&
+                       positions == std::vector<int>({0, 1, 2, 0, 1, 2}));
+
+  bool partial = batcher.next(consume);
+  ok = report("the partial last batch is dropped",
+              !partial && batcher.batches() == 2 && values.size() == 7 &&
+                  values.back() == 6 && positions.back() == 0) &&
+       ok;
+
+  values.clear();
+  source.rewind();
+  return report("rewinding starts from the first image again",
+                batcher.next(consume) &&
+                    values == std::vector<int>({0, 1, 2})) &&
+         ok;
+}
+
+static bool checkFrameFile(std::string directory) {
+  std::string path = directory + "/frames.rgb";
+  const int width = 2, height = 2, frameSize = width * height * 3;
+
+  {
+    std::ofstream file(path, std::ios::binary);
+    for (int f = 0; f < 3; f++)
+      for (int b = 0; b < frameSize; b++)
+        file.put((char)(f * frameSize + b));
+
+    // Recording stopped in the middle of a frame
+    for (int b = 0; b < frameSize / 2; b++)
+      file.put(0);
+  }
+
+  FrameFileSource source(path, width, height);
+  HostImage image;
+
+  bool frames = true;
+  for (int f = 0; f < 3; f++) {
+    frames = frames && source.read(image) && image.width == width &&
+             image.height == height && (int)image.data.size() == frameSize;
+    for (int b = 0; frames && b < frameSize; b++)
+      frames = image.data[b] == f * frameSize + b;
+  }
+  bool ok = report("3 recorded frames are read back in order", frames);
+
+  ok = report("the partial last frame is ignored", !source.read(image)) && ok;
+
+  source.rewind();
+  bool first = source.read(image) && image.data[frameSize - 1] == frameSize - 1;
+  return report("rewinding reads the first frame again", first) && ok;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <scratch directory>\n", argv[0]);
+    return 1;
+  }
+
+  std::string directory = argv[1];
+  bool failed = false;
+
+  if (!checkTable(directory)) {
+    fprintf(stderr, "The calibration table did not round trip\n");
+    failed = true;
+  }
+
+  if (!checkPPMBatches(directory)) {
+    fprintf(stderr, "PPM images were batched wrong\n");
+    failed = true;
+  }
+
+  if (!checkFrameFile(directory)) {
+    fprintf(stderr, "Recorded frames were read wrong\n");
+    failed = true;
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file	context_pool_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks predict() from more threads than execution contexts
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MockBackend.h"
+#include "RegisteredBindings.h"
+#include "TensorRTEngine.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Engine with a small fixed network which runs on a MockBackend that
+ * takes the same time on the calling thread for every execution
+ */
+class BenchmarkEngine : public TensorRTEngine {
+public:
+  BenchmarkEngine(size_t contexts, std::chrono::microseconds latency) {
+    addInput("data", nvinfer1::DimsCHW(3, 8, 8), sizeof(float));
+
+    nvinfer1::Dims outputDims;
+    outputDims.nbDims = 1;
+    outputDims.d[0] = 10;
+    addOutput("prob", outputDims, sizeof(float));
+
+    setContextPoolSize(contexts);
+    attachBackend(new MockBackend(networkInputs, networkOutputs, latency), 1);
+  }
+
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+};
+
+struct PoolResult {
+  int wrong;
+  double seconds;
+};
+
+/**
+ * @brief Runs predict() from every thread at once, half of them on
+ * registered bindings, and compares every output to a single threaded
+ * engine
+ */
+static PoolResult run(size_t contexts, int threads, int perThread,
+                      std::chrono::microseconds latency) {
+  BenchmarkEngine engine(contexts, latency);
+  BenchmarkEngine reference(1, std::chrono::microseconds(0));
+
+  size_t inputSize = engine.networkInputs[0].size();
+  size_t outputSize = engine.networkOutputs[0].size();
+
+  std::atomic<int> wrong(0);
+  std::vector<std::thread> running;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  for (int t = 0; t < threads; t++)
+    running.push_back(std::thread([&, t]() {
+      LocatedExecutionMemory inputs = engine.allocInputs(MemoryLocation::HOST);
+      LocatedExecutionMemory outputs =
+          engine.allocOutputs(MemoryLocation::HOST);
+      LocatedExecutionMemory expected =
+          reference.allocOutputs(MemoryLocation::HOST);
+
+      RegisteredBindings *registered =
+          t % 2 ? engine.registerBindings(inputs, outputs) : NULL;
+
+      for (int r = 0; r < perThread; r++) {
+        unsigned char *input = (unsigned char *)inputs[0][0];
+        for (size_t b = 0; b < inputSize; b++)
+          input[b] = (unsigned char)((t * perThread + r) * 13 + b);
+
+        if (registered)
+          engine.predict(*registered);
+        else
+          engine.predict(inputs, outputs);
+
+        reference.predict(inputs, expected);
+        if (memcmp(outputs[0][0], expected[0][0], outputSize) != 0)
+          wrong++;
+      }
+
+      delete registered;
+    }));
+
+  for (int t = 0; t < running.size(); t++)
+    running[t].join();
+
+  PoolResult result;
+  result.wrong = wrong;
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+#ifndef JETSON_TENSORRT_HOST_ONLY
+/**
+ * @brief Predicts twice on the same context into outputs which were left
+ * unallocated. The first outputs have to keep their values instead of
+ * pointing into the context's buffers, which the second prediction reuses.
+ */
+static bool checkUnallocatedOutputs() {
+  BenchmarkEngine engine(1, std::chrono::microseconds(0));
+
+  size_t inputSize = engine.networkInputs[0].size();
+  size_t outputSize = engine.networkOutputs[0].size();
+
+  LocatedExecutionMemory inputs = engine.allocInputs(MemoryLocation::HOST);
+  LocatedExecutionMemory first =
+      engine.allocOutputs(MemoryLocation::UNIFIED, true);
+  LocatedExecutionMemory second =
+      engine.allocOutputs(MemoryLocation::UNIFIED, true);
+
+  memset(inputs[0][0], 1, inputSize);
+  engine.predict(inputs, first);
+  std::vector<char> expected((char *)first[0][0],
+                             (char *)first[0][0] + outputSize);
+
+  memset(inputs[0][0], 2, inputSize);
+  engine.predict(inputs, second);
+
+  bool owned = first.arena && second.arena && first[0][0] != second[0][0];
+  bool kept = memcmp(first[0][0], &expected[0], outputSize) == 0 &&
+              memcmp(second[0][0], &expected[0], outputSize) != 0;
+
+  printf("unallocated outputs: %s, %s\n",
+         owned ? "owned by the outputs" : "not owned by the outputs",
+         kept ? "kept after the next prediction"
+              : "overwritten by the next prediction");
+
+  inputs.release();
+  first.release();
+  second.release();
+
+  return owned && kept;
+}
+#endif
+
+int main(int argc, char **argv) {
+  int threads = argc > 1 ? std::atoi(argv[1]) : 8;
+  int contexts = argc > 2 ? std::atoi(argv[2]) : 3;
+  int perThread = argc > 3 ? std::atoi(argv[3]) : 50;
+  if (threads <= 0 || contexts <= 0 || contexts >= threads || perThread <= 0) {
+    fprintf(stderr,
+            "Usage: %s [threads [contexts < threads [requests per thread]]]\n",
+            argv[0]);
+    return 1;
+  }
+
+  const std::chrono::microseconds latency(1000);
+  int total = threads * perThread;
+
+  PoolResult single = run(1, threads, perThread, latency);
+  PoolResult pooled = run(contexts, threads, perThread, latency);
+
+  printf("%d threads, 1 context: %.1f requests/s, %d wrong\n", threads,
+         total / single.seconds, single.wrong);
+  printf("%d threads, %d contexts: %.1f requests/s, %d wrong\n", threads,
+         contexts, total / pooled.seconds, pooled.wrong);
+
+  bool failed = false;
+
+  if (single.wrong > 0 || pooled.wrong > 0) {
+    fprintf(stderr, "Threads got outputs of another thread\n");
+    failed = true;
+  }
+
+  // Executions only overlap up to the number of contexts, and do overlap
+  double serialSeconds = total * latency.count() / 1e6;
+  if (pooled.seconds < 0.9 * serialSeconds / contexts) {
+    fprintf(stderr, "More executions ran at once than there are contexts\n");
+    failed = true;
+  }
+  if (pooled.seconds >= single.seconds) {
+    fprintf(stderr, "Contexts of the pool did not run concurrently\n");
+    failed = true;
+  }
+
+#ifndef JETSON_TENSORRT_HOST_ONLY
+  if (!checkUnallocatedOutputs()) {
+    fprintf(stderr, "Unallocated outputs were overwritten by the next "
+                    "prediction\n");
+    failed = true;
+  }
+#endif
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file	latency_histogram_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks LatencyHistogram buckets and percentiles
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "LatencyHistogram.h"
+
+using namespace jetson_tensorrt;
+
+typedef std::chrono::nanoseconds ns;
+
+static bool report(const char *check, bool passed) {
+  printf("%s: %s\n", check, passed ? "ok" : "FAILED");
+  return passed;
+}
+
+static bool checkBuckets() {
+  bool exact = true;
+  for (int v = 0; v < LatencyHistogram::SUB_BUCKET_COUNT; v++)
+    exact = exact && LatencyHistogram::bucketIndex(v) == v &&
+            LatencyHistogram::bucketUpperBound(v) == (uint64_t)v;
+  bool ok = report("latencies below 128ns have exact buckets", exact);
+
+  ok = report("128ns starts the first log-linear bucket",
+              LatencyHistogram::bucketIndex(128) == 128 &&
+                  LatencyHistogram::bucketIndex(129) == 128 &&
+                  LatencyHistogram::bucketIndex(130) == 129 &&
+                  LatencyHistogram::bucketUpperBound(128) == 129) &&
+       ok;
+
+  // Every bucket starts right after the previous one ends, and log-linear
+  // buckets are at most 1/64 of their lower bound wide
+  bool contiguous = true, narrow = true;
+  for (int b = 0; b < LatencyHistogram::BUCKET_COUNT - 1; b++) {
+    uint64_t upper = LatencyHistogram::bucketUpperBound(b);
+    uint64_t next = LatencyHistogram::bucketUpperBound(b + 1);
+
+    contiguous = contiguous && LatencyHistogram::bucketIndex(upper) == b &&
+                 LatencyHistogram::bucketIndex(upper + 1) == b + 1;
+    if (b + 1 >= LatencyHistogram::SUB_BUCKET_COUNT)
+      narrow = narrow &&
+               (next - upper) * LatencyHistogram::SUB_BUCKET_HALF <= upper + 1;
+  }
+  ok = report("buckets are contiguous", contiguous) && ok;
+  ok = report("buckets are within 1.6% of their latencies", narrow) && ok;
+
+  uint64_t largest =
+      LatencyHistogram::bucketUpperBound(LatencyHistogram::BUCKET_COUNT - 1);
+  return report("the largest bucket ends after 9 hours",
+                largest == (1ull << 45) - 1 &&
+                    largest > 9ull * 3600 * 1000000000) &&
+         ok;
+}
+
+/**
+ * @brief Whether a percentile is the bucket bound of the expected latency
+ */
+static bool bounds(LatencyHistogram &histogram, double p, ns expected) {
+  ns found = histogram.percentile(p);
+  return found >= expected && (found - expected) * 64 <= expected;
+}
+
+static bool checkPercentiles() {
+  LatencyHistogram histogram;
+
+  // 1us to 10ms in steps of 1us, recorded in an order unlike the buckets
+  for (int i = 0; i < 10000; i++)
+    histogram.record(std::chrono::microseconds(1 + (i * 7919) % 10000));
+
+  bool ok = report("count, mean and max are exact",
+                   histogram.count() == 10000 &&
+                       histogram.mean() == ns(5000500) &&
+                       histogram.max() == std::chrono::milliseconds(10));
+
+  ok = report("p50, p90, p99 and p99.9 are within their bucket",
+              bounds(histogram, 50, std::chrono::microseconds(5000)) &&
+                  bounds(histogram, 90, std::chrono::microseconds(9000)) &&
+                  bounds(histogram, 99, std::chrono::microseconds(9900)) &&
+                  bounds(histogram, 99.9, std::chrono::microseconds(9990))) &&
+       ok;
+
+  ok = report("p0 is the fastest and p100 the slowest latency",
+              bounds(histogram, 0, std::chrono::microseconds(1)) &&
+                  histogram.percentile(100) ==
+                      std::chrono::milliseconds(10)) &&
+       ok;
+
+  histogram.reset();
+  return report("reset empties the histogram",
+                histogram.count() == 0 && histogram.mean() == ns(0) &&
+                    histogram.max() == ns(0) &&
+                    histogram.percentile(50) == ns(0)) &&
+         ok;
+}
+
+static bool checkOutOfRange() {
+  LatencyHistogram negative;
+  negative.record(ns(-5));
+  bool ok = report("a negative latency counts as zero",
+                   negative.count() == 1 && negative.max() == ns(0) &&
+                       negative.percentile(100) == ns(0));
+
+  ns largest(
+      LatencyHistogram::bucketUpperBound(LatencyHistogram::BUCKET_COUNT - 1));
+  ns day = std::chrono::hours(24);
+
+  LatencyHistogram slow;
+  slow.record(std::chrono::milliseconds(1));
+  slow.record(day);
+
+  ok = report("a latency past the largest bucket is clamped to it",
+              LatencyHistogram::bucketIndex(day.count()) ==
+                      LatencyHistogram::BUCKET_COUNT - 1 &&
+                  slow.percentile(100) == largest &&
+                  bounds(slow, 50, std::chrono::milliseconds(1))) &&
+       ok;
+
+  return report("mean and max keep the exact latency",
+                slow.max() == day &&
+                    slow.mean() == (day + std::chrono::milliseconds(1)) / 2) &&
+         ok;
+}
+
+static bool checkScope() {
+  LatencyHistogram histogram;
+
+  {
+    ScopedLatency timer(histogram);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  bool ok = report("a scope records its lifetime",
+                   histogram.count() == 1 &&
+                       histogram.max() >= std::chrono::milliseconds(5));
+
+  {
+    ScopedLatency timer(histogram);
+    timer.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  ok = report("a stopped scope records once, when it was stopped",
+              histogram.count() == 2 &&
+                  histogram.max() < std::chrono::milliseconds(20)) &&
+       ok;
+
+  std::string summary = histogram.summary("stage");
+  return report("the summary names the stage and its count",
+                summary.find("stage") == 0 &&
+                    summary.find("n=2") != std::string::npos) &&
+         ok;
+}
+
+int main() {
+  bool failed = false;
+
+  if (!checkBuckets()) {
+    fprintf(stderr, "Latencies were counted in the wrong buckets\n");
+    failed = true;
+  }
+
+  if (!checkPercentiles()) {
+    fprintf(stderr, "Percentiles did not match the recorded latencies\n");
+    failed = true;
+  }
+
+  if (!checkOutOfRange()) {
+    fprintf(stderr, "Latencies out of range were not clamped\n");
+    failed = true;
+  }
+
+  if (!checkScope()) {
+    fprintf(stderr, "Scopes were timed wrong\n");
+    failed = true;
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file	layer_profiler_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks the LayerProfiler with reported layer times
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LayerProfiler.h"
+
+using namespace jetson_tensorrt;
+
+static bool report(const char *check, bool passed) {
+  printf("%s: %s\n", check, passed ? "ok" : "FAILED");
+  return passed;
+}
+
+static bool near(float value, float expected) {
+  return std::fabs(value - expected) < 1e-3f;
+}
+
+static bool checkAccumulation() {
+  LayerProfiler profiler;
+
+  // Reported like TensorRT does, every layer once per execution
+  for (int e = 1; e <= 100; e++) {
+    profiler.reportLayerTime("conv1", (float)e);
+    profiler.reportLayerTime("relu1", 0.5f);
+  }
+
+  std::vector<LayerStats> stats = profiler.stats();
+  bool ok = report("layers are kept in the order they were first reported",
+                   stats.size() == 2 && stats[0].name == "conv1" &&
+                       stats[1].name == "relu1");
+  if (!ok)
+    return false;
+
+  ok = report("the times of a layer accumulate",
+              stats[0].count == 100 && near(stats[0].mean, 50.5f) &&
+                  near(stats[0].p50, 51.0f) && near(stats[0].p99, 99.0f) &&
+                  stats[1].count == 100 && near(stats[1].mean, 0.5f) &&
+                  near(stats[1].p99, 0.5f)) &&
+       ok;
+
+  std::string table = profiler.report();
+  ok = report("the report lists every layer and the total",
+              table.find("conv1") != std::string::npos &&
+                  table.find("relu1") != std::string::npos &&
+                  table.find("51.000") != std::string::npos &&
+                  table.find("Total") != std::string::npos) &&
+       ok;
+
+  std::vector<std::thread> contexts;
+  for (int c = 0; c < 4; c++)
+    contexts.push_back(std::thread([&profiler]() {
+      for (int e = 0; e < 1000; e++)
+        profiler.reportLayerTime("conv1", 1.0f);
+    }));
+  for (int c = 0; c < contexts.size(); c++)
+    contexts[c].join();
+
+  return report("every context's times are counted",
+                profiler.stats()[0].count == 4100) &&
+         ok;
+}
+
+static bool checkWindow() {
+  LayerProfiler profiler(10);
+
+  for (int e = 1; e <= 25; e++)
+    profiler.reportLayerTime("conv1", (float)e);
+
+  std::vector<LayerStats> stats = profiler.stats();
+  return report("statistics only cover the latest window of times",
+                stats.size() == 1 && stats[0].count == 25 &&
+                    near(stats[0].mean, 20.5f) && near(stats[0].p50, 21.0f) &&
+                    near(stats[0].p99, 25.0f));
+}
+
+static bool checkReset() {
+  LayerProfiler profiler;
+
+  profiler.reportLayerTime("conv1", 4.0f);
+  profiler.reportLayerTime("relu1", 1.0f);
+  profiler.reset();
+
+  bool ok = report("reset forgets every layer",
+                   profiler.stats().empty() && profiler.report().empty());
+
+  profiler.reportLayerTime("relu1", 2.0f);
+
+  std::vector<LayerStats> stats = profiler.stats();
+  return report("times after a reset start over",
+                stats.size() == 1 && stats[0].name == "relu1" &&
+                    stats[0].count == 1 && near(stats[0].mean, 2.0f)) &&
+         ok;
+}
+
+int main() {
+  bool failed = false;
+
+  if (!checkAccumulation()) {
+    fprintf(stderr, "Layer times were not accumulated\n");
+    failed = true;
+  }
+
+  if (!checkWindow()) {
+    fprintf(stderr, "Old layer times were not dropped\n");
+    failed = true;
+  }
+
+  if (!checkReset()) {
+    fprintf(stderr, "Layer times survived a reset\n");
+    failed = true;
+  }
+
+  return failed ? 1 : 0;
+}
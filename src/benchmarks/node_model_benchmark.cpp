@@ -0,0 +1,195 @@
+/**
+ * @file	node_model_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks batching and draining the models of the nodes
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../nodes/node_model.h"
+#include "MockBackend.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Engine with a small fixed network which runs on a MockBackend that
+ * takes the same time for every batch, like a GPU which is not saturated
+ */
+class BenchmarkEngine : public TensorRTEngine {
+public:
+  BenchmarkEngine(size_t maxBatchSize, std::chrono::microseconds latency) {
+    addInput("data", nvinfer1::DimsCHW(3, 8, 8), sizeof(float));
+
+    nvinfer1::Dims outputDims;
+    outputDims.nbDims = 1;
+    outputDims.d[0] = 10;
+    addOutput("prob", outputDims, sizeof(float));
+
+    attachBackend(new MockBackend(networkInputs, networkOutputs, latency),
+                  maxBatchSize);
+  }
+
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+};
+
+/**
+ * @brief Runs frames of several cameras through the buffers and scheduler
+ * of a node model, the way the nodes batch their cameras
+ * @return Number of frames whose outputs were wrong
+ */
+static int checkCameras(int cameras, int frames) {
+  NodeModel<BenchmarkEngine> model;
+  model.engine = new BenchmarkEngine(cameras, std::chrono::microseconds(500));
+  model.allocate(cameras, std::chrono::milliseconds(2));
+
+  if (model.scheduler == nullptr)
+    return cameras * frames;
+
+  BenchmarkEngine reference(1, std::chrono::microseconds(0));
+  size_t inputSize = reference.networkInputs[0].size();
+  size_t outputSize = reference.networkOutputs[0].size();
+
+  std::atomic<int> wrong(0);
+  std::vector<std::thread> threads;
+
+  for (int c = 0; c < cameras; c++)
+    threads.push_back(std::thread([&, c]() {
+      CameraPath &camera = *model.cameras[c];
+      LocatedExecutionMemory inputs =
+          reference.allocInputs(MemoryLocation::HOST);
+      LocatedExecutionMemory outputs =
+          reference.allocOutputs(MemoryLocation::HOST);
+
+      // Stands in for the pipeline output of the camera
+      std::vector<unsigned char> frameInput(inputSize);
+
+      for (int f = 0; f < frames; f++) {
+        for (size_t b = 0; b < inputSize; b++)
+          frameInput[b] = (unsigned char)((c * frames + f) * 7 + b);
+
+        LocatedExecutionMemory frame = model.frameInput(&frameInput[0]);
+        model.scheduler->submit(frame[0], camera.output[0]).get();
+
+        memcpy(inputs[0][0], &frameInput[0], inputSize);
+        reference.predict(inputs, outputs);
+
+        if (memcmp(outputs[0][0], camera.output[0][0], outputSize) != 0)
+          wrong++;
+      }
+
+      inputs.release();
+      outputs.release();
+    }));
+
+  for (int c = 0; c < threads.size(); c++)
+    threads[c].join();
+
+  printf("cameras: %d cameras, %d frames in %zu batches\n", cameras,
+         cameras * frames, model.scheduler->batches());
+
+  return wrong;
+}
+
+/**
+ * @brief Stands in for a model and notes the thread it is destroyed on
+ */
+struct DrainedModel {
+  ~DrainedModel() { destroyedOn = std::this_thread::get_id(); }
+
+  static std::thread::id destroyedOn;
+};
+
+std::thread::id DrainedModel::destroyedOn;
+
+/**
+ * @brief Swaps out a model while a frame still holds it, which has to be
+ * handed back once the frame drops it and be destroyed by the swapping
+ * thread
+ */
+static bool checkDrain() {
+  ModelDrain<DrainedModel> drain;
+  std::shared_ptr<DrainedModel> model = drain.track(new DrainedModel());
+
+  std::chrono::steady_clock::time_point dropped;
+  std::thread frame(
+      [&dropped](std::shared_ptr<DrainedModel> held) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        dropped = std::chrono::steady_clock::now();
+        held.reset();
+      },
+      model);
+
+  std::chrono::steady_clock::time_point drained;
+  std::unique_ptr<DrainedModel> released = drain.drain(model, drained);
+  frame.join();
+
+  bool handedBack = released != nullptr && drained >= dropped;
+  released.reset();
+  bool destroyedHere = DrainedModel::destroyedOn == std::this_thread::get_id();
+
+  // Models which are not drained are deleted with their last reference
+  drain.track(new DrainedModel());
+
+  printf("drain: %s after the frame dropped it, destroyed on the %s thread\n",
+         handedBack ? "handed back" : "not handed back",
+         destroyedHere ? "swapping" : "frame");
+
+  return handedBack && destroyedHere;
+}
+
+int main(int argc, char **argv) {
+  int cameras = argc > 1 ? std::atoi(argv[1]) : 4;
+  int frames = argc > 2 ? std::atoi(argv[2]) : 50;
+  if (cameras <= 1 || frames <= 0) {
+    fprintf(stderr, "Usage: %s [cameras > 1 [frames per camera]]\n", argv[0]);
+    return 1;
+  }
+
+  int wrongFrames = checkCameras(cameras, frames);
+  if (wrongFrames > 0) {
+    fprintf(stderr, "%d of %d camera frames got outputs of another frame\n",
+            wrongFrames, cameras * frames);
+    return 1;
+  }
+
+  if (!checkDrain()) {
+    fprintf(stderr, "Swapped out model was not drained\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * @file	predict_async_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks TensorRTEngine::predictAsync() against a MockBackend
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MockBackend.h"
+#include "RegisteredBindings.h"
+#include "TensorRTEngine.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Engine with a small fixed network which runs on a MockBackend, with
+ * access to the mock to hold back or fail its stream
+ */
+class BenchmarkEngine : public TensorRTEngine {
+public:
+  BenchmarkEngine(size_t contexts) {
+    addInput("data", nvinfer1::DimsCHW(3, 8, 8), sizeof(float));
+
+    nvinfer1::Dims outputDims;
+    outputDims.nbDims = 1;
+    outputDims.d[0] = 10;
+    addOutput("prob", outputDims, sizeof(float));
+
+    mock = new MockBackend(networkInputs, networkOutputs);
+    setContextPoolSize(contexts);
+    attachBackend(mock, 1);
+  }
+
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+
+  MockBackend *mock;
+};
+
+/**
+ * @brief Inputs and outputs of one request together with the outputs a
+ * synchronous predict() gives for them
+ */
+struct Request {
+  Request(BenchmarkEngine &engine, BenchmarkEngine &reference, int seed) {
+    inputs = engine.allocInputs(MemoryLocation::HOST);
+    outputs = engine.allocOutputs(MemoryLocation::HOST);
+
+    size_t inputSize = engine.networkInputs[0].size();
+    for (size_t b = 0; b < inputSize; b++)
+      ((unsigned char *)inputs[0][0])[b] = (unsigned char)(seed * 131 + b);
+
+    LocatedExecutionMemory expectedOutputs =
+        reference.allocOutputs(MemoryLocation::HOST);
+    reference.predict(inputs, expectedOutputs);
+
+    size_t outputSize = engine.networkOutputs[0].size();
+    expected.assign((unsigned char *)expectedOutputs[0][0],
+                    (unsigned char *)expectedOutputs[0][0] + outputSize);
+  }
+
+  bool done() {
+    return memcmp(outputs[0][0], &expected[0], expected.size()) == 0;
+  }
+
+  LocatedExecutionMemory inputs, outputs;
+  std::vector<unsigned char> expected;
+};
+
+/**
+ * @brief Keeps the worker of a mock busy until opened, so everything
+ * enqueued meanwhile is still pending
+ */
+struct Gate {
+  Gate(MockBackend *mock) {
+    std::shared_future<void> opened = open.get_future().share();
+    mock->submit([opened]() { opened.wait(); });
+  }
+
+  ~Gate() { release(); }
+
+  void release() {
+    if (!released)
+      open.set_value();
+    released = true;
+  }
+
+  std::promise<void> open;
+  bool released = false;
+};
+
+/**
+ * @brief Enqueues requests through both callback overloads on one stream
+ * while the stream is held back, which have to complete and call back in
+ * the order they were enqueued
+ */
+static bool checkOrder(BenchmarkEngine &reference) {
+  const int count = 3;
+  BenchmarkEngine engine(count);
+
+  std::vector<Request *> requests;
+  for (int r = 0; r < count; r++)
+    requests.push_back(new Request(engine, reference, r));
+
+  std::mutex calledMutex;
+  std::vector<int> called;
+  bool complete = true;
+
+  auto callback = [&](int r) -> std::function<void(cudaError_t)> {
+    return [&, r](cudaError_t status) {
+      std::lock_guard<std::mutex> lock(calledMutex);
+      called.push_back(r);
+      complete = complete && status == cudaSuccess && requests[r]->done();
+    };
+  };
+
+  RegisteredBindings *registered =
+      engine.registerBindings(requests[count - 1]->inputs,
+                              requests[count - 1]->outputs);
+  {
+    Gate gate(engine.mock);
+
+    for (int r = 0; r < count - 1; r++)
+      engine.predictAsync(requests[r]->inputs, requests[r]->outputs, 0,
+                          callback(r));
+    engine.predictAsync(*registered, 0, callback(count - 1));
+
+    std::lock_guard<std::mutex> lock(calledMutex);
+    if (!called.empty())
+      complete = false;
+  }
+  engine.mock->synchronize();
+
+  bool ordered = called.size() == count;
+  for (int r = 0; r < called.size(); r++)
+    ordered = ordered && called[r] == r;
+
+  printf("order: %zu of %d callbacks, %s\n", called.size(), count,
+         ordered ? "in enqueue order" : "out of order");
+
+  delete registered;
+  for (int r = 0; r < count; r++)
+    delete requests[r];
+
+  return ordered && complete;
+}
+
+/**
+ * @brief The future of a request must not be ready before the stream ran it
+ */
+static bool checkPending(BenchmarkEngine &reference) {
+  BenchmarkEngine engine(1);
+  Request request(engine, reference, 7);
+
+  Gate gate(engine.mock);
+  std::future<void> done =
+      engine.predictAsync(request.inputs, request.outputs, 0);
+
+  bool pending = done.wait_for(std::chrono::milliseconds(20)) ==
+                 std::future_status::timeout;
+
+  gate.release();
+  done.get();
+
+  printf("pending: future %s before the stream ran\n",
+         pending ? "not ready" : "ready");
+
+  return pending && request.done();
+}
+
+/**
+ * @brief A failing stream has to reach the future and the callbacks as an
+ * error and still return the context to the pool
+ */
+static bool checkError(BenchmarkEngine &reference) {
+  BenchmarkEngine engine(1);
+  Request request(engine, reference, 11);
+  engine.mock->callbackStatus = cudaErrorUnknown;
+
+  bool futureFailed = false;
+  try {
+    engine.predictAsync(request.inputs, request.outputs, 0).get();
+  } catch (std::runtime_error &e) {
+    futureFailed = true;
+  }
+
+  std::promise<cudaError_t> status;
+  engine.predictAsync(
+      request.inputs, request.outputs, 0,
+      [&status](cudaError_t error) { status.set_value(error); });
+  bool callbackFailed = status.get_future().get() == cudaErrorUnknown;
+
+  // Hangs if a failed request kept its context
+  engine.mock->callbackStatus = cudaSuccess;
+  engine.predict(request.inputs, request.outputs);
+
+  printf("error: future %s, callback %s\n",
+         futureFailed ? "failed" : "succeeded",
+         callbackFailed ? "got the error" : "got no error");
+
+  return futureFailed && callbackFailed && request.done();
+}
+
+int main() {
+  BenchmarkEngine reference(1);
+  bool failed = false;
+
+  if (!checkOrder(reference)) {
+    fprintf(stderr, "Requests on one stream did not complete in order\n");
+    failed = true;
+  }
+
+  if (!checkPending(reference)) {
+    fprintf(stderr, "Future was ready before the stream ran the request\n");
+    failed = true;
+  }
+
+  if (!checkError(reference)) {
+    fprintf(stderr, "Stream error did not reach the future or callback\n");
+    failed = true;
+  }
+
+  return failed ? 1 : 0;
+}
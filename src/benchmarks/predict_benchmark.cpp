@@ -0,0 +1,141 @@
+/**
+ * @file	predict_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Measures the per call overhead of TensorRTEngine::predict()
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "MockBackend.h"
+#include "RegisteredBindings.h"
+#include "TensorRTEngine.h"
+
+using namespace jetson_tensorrt;
+
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+  allocations++;
+
+  void *memory = malloc(size);
+  if (!memory)
+    throw std::bad_alloc();
+
+  return memory;
+}
+
+void operator delete(void *memory) noexcept { free(memory); }
+
+/**
+ * @brief Engine with a small fixed network which runs on a MockBackend, so
+ * the time measured is the bookkeeping of predict() instead of inference
+ */
+class BenchmarkEngine : public TensorRTEngine {
+public:
+  BenchmarkEngine() {
+    addInput("data", nvinfer1::DimsCHW(3, 8, 8), sizeof(float));
+
+    nvinfer1::Dims outputDims;
+    outputDims.nbDims = 1;
+    outputDims.d[0] = 10;
+    addOutput("prob", outputDims, sizeof(float));
+
+    attachBackend(new MockBackend(networkInputs, networkOutputs), 1);
+  }
+
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+};
+
+struct BenchmarkResult {
+  double nanosPerCall;
+  double allocationsPerCall;
+};
+
+template <typename Predict>
+static BenchmarkResult measure(int iterations, Predict predict) {
+  // Warm up so lazily grown containers reach their steady state size
+  for (int i = 0; i < iterations / 10 + 1; i++)
+    predict();
+
+  size_t allocationsBefore = allocations;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  for (int i = 0; i < iterations; i++)
+    predict();
+
+  std::chrono::nanoseconds elapsed = std::chrono::duration_cast<
+      std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  BenchmarkResult result;
+  result.nanosPerCall = (double)elapsed.count() / iterations;
+  result.allocationsPerCall =
+      (double)(allocations - allocationsBefore) / iterations;
+  return result;
+}
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+  if (iterations <= 0) {
+    fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  BenchmarkEngine engine;
+
+  LocatedExecutionMemory inputs = engine.allocInputs(MemoryLocation::HOST);
+  LocatedExecutionMemory outputs = engine.allocOutputs(MemoryLocation::HOST);
+
+  BenchmarkResult perCall = measure(
+      iterations, [&engine, &inputs, &outputs]() {
+        engine.predict(inputs, outputs);
+      });
+
+  RegisteredBindings *registered = engine.registerBindings(inputs, outputs);
+
+  BenchmarkResult perRegistered = measure(
+      iterations, [&engine, registered]() { engine.predict(*registered); });
+
+  printf("%-24s %12s %16s\n", "path", "ns/call", "allocations/call");
+  printf("%-24s %12.1f %16.2f\n", "predict(inputs, outputs)",
+         perCall.nanosPerCall, perCall.allocationsPerCall);
+  printf("%-24s %12.1f %16.2f\n", "predict(registered)",
+         perRegistered.nanosPerCall, perRegistered.allocationsPerCall);
+
+  delete registered;
+  inputs.release();
+  outputs.release();
+
+  return 0;
+}
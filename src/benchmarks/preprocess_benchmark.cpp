@@ -0,0 +1,278 @@
+/**
+ * @file	preprocess_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Benchmarks the ImageNet preprocessing pipelines
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "CUDACommon.h"
+#include "CUDAPipeNodes.h"
+#include "CUDAPipeline.h"
+#include "PreprocessReference.h"
+#include "cudaResize.h"
+
+using namespace jetson_tensorrt;
+
+static const int OUTPUT_WIDTH = 224;
+static const int OUTPUT_HEIGHT = 224;
+
+/**
+ * @brief The preprocessing before it was fused, which converts the whole
+ * frame to RGBAf and then samples the network input from it
+ */
+static CUDAPipeline *createTwoPassPipeline(CUDAPipeNode *toRGBAf,
+                                           int inputWidth, int inputHeight,
+                                           float3 mean,
+                                           cudaFilterMode filter) {
+  CUDAPipeline *pipe = new CUDAPipeline();
+  pipe->addNode(new ToDevicePTRNode());
+  pipe->addNode(toRGBAf);
+  pipe->addNode(new RGBAfToImageNetNode(inputWidth, inputHeight, OUTPUT_WIDTH,
+                                        OUTPUT_HEIGHT, mean, filter));
+  return pipe;
+}
+
+template <typename Preprocess>
+static double measure(int iterations, Preprocess preprocess) {
+  for (int i = 0; i < iterations / 10 + 1; i++)
+    preprocess();
+  cudaDeviceSynchronize();
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  for (int i = 0; i < iterations; i++)
+    preprocess();
+  cudaDeviceSynchronize();
+
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         iterations;
+}
+
+/**
+ * @brief Runs a pipeline on a device frame
+ * @return The time per frame in microseconds, with the output copied into
+ * a host buffer of the planar network input
+ */
+static double measurePipeline(CUDAPipeline *pipeline, void *deviceFrame,
+                              size_t frameSize, int iterations,
+                              std::vector<float> &output) {
+  CUDAPipeIO input(MemoryLocation::DEVICE, deviceFrame, frameSize);
+  CUDAPipeIO result(MemoryLocation::DEVICE);
+
+  double micros = measure(iterations, [pipeline, &input, &result]() {
+    result = pipeline->pipe(input);
+  });
+
+  cudaError_t copyError =
+      cudaMemcpy(&output[0], result.data, output.size() * sizeof(float),
+                 cudaMemcpyDeviceToHost);
+  if (copyError != cudaSuccess)
+    throw std::runtime_error("Unable to copy the pipeline output. CUDA "
+                             "Error: " +
+                             std::to_string(copyError));
+
+  return micros;
+}
+
+static float maxError(std::vector<float> &output,
+                      std::vector<float> &reference) {
+  float error = 0;
+  for (size_t i = 0; i < reference.size(); i++)
+    error = std::max(error, std::fabs(output[i] - reference[i]));
+  return error;
+}
+
+/**
+ * @brief Compares and times the preprocessing paths with one filter
+ * @return Whether every path matches its reference
+ */
+static bool benchmarkFilter(cudaFilterMode filter, int width, int height,
+                            int iterations, std::vector<uchar3> &frame,
+                            void *deviceFrame,
+                            std::vector<unsigned char> &nv12Frame,
+                            void *deviceNV12Frame) {
+  float3 mean = make_float3(104.0f, 117.0f, 123.0f);
+  size_t frameSize = frame.size() * sizeof(uchar3);
+  size_t nv12Size = nv12Frame.size();
+
+  size_t outputCount = 3 * OUTPUT_WIDTH * OUTPUT_HEIGHT;
+  std::vector<float> reference(outputCount), twoPass(outputCount),
+      fused(outputCount);
+
+  double referenceMicros = measure(iterations / 10 + 1, [&]() {
+    referencePreImageNetRGB(&frame[0], width, height, &reference[0],
+                            OUTPUT_WIDTH, OUTPUT_HEIGHT, mean, filter);
+  });
+
+  CUDAPipeline *twoPassPipeline = createTwoPassPipeline(
+      new RGBToRGBAfNode(width, height), width, height, mean, filter);
+  double twoPassMicros = measurePipeline(twoPassPipeline, deviceFrame,
+                                         frameSize, iterations, twoPass);
+
+  CUDAPipeline *fusedPipeline = CUDAPipeline::createRGBImageNetPipeline(
+      width, height, OUTPUT_WIDTH, OUTPUT_HEIGHT, mean, filter);
+  double fusedMicros = measurePipeline(fusedPipeline, deviceFrame, frameSize,
+                                       iterations, fused);
+
+  float twoPassError = maxError(twoPass, reference);
+  float fusedError = maxError(fused, reference);
+
+  // The fused NV12 kernel is compared with the two pass pipeline as there is
+  // no CPU reference
+  std::vector<float> nv12TwoPass(outputCount), nv12Fused(outputCount);
+
+  CUDAPipeline *nv12TwoPassPipeline = createTwoPassPipeline(
+      new NV12toRGBAfNode(width, height), width, height, mean, filter);
+  double nv12TwoPassMicros =
+      measurePipeline(nv12TwoPassPipeline, deviceNV12Frame, nv12Size,
+                      iterations, nv12TwoPass);
+
+  CUDAPipeline *nv12FusedPipeline = CUDAPipeline::createNV12ImageNetPipeline(
+      width, height, OUTPUT_WIDTH, OUTPUT_HEIGHT, mean, filter);
+  double nv12FusedMicros = measurePipeline(
+      nv12FusedPipeline, deviceNV12Frame, nv12Size, iterations, nv12Fused);
+
+  float nv12Error = maxError(nv12Fused, nv12TwoPass);
+
+  // cudaResizeRGBA of the RGBAf frame against the CPU resize
+  std::vector<float> rgbaf(frame.size() * 4);
+  for (size_t i = 0; i < frame.size(); i++) {
+    rgbaf[i * 4 + 0] = frame[i].x;
+    rgbaf[i * 4 + 1] = frame[i].y;
+    rgbaf[i * 4 + 2] = frame[i].z;
+    rgbaf[i * 4 + 3] = 255.0f;
+  }
+
+  size_t resizedCount = 4 * OUTPUT_WIDTH * OUTPUT_HEIGHT;
+  std::vector<float> resizeReference(resizedCount), resized(resizedCount);
+  referenceResize(&rgbaf[0], width, height, 4, &resizeReference[0],
+                  OUTPUT_WIDTH, OUTPUT_HEIGHT, filter);
+
+  float4 *deviceRGBAf =
+      (float4 *)safeCudaMalloc(rgbaf.size() * sizeof(float));
+  float4 *deviceResized =
+      (float4 *)safeCudaMalloc(resizedCount * sizeof(float));
+  cudaMemcpy(deviceRGBAf, &rgbaf[0], rgbaf.size() * sizeof(float),
+             cudaMemcpyHostToDevice);
+
+  double resizeMicros = measure(iterations, [&]() {
+    cudaResizeRGBA(deviceRGBAf, width, height, deviceResized, OUTPUT_WIDTH,
+                   OUTPUT_HEIGHT, filter);
+  });
+  cudaMemcpy(&resized[0], deviceResized, resizedCount * sizeof(float),
+             cudaMemcpyDeviceToHost);
+
+  float resizeError = maxError(resized, resizeReference);
+
+  std::string name = cudaFilterModeToStr(filter);
+  printf("%-28s %12.1f %12.1f %12s\n", (name + " cpu reference").c_str(),
+         referenceMicros, 1e6 / referenceMicros, "-");
+  printf("%-28s %12.1f %12.1f %12g\n", (name + " rgbaf + imagenet").c_str(),
+         twoPassMicros, 1e6 / twoPassMicros, twoPassError);
+  printf("%-28s %12.1f %12.1f %12g\n", (name + " fused").c_str(),
+         fusedMicros, 1e6 / fusedMicros, fusedError);
+  printf("%-28s %12.1f %12.1f %12s\n",
+         (name + " nv12 rgbaf + imagenet").c_str(), nv12TwoPassMicros,
+         1e6 / nv12TwoPassMicros, "-");
+  printf("%-28s %12.1f %12.1f %12g\n", (name + " nv12 fused").c_str(),
+         nv12FusedMicros, 1e6 / nv12FusedMicros, nv12Error);
+  printf("%-28s %12.1f %12.1f %12g\n", (name + " resize rgbaf").c_str(),
+         resizeMicros, 1e6 / resizeMicros, resizeError);
+
+  if (filter == FILTER_POINT)
+    printf("\nRGB8 pipeline fusions:\n%s\nNV12 pipeline fusions:\n%s\n\n",
+           fusedPipeline->fusionReport().c_str(),
+           nv12FusedPipeline->fusionReport().c_str());
+
+  delete twoPassPipeline;
+  delete fusedPipeline;
+  delete nv12TwoPassPipeline;
+  delete nv12FusedPipeline;
+  cudaFree(deviceRGBAf);
+  cudaFree(deviceResized);
+
+  // Point sampling reads the same pixels with the same arithmetic as the CPU.
+  // Interpolating filters sum in a different order, and the NV12 kernels may
+  // contract the color conversion into different FMAs.
+  float tolerance = filter == FILTER_POINT ? 0.0f : 1e-3f;
+  return twoPassError <= tolerance && fusedError <= tolerance &&
+         resizeError <= tolerance && nv12Error <= 1e-3f;
+}
+
+int main(int argc, char **argv) {
+  int width = argc > 2 ? std::atoi(argv[1]) : 1280;
+  int height = argc > 2 ? std::atoi(argv[2]) : 720;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 1000;
+  if (width <= 0 || height <= 0 || iterations <= 0) {
+    fprintf(stderr, "Usage: %s [width height [iterations]]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<uchar3> frame(width * height);
+  srand(0);
+  for (size_t i = 0; i < frame.size(); i++)
+    frame[i] = make_uchar3(rand() % 256, rand() % 256, rand() % 256);
+
+  size_t frameSize = frame.size() * sizeof(uchar3);
+  void *deviceFrame = safeCudaMalloc(frameSize);
+  cudaMemcpy(deviceFrame, &frame[0], frameSize, cudaMemcpyHostToDevice);
+
+  // NV12 frames of the same size
+  size_t nv12Size = width * height * 3 / 2;
+  std::vector<unsigned char> nv12Frame(nv12Size);
+  for (size_t i = 0; i < nv12Frame.size(); i++)
+    nv12Frame[i] = rand() % 256;
+
+  void *deviceNV12Frame = safeCudaMalloc(nv12Size);
+  cudaMemcpy(deviceNV12Frame, &nv12Frame[0], nv12Size, cudaMemcpyHostToDevice);
+
+  printf("%dx%d frames to %dx%d planar BGR\n", width, height, OUTPUT_WIDTH,
+         OUTPUT_HEIGHT);
+  printf("%-28s %12s %12s %12s\n", "path", "us/frame", "frames/s",
+         "max error");
+
+  const cudaFilterMode filters[] = {FILTER_POINT, FILTER_LINEAR, FILTER_AREA};
+  bool matches = true;
+  for (cudaFilterMode filter : filters)
+    matches &= benchmarkFilter(filter, width, height, iterations, frame,
+                               deviceFrame, nv12Frame, deviceNV12Frame);
+
+  cudaFree(deviceFrame);
+  cudaFree(deviceNV12Frame);
+
+  if (!matches) {
+    fprintf(stderr, "Preprocessing does not match its reference\n");
+    return 1;
+  }
+
+  return 0;
+}
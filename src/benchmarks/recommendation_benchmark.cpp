@@ -0,0 +1,188 @@
+/**
+ * @file	recommendation_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Runs an autotune recommendation through the frame path of the nodes
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../nodes/node_model.h"
+#include "Autotuner.h"
+#include "LatencyHistogram.h"
+#include "MockBackend.h"
+#include "TuningReport.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Engine with a small fixed network which runs on a MockBackend, so
+ * the recommendation can be checked without a GPU
+ */
+class MockNodeEngine : public TensorRTEngine {
+public:
+  MockNodeEngine(size_t maxBatchSize) {
+    addInput("data", nvinfer1::DimsCHW(3, 8, 8), sizeof(float));
+
+    nvinfer1::Dims outputDims;
+    outputDims.nbDims = 1;
+    outputDims.d[0] = 10;
+    addOutput("prob", outputDims, sizeof(float));
+
+    attachBackend(new MockBackend(networkInputs, networkOutputs),
+                  maxBatchSize);
+  }
+
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+};
+
+/**
+ * @brief Reads the parameters of a recommendation the way rosparam loads
+ * them, one "name: value" line each
+ */
+static std::map<std::string, long> readParams(std::string path) {
+  std::map<std::string, long> params;
+  std::ifstream in(path.c_str());
+
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t colon = line.find(':');
+    if (line.empty() || line[0] == '#' || colon == std::string::npos)
+      continue;
+
+    params[line.substr(0, colon)] = std::atol(line.c_str() + colon + 1);
+  }
+
+  return params;
+}
+
+int main(int argc, char **argv) {
+  std::string prefix = argc > 1 ? argv[1] : "recommendation";
+  int frames = argc > 2 ? std::atoi(argv[2]) : 1000;
+  if (frames <= 0) {
+    fprintf(stderr, "Usage: %s [report prefix [frames]]\n", argv[0]);
+    return 1;
+  }
+
+  // Larger batches have the higher throughput on the mock, so the
+  // recommendation is built for a batch the nodes never run
+  Autotuner tuner(
+      [](const TuningConfig &config) -> TensorRTEngine * {
+        return new MockNodeEngine(config.batchSize);
+      },
+      2, 20, MemoryLocation::HOST);
+
+  std::vector<nvinfer1::DataType> dataTypes(1, nvinfer1::DataType::kFLOAT);
+  std::vector<size_t> workspaces(1, 1 << 20);
+  std::vector<size_t> batchSizes;
+  for (size_t batchSize = 1; batchSize <= 8; batchSize *= 2)
+    batchSizes.push_back(batchSize);
+
+  TuningReport report(tuner.sweep(
+      Autotuner::combinations(dataTypes, workspaces, batchSizes)));
+  report.save(prefix);
+
+  std::map<std::string, long> params = readParams(prefix + ".yaml");
+  if (params.count("data_type") == 0 ||
+      params.count("max_network_size_mb") == 0 ||
+      params.count("max_batch_size") == 0) {
+    fprintf(stderr, "%s.yaml is missing node parameters\n", prefix.c_str());
+    return 1;
+  }
+
+  long maxBatchSize = params["max_batch_size"];
+  printf("Recommended data_type %ld, max_network_size_mb %ld, "
+         "max_batch_size %ld\n",
+         params["data_type"], params["max_network_size_mb"], maxBatchSize);
+
+  // Frames are preprocessed into a buffer of their own and run one at a time
+  // through an engine built for the recommended batch size
+  NodeModel<MockNodeEngine> model;
+  model.engine = new MockNodeEngine(maxBatchSize);
+  MockNodeEngine reference(1);
+
+  size_t inputSize = model.engine->networkInputs[0].size();
+  size_t outputSize = model.engine->networkOutputs[0].size();
+
+  LocatedExecutionMemory referenceInputs =
+      reference.allocInputs(MemoryLocation::HOST);
+  LocatedExecutionMemory referenceOutputs =
+      reference.allocOutputs(MemoryLocation::HOST);
+
+  LatencyHistogram latencies;
+  int mismatches = 0;
+
+  try {
+    // A single camera, so frames are not batched
+    model.allocate(1, std::chrono::microseconds(0));
+    CameraPath &camera = *model.cameras[0];
+
+    std::vector<unsigned char> pipelineOutput(inputSize);
+
+    for (int f = 0; f < frames; f++) {
+      for (size_t b = 0; b < inputSize; b++)
+        pipelineOutput[b] = (unsigned char)(f * 31 + b);
+
+      std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      RegisteredBindings &bindings =
+          model.bindFrame(camera, &pipelineOutput[0]);
+      model.engine->predict(bindings);
+      latencies.record(std::chrono::steady_clock::now() - start);
+
+      memcpy(referenceInputs[0][0], &pipelineOutput[0], inputSize);
+      reference.predict(referenceInputs, referenceOutputs);
+
+      if (memcmp(camera.output[0][0], referenceOutputs[0][0], outputSize) != 0)
+        mismatches++;
+    }
+  } catch (std::exception &e) {
+    fprintf(stderr, "Frame path failed: %s\n", e.what());
+    return 1;
+  }
+
+  printf("%s\n", latencies.summary("frame").c_str());
+
+  referenceInputs.release();
+  referenceOutputs.release();
+
+  if (mismatches > 0) {
+    fprintf(stderr, "%d of %d frames differ from a batch 1 prediction\n",
+            mismatches, frames);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file	staging_pool_benchmark.cpp
+ * @author	Carroll Vance
+ * @brief	Checks the StagingPool with host memory
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <thread>
+
+#include "HostAllocator.h"
+#include "StagingPool.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Pageable host memory which counts the allocations of a pool
+ */
+struct CountingAllocator : public PageableHostAllocator {
+  CountingAllocator() {
+    allocations = 0;
+    deallocations = 0;
+  }
+
+  void *allocate(size_t size) {
+    allocations++;
+    return PageableHostAllocator::allocate(size);
+  }
+
+  void deallocate(void *data) {
+    if (data)
+      deallocations++;
+    PageableHostAllocator::deallocate(data);
+  }
+
+  int allocations, deallocations;
+};
+
+static bool report(const char *check, bool passed) {
+  printf("%s: %s\n", check, passed ? "ok" : "FAILED");
+  return passed;
+}
+
+static bool checkReuse() {
+  CountingAllocator allocator;
+  bool ok;
+
+  {
+    StagingPool pool(&allocator, 1);
+
+    StagingBuffer *first = pool.tryAcquire(100);
+    memset(first->data, 7, 100);
+    void *data = first->data;
+    pool.release(first);
+
+    StagingBuffer *second = pool.tryAcquire(100);
+    ok = report("a released buffer is reused with its contents",
+                second == first && second->data == data &&
+                    ((unsigned char *)second->data)[99] == 7 &&
+                    allocator.allocations == 1);
+    pool.release(second);
+
+    StagingBuffer *smaller = pool.tryAcquire(50);
+    ok = report("a smaller frame keeps the buffer",
+                smaller->data == data && smaller->capacity == 100 &&
+                    smaller->size == 50 && allocator.allocations == 1) &&
+         ok;
+    pool.release(smaller);
+
+    StagingBuffer *larger = pool.tryAcquire(200);
+    ok = report("a larger frame grows the buffer",
+                larger->capacity == 200 && larger->size == 200 &&
+                    allocator.allocations == 2 &&
+                    allocator.deallocations == 1) &&
+         ok;
+    pool.release(larger);
+  }
+
+  return report("the pool frees its buffers",
+                allocator.deallocations == allocator.allocations) &&
+         ok;
+}
+
+static bool checkExhaustion() {
+  PageableHostAllocator allocator;
+  StagingPool pool(&allocator, 2, 64);
+
+  StagingBuffer *first = pool.tryAcquire(64);
+  StagingBuffer *second = pool.tryAcquire(64);
+  bool ok = report("an exhausted pool hands out nothing without blocking",
+                   pool.tryAcquire(64) == NULL && pool.available() == 0);
+
+  std::atomic<bool> acquired(false);
+  std::future<StagingBuffer *> waiting =
+      std::async(std::launch::async, [&pool, &acquired]() {
+        StagingBuffer *buffer = pool.acquire(64);
+        acquired = true;
+        return buffer;
+      });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ok = report("acquire blocks while every buffer is in use", !acquired) && ok;
+
+  pool.release(second);
+  StagingBuffer *third = waiting.get();
+  ok = report("acquire returns the released buffer",
+              third == second && pool.available() == 0) &&
+       ok;
+
+  pool.release(first);
+  pool.release(third);
+
+  return report("every buffer is available again", pool.available() == 2) &&
+         ok;
+}
+
+static bool checkOrder() {
+  PageableHostAllocator allocator;
+  StagingPool pool(&allocator, 3, 64);
+
+  StagingBuffer *a = pool.tryAcquire(64);
+  StagingBuffer *b = pool.tryAcquire(64);
+  StagingBuffer *c = pool.tryAcquire(64);
+  bool ok = report("buffers are first handed out in pool order",
+                   a->index == 0 && b->index == 1 && c->index == 2);
+
+  pool.release(b);
+  pool.release(a);
+  pool.release(c);
+
+  StagingBuffer *first = pool.tryAcquire(64);
+  StagingBuffer *second = pool.tryAcquire(64);
+  StagingBuffer *third = pool.tryAcquire(64);
+  ok = report("the most recently released buffer is handed out first",
+              first == c && second == a && third == b) &&
+       ok;
+
+  pool.release(first);
+  pool.release(second);
+  pool.release(third);
+
+  return ok;
+}
+
+int main() {
+  bool failed = false;
+
+  if (!checkReuse()) {
+    fprintf(stderr, "Staging buffers were not reused\n");
+    failed = true;
+  }
+
+  if (!checkExhaustion()) {
+    fprintf(stderr, "An exhausted pool did not wait for a release\n");
+    failed = true;
+  }
+
+  if (!checkOrder()) {
+    fprintf(stderr, "Staging buffers were handed out in the wrong order\n");
+    failed = true;
+  }
+
+  return failed ? 1 : 0;
+}
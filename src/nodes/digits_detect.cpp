@@ -27,65 +27,120 @@
 #include "digits_detect.h"
 #include "utility.h"
 
+#include <cstring>
+
 namespace jetson_tensorrt {
 
-void ROSDIGITSDetector::imageCallback(const sensor_msgs::Image::ConstPtr &msg) {
+void ROSDIGITSDetector::imageCallback(const sensor_msgs::Image::ConstPtr &msg,
+                                      int camera) {
 
-  /* 0. Initialize */
-  if (engine == nullptr) {
+  /* 0. Wait for the engine */
+  if (!engine_ready) {
+    dropped_frames++;
+    ROS_WARN_THROTTLE(5, "Model is still loading, dropped %lu frames",
+                      (unsigned long)dropped_frames);
+    return;
+  }
 
-    ROS_INFO("Loading nVidia DIGITS model (this can take a while)...");
+  unsigned long dropped = dropped_frames.exchange(0);
+  if (dropped > 0)
+    ROS_INFO("Dropped %lu frames while the model was loading", dropped);
 
-    nvinfer1::DataType d_type;
+  // The uploader copies the frame into a page-locked buffer on its helper
+  // thread and uploads it while the previous frame is still being processed
+  size_t size = msg->height * msg->step;
+  std::shared_ptr<const void> source(msg.get(), [msg](const void *) {});
 
-    engine = new DIGITSDetector(model_path, weights_path, cache_path,
-                                model_image_depth, model_image_width,
-                                model_image_height, model_stride,
-                                model_num_classes, data_type);
-    ROS_INFO("Done loading nVidia DIGITS model!");
+  bool staged = uploaders[camera]->submit(
+      size,
+      [msg, size](void *staging) { memcpy(staging, &msg->data[0], size); },
+      source);
 
-    tensor_input = engine->allocInputs(MemoryLocation::DEVICE, true);
-    tensor_output = engine->allocOutputs(MemoryLocation::UNIFIED);
-
-    if (msg->encoding.compare(sensor_msgs::image_encodings::RGB8) == 0) {
-      preprocessPipeline = CUDAPipeline::createRGBImageNetPipeline(
-          msg->width, msg->height, model_image_width, model_image_height,
-          make_float3(mean_1, mean_2, mean_3));
-    } else if (msg->encoding.compare(sensor_msgs::image_encodings::YUV422) ==
-               0) {
-      // TODO: Implement YUV422 preprocess pipeline
-      ROS_ERROR("Unsupported image encoding: %s", msg->encoding.c_str());
-      return;
-    } else {
-      ROS_ERROR("Unsupported image encoding: %s", msg->encoding.c_str());
-      return;
+  if (!staged) {
+    ROS_WARN_THROTTLE(5, "Dropped a frame, all %d staging buffers are in use",
+                      staging_buffers);
+
+    if (reloading)
+      reload_dropped_frames++;
+  }
+}
+
+void ROSDIGITSDetector::processFrames(int camera) {
+  while (true) {
+    UploadedFrame *frame = NULL;
+
+    try {
+      frame = uploaders[camera]->next();
+      if (frame == NULL)
+        break;
+
+      // The model is held until the frame is done, so a reload swapping in
+      // a new version never releases it under the frame
+      std::shared_ptr<Model> active = activeModel();
+
+      const sensor_msgs::Image *msg =
+          static_cast<const sensor_msgs::Image *>(frame->source.get());
+      processFrame(*active, camera, *msg, frame->device);
+
+      frame_latency.record(std::chrono::steady_clock::now() -
+                           frame->submitted);
+    } catch (std::exception &e) {
+      ROS_ERROR("Unable to process frame: %s", e.what());
     }
 
-    // Statistics
-    start_t = std::chrono::system_clock::now();
-    frames = 0;
+    if (frame != NULL)
+      uploaders[camera]->release(frame);
+  }
+}
+
+void ROSDIGITSDetector::processFrame(Model &active, int camera,
+                                     const sensor_msgs::Image &msg,
+                                     void *frame_data, bool publish) {
+  CameraPath &path = *active.cameras[camera];
+
+  // The pipeline is created from the configured image params, so it is only
+  // rebuilt when the camera sends something else
+  if (path.pipeline == nullptr || (int)msg.width != path.image_width ||
+      (int)msg.height != path.image_height ||
+      msg.encoding != path.image_encoding) {
+
+    if (!createPipeline(active, camera, msg.width, msg.height, msg.encoding))
+      return;
   }
 
   /* 1. Preprocess */
-  CUDAPipeIO input = CUDAPipeIO(MemoryLocation::HOST, (void *)&msg->data[0],
-                                (size_t)(msg->height * msg->step));
+  ScopedLatency preprocess_timer(publish ? preprocess_latency
+                                          : warmup_preprocess_latency);
 
-  CUDAPipeIO output = preprocessPipeline->pipe(input);
+  CUDAPipeIO input = CUDAPipeIO(MemoryLocation::DEVICE, frame_data,
+                                (size_t)(msg.height * msg.step));
 
-  tensor_input.batch[0][0] = output.data;
+  CUDAPipeIO output = path.pipeline->pipe(input);
+
+  preprocess_timer.stop();
 
   /* 2. Inference */
-  std::vector<RTClassifiedRegionOfInterest> regions =
-      engine->detect(tensor_input, tensor_output, threshold);
+  std::vector<RTClassifiedRegionOfInterest> regions;
+  ImageTransform transform = path.pipeline->getTransform();
+
+  if (active.scheduler != nullptr) {
+    // Batched with the frames the other cameras sent meanwhile
+    LocatedExecutionMemory frame = active.frameInput(output.data);
+    regions = active.engine->detect(*active.scheduler, frame, path.output,
+                                    threshold, transform);
+  } else {
+    regions = active.engine->detect(active.bindFrame(path, output.data),
+                                    threshold, transform);
+  }
 
   /* 3. Publish */
+  ScopedLatency message_timer(publish ? message_latency
+                                       : warmup_message_latency);
+
   ClassifiedRegionsOfInterest msg_regions;
 
   msg_regions.header.stamp = ros::Time::now();
 
-  float x_scale = (float)msg->width / (float)model_image_width;
-  float y_scale = (float)msg->height / (float)model_image_height;
-
   for (std::vector<RTClassifiedRegionOfInterest>::iterator it = regions.begin();
        it != regions.end(); ++it) {
 
@@ -94,32 +149,443 @@ void ROSDIGITSDetector::imageCallback(const sensor_msgs::Image::ConstPtr &msg) {
 
       region.id = it->id;
       region.confidence = it->confidence;
-      region.x = (int)(it->x * x_scale);
-      region.y = (int)(it->y * y_scale);
-      region.w = (int)(it->w * x_scale);
-      region.h = (int)(it->h * y_scale);
+      region.x = it->x;
+      region.y = it->y;
+      region.w = it->w;
+      region.h = it->h;
 
-      if (it->id < classes.size())
-        region.desc = classes[it->id];
+      if (it->id < active.classes.size())
+        region.desc = active.classes[it->id];
       else
         region.desc = "";
 
       msg_regions.regions.push_back(region);
     }
   }
-  region_pub.publish(msg_regions);
+  message_timer.stop();
+
+  if (!publish)
+    return;
+
+  ScopedLatency publish_timer(publish_latency);
+  region_pubs[camera].publish(msg_regions);
+}
+
+void ROSDIGITSDetector::warmUp(Model &loaded) {
+  if (warmup_iterations <= 0)
+    return;
+
+  for (int camera = 0; camera < loaded.cameras.size(); camera++) {
+    CameraPath &path = *loaded.cameras[camera];
+    if (path.pipeline == nullptr)
+      continue;
+
+    // A black frame in the format the pipeline was created for, run through
+    // the same path as camera frames apart from publishing
+    sensor_msgs::Image frame;
+    frame.width = path.image_width;
+    frame.height = path.image_height;
+    frame.encoding = path.image_encoding;
+    frame.step = frame.width *
+                 sensor_msgs::image_encodings::numChannels(frame.encoding) *
+                 (sensor_msgs::image_encodings::bitDepth(frame.encoding) / 8);
+
+    MemoryArena frame_data(MemoryLocation::DEVICE, frame.height * frame.step);
+    cudaMemset(frame_data.data(), 0, frame_data.size());
+
+    warm_up(warmup_iterations, [this, &loaded, camera, &frame, &frame_data]() {
+      processFrame(loaded, camera, frame, frame_data.data(), false);
+    });
+  }
+}
+
+void ROSDIGITSDetector::openBundle(ros::NodeHandle &nh_private) {
+  try {
+    bundle = new EngineBundle(bundle_path);
+  } catch (std::exception &e) {
+    ROS_ERROR("Unable to open engine bundle: %s", e.what());
+    return;
+  }
+
+  // The bundle describes the model, so it replaces the model params
+  if (bundle->inputs.size() == 1 && bundle->inputs[0].dims.nbDims == 3 &&
+      bundle->outputs.size() == 2) {
+    NetworkOutput &output = bundle->outputs[0];
+    model_image_depth = bundle->inputs[0].dims.d[0];
+    model_image_height = bundle->inputs[0].dims.d[1];
+    model_image_width = bundle->inputs[0].dims.d[2];
+    model_num_classes = output.dims.d[0];
+    if (output.dims.nbDims == 3 && output.dims.d[1] > 0)
+      model_stride = model_image_height / output.dims.d[1];
+  }
+
+  data_type = bundle->dataType;
+  max_batch_size = bundle->maxBatchSize;
+
+  mean_1 = bundle->mean[0];
+  mean_2 = bundle->mean[1];
+  mean_3 = bundle->mean[2];
+
+  if (!bundle->classes.empty())
+    classes = bundle->classes;
+
+  // Cameras configured by the launch file still take precedence
+  if (!nh_private.hasParam("image_encoding"))
+    image_encoding = bundle->encoding;
+
+  if (bundle->channelOrder != "BGR")
+    ROS_WARN("Engine bundle expects %s input, but frames are converted to BGR",
+             bundle->channelOrder.c_str());
+}
+
+void ROSDIGITSDetector::saveBundle(Model &loaded) {
+  EngineBundle description;
+  description.classes = loaded.classes;
+  description.mean[0] = loaded.mean.x;
+  description.mean[1] = loaded.mean.y;
+  description.mean[2] = loaded.mean.z;
+  description.encoding = loaded.cameras[0]->image_encoding;
+
+  try {
+    loaded.engine->saveBundle(save_bundle, description);
+    ROS_INFO("Saved engine bundle to %s", save_bundle.c_str());
+  } catch (std::exception &e) {
+    ROS_ERROR("Unable to save engine bundle: %s", e.what());
+  }
+}
+
+void ROSDIGITSDetector::prepareModel(Model &loaded) {
+  if (!shared_workspace.empty())
+    loaded.engine->shareWorkspace(SharedWorkspace::named(shared_workspace));
+
+  // Every context runs a batch of its own
+  loaded.engine->setContextPoolSize(context_pool_size);
+  loaded.allocate(image_subscribe_topics.size(),
+                  std::chrono::microseconds((long)(batch_max_wait_ms * 1000)),
+                  context_pool_size);
+
+  for (int camera = 0; camera < loaded.cameras.size(); camera++) {
+    int width, height;
+    std::string encoding;
+    {
+      std::lock_guard<std::mutex> lock(pipeline_mutex);
+      width = camera_widths[camera];
+      height = camera_heights[camera];
+      encoding = camera_encodings[camera];
+    }
+
+    createPipeline(loaded, camera, width, height, encoding);
+  }
+
+  warmUp(loaded);
+
+  // Frames start with clean statistics of the new engine and pipelines
+  resetModelLatencies(loaded);
+
+  if (profile_interval > 0)
+    loaded.engine->enableProfiling();
+}
+
+void ROSDIGITSDetector::loadEngine() {
+  // Shared with the engine, which builds networks of other batch sizes with it
+  std::shared_ptr<PipelineCalibrator> calibrator;
+  std::shared_ptr<Model> loaded = model_drain.track(new Model());
+
+  loaded->mean = make_float3(mean_1, mean_2, mean_3);
+  loaded->classes = classes;
+  loaded->version = initial_version;
+
+  try {
+    if (data_type == nvinfer1::DataType::kINT8 && bundle_path.empty()) {
+      // Calibration images get the same preprocessing as camera frames
+      float3 mean = loaded->mean;
+      int width = model_image_width, height = model_image_height;
+      cudaFilterMode filter = filter_mode;
+      bool fit = letterbox;
+      float3 padding = letterboxPadding(mean);
+      PipelineFactory pipeline_factory =
+          [width, height, mean, filter, fit,
+           padding](int w, int h) -> CUDAPipeline * {
+        if (fit)
+          return CUDAPipeline::createRGBLetterboxPipeline(
+              w, h, width, height, mean, padding, filter);
+        return CUDAPipeline::createRGBImageNetPipeline(w, h, width, height,
+                                                       mean, filter);
+      };
+
+      calibrator.reset(new PipelineCalibrator(
+          open_calibration_images(calibration_images, image_width,
+                                  image_height),
+          pipeline_factory,
+          NetworkInput(DIGITSDetector::INPUT_NAME,
+                       nvinfer1::DimsCHW(model_image_depth, model_image_height,
+                                         model_image_width),
+                       sizeof(float)),
+          calibration_batch_size, calibration_table, calibration_batches));
+    }
+
+    ROS_INFO("Loading nVidia DIGITS model (this can take a while)...");
+    if (!bundle_path.empty()) {
+      if (bundle == nullptr)
+        throw std::runtime_error("Engine bundle " + bundle_path +
+                                 " could not be opened");
+
+      loaded->engine = new DIGITSDetector(*bundle);
+
+      // The network has been deserialized, so the file can be unmapped
+      delete bundle;
+      bundle = nullptr;
+    } else {
+      loaded->engine = new DIGITSDetector(
+          model_path, weights_path, cache_dir, model_image_depth,
+          model_image_width, model_image_height, model_stride,
+          model_num_classes, data_type, (size_t)max_network_size_mb << 20,
+          EngineCache::DEFAULT_MAX_ENTRIES, calibrator, max_batch_size);
+    }
+
+    // Networks for smaller batches come from the same engine cache
+    if (!batch_sizes.empty())
+      set_batch_sizes(*loaded->engine, batch_sizes);
+    ROS_INFO("Done loading nVidia DIGITS model!");
+
+    prepareModel(*loaded);
+
+    if (bundle_path.empty() && !save_bundle.empty())
+      saveBundle(*loaded);
+
+    // Camera frames start with clean statistics
+    resetLatencies(*loaded);
+
+    {
+      std::lock_guard<std::mutex> lock(model_mutex);
+      model = loaded;
+    }
+
+    engine_ready = true;
+  } catch (std::exception &e) {
+    ROS_ERROR("Unable to load nVidia DIGITS model: %s", e.what());
+  }
 
-  frames++;
-  if (frames > 0 && frames % 10 == 0) {
-    ROS_DEBUG("%f FPS",
-              (1000 * (float)frames) /
-                  std::chrono::duration_cast<std::chrono::milliseconds>(
-                      std::chrono::system_clock::now() - start_t)
-                      .count());
+}
 
-    start_t = std::chrono::system_clock::now();
-    frames = 0;
+void ROSDIGITSDetector::reloadModel(int version) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::shared_ptr<Model> loaded = model_drain.track(new Model());
+
+  try {
+    EngineBundle next(repository->bundlePath(model_name, version));
+
+    loaded->engine = new DIGITSDetector(next);
+    loaded->mean = make_float3(next.mean[0], next.mean[1], next.mean[2]);
+    loaded->classes = next.classes.empty() ? classes : next.classes;
+    loaded->version = version;
+
+    // Allocated and warmed up while the old version keeps running
+    prepareModel(*loaded);
+  } catch (std::exception &e) {
+    ROS_ERROR("Unable to load version %d of %s: %s", version,
+              model_name.c_str(), e.what());
+    failed_version = version;
+    reloading = false;
+    return;
   }
+
+  double load_time =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  // Frames pick the model up one at a time, so swapping it between two
+  // frames only exchanges the pointer
+  std::chrono::steady_clock::time_point swap_start =
+      std::chrono::steady_clock::now();
+  std::shared_ptr<Model> retired;
+  {
+    std::lock_guard<std::mutex> lock(model_mutex);
+    retired = model;
+    model = loaded;
+  }
+  std::chrono::steady_clock::time_point swapped =
+      std::chrono::steady_clock::now();
+
+  // The frame in flight still holds the old version, which is handed back
+  // once it is done
+  std::chrono::steady_clock::time_point drained;
+  std::unique_ptr<Model> released = model_drain.drain(retired, drained);
+
+  int retired_version = released->version;
+  released.reset();
+
+  ROS_INFO("Swapped version %d of %s for version %d: loaded in %.1f s, "
+           "swapped in %.1f us, drained in %.1f ms, %lu frames dropped",
+           retired_version, model_name.c_str(), version, load_time,
+           std::chrono::duration<double, std::micro>(swapped - swap_start)
+               .count(),
+           std::chrono::duration<double, std::milli>(drained - swapped)
+               .count(),
+           (unsigned long)reload_dropped_frames);
+
+  reloading = false;
+}
+
+std::shared_ptr<ROSDIGITSDetector::Model> ROSDIGITSDetector::activeModel() {
+  std::lock_guard<std::mutex> lock(model_mutex);
+  return model;
+}
+
+void ROSDIGITSDetector::repositoryCallback(const ros::WallTimerEvent &event) {
+  if (!engine_ready || reloading)
+    return;
+
+  int latest = repository->latestVersion(model_name);
+
+  // Removing the newest version rolls back to the one before it
+  if (latest == 0 || latest == activeModel()->version ||
+      latest == failed_version)
+    return;
+
+  ROS_INFO("Loading version %d of %s", latest, model_name.c_str());
+
+  if (model_reloader.joinable())
+    model_reloader.join();
+
+  reload_dropped_frames = 0;
+  reloading = true;
+  model_reloader = std::thread(&ROSDIGITSDetector::reloadModel, this, latest);
+}
+
+void ROSDIGITSDetector::profileCallback(const ros::WallTimerEvent &event) {
+  if (!engine_ready)
+    return;
+
+  std::string report = activeModel()->engine->getProfiler()->report();
+  if (!report.empty())
+    ROS_INFO("Layer timings:\n%s", report.c_str());
+}
+
+void ROSDIGITSDetector::latencyCallback(const ros::WallTimerEvent &event) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - report_start).count();
+  report_start = now;
+
+  if (!engine_ready || frame_latency.count() == 0)
+    return;
+
+  std::shared_ptr<Model> active = activeModel();
+
+  std::string report;
+  for (int camera = 0; camera < uploaders.size(); camera++)
+    report += uploaders[camera]->stagingLatency.summary(
+                  camera_name("staging", camera, uploaders.size(), " ")) +
+              "\n";
+
+  report += preprocess_latency.summary("preprocess") + "\n";
+
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    for (int camera = 0; camera < active->cameras.size(); camera++) {
+      CUDAPipeline *pipeline = active->cameras[camera]->pipeline;
+      if (pipeline == nullptr)
+        continue;
+
+      for (int node = 0; node < pipeline->nodeLatencies.size(); node++) {
+        std::string name =
+            camera_name(std::string("  ") + pipeline->nodes[node]->getName(),
+                        camera, active->cameras.size(), " ");
+        report += pipeline->nodeLatencies[node]->summary(name) + "\n";
+      }
+    }
+  }
+
+  report += active->engine->inferenceLatency.summary("inference") + "\n";
+  report += active->engine->suppressionLatency.summary("suppression") + "\n";
+  report += message_latency.summary("message") + "\n";
+  report += publish_latency.summary("publish") + "\n";
+  report += frame_latency.summary("frame");
+
+  ROS_INFO("Latencies over the last %.1f s (%.1f FPS):\n%s", elapsed,
+           frame_latency.count() / elapsed, report.c_str());
+
+  resetLatencies(*active);
+}
+
+void ROSDIGITSDetector::resetLatencies(Model &active) {
+  resetModelLatencies(active);
+
+  for (int camera = 0; camera < uploaders.size(); camera++)
+    uploaders[camera]->stagingLatency.reset();
+  preprocess_latency.reset();
+  message_latency.reset();
+  publish_latency.reset();
+  frame_latency.reset();
+}
+
+void ROSDIGITSDetector::resetModelLatencies(Model &target) {
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    for (int camera = 0; camera < target.cameras.size(); camera++) {
+      CUDAPipeline *pipeline = target.cameras[camera]->pipeline;
+      if (pipeline != nullptr)
+        for (int node = 0; node < pipeline->nodeLatencies.size(); node++)
+          pipeline->nodeLatencies[node]->reset();
+    }
+  }
+
+  target.engine->inferenceLatency.reset();
+  target.engine->suppressionLatency.reset();
+}
+
+float3 ROSDIGITSDetector::letterboxPadding(float3 mean) {
+  // Padding with the mean feeds the network zeros
+  if (letterbox_padding < 0)
+    return mean;
+
+  return make_float3(letterbox_padding, letterbox_padding, letterbox_padding);
+}
+
+bool ROSDIGITSDetector::createPipeline(Model &target, int camera, int width,
+                                       int height, std::string encoding) {
+  std::lock_guard<std::mutex> lock(pipeline_mutex);
+  CameraPath &path = *target.cameras[camera];
+
+  // Bindings point into the output buffer of the old pipeline
+  delete path.bindings;
+  path.bindings = nullptr;
+
+  delete path.pipeline;
+  path.pipeline = nullptr;
+
+  path.image_width = camera_widths[camera] = width;
+  path.image_height = camera_heights[camera] = height;
+  path.image_encoding = camera_encodings[camera] = encoding;
+
+  if (encoding.compare(sensor_msgs::image_encodings::RGB8) == 0 &&
+      letterbox) {
+    path.pipeline = CUDAPipeline::createRGBLetterboxPipeline(
+        width, height, target.engine->modelWidth, target.engine->modelHeight,
+        target.mean, letterboxPadding(target.mean), filter_mode);
+  } else if (encoding.compare(sensor_msgs::image_encodings::RGB8) == 0) {
+    path.pipeline = CUDAPipeline::createRGBImageNetPipeline(
+        width, height, target.engine->modelWidth, target.engine->modelHeight,
+        target.mean, filter_mode);
+  } else if (encoding.compare(sensor_msgs::image_encodings::YUV422) == 0) {
+    // TODO: Implement YUV422 preprocess pipeline
+    ROS_ERROR("Unsupported image encoding: %s", encoding.c_str());
+    return false;
+  } else {
+    ROS_ERROR("Unsupported image encoding: %s", encoding.c_str());
+    return false;
+  }
+
+  if (latency_report_interval > 0)
+    path.pipeline->enableTiming();
+
+  std::string fusions = path.pipeline->fusionReport();
+  if (!fusions.empty())
+    ROS_INFO("Preprocessing for %dx%d %s frames fused:\n%s", width, height,
+             encoding.c_str(), fusions.c_str());
+
+  return true;
 }
 
 ROSDIGITSDetector::ROSDIGITSDetector(ros::NodeHandle nh,
@@ -131,17 +597,24 @@ ROSDIGITSDetector::ROSDIGITSDetector(ros::NodeHandle nh,
                    package_path + std::string("/networks/detectnet.prototxt"));
   nh_private.param("weights_path", weights_path,
                    package_path + std::string("/networks/ped-100.caffemodel"));
-  nh_private.param("cache_path", cache_path,
-                   package_path +
-                       std::string("/networks/detection.tensorcache"));
+  nh_private.param("cache_dir", cache_dir,
+                   package_path + std::string("/networks/tensorcache"));
+  nh_private.param("bundle_path", bundle_path, std::string(""));
+  nh_private.param("save_bundle", save_bundle, std::string(""));
+  nh_private.param("model_repository", model_repository, std::string(""));
+  nh_private.param("model_name", model_name, std::string("detect"));
+  nh_private.param("repository_poll_interval", repository_poll_interval,
+                   5.0);
   nh_private.param("classes_path", classes_path,
                    package_path +
                        std::string("/networks/pedestrian_classes.txt"));
 
   ROS_DEBUG("model_path: %s", model_path.c_str());
   ROS_DEBUG("weights_path: %s", weights_path.c_str());
-  ROS_DEBUG("cache_path: %s", cache_path.c_str());
+  ROS_DEBUG("cache_dir: %s", cache_dir.c_str());
   ROS_DEBUG("classes_path: %s", classes_path.c_str());
+  ROS_DEBUG("bundle_path: %s", bundle_path.c_str());
+  ROS_DEBUG("model_repository: %s", model_repository.c_str());
 
   classes = load_class_descriptions(classes_path);
 
@@ -160,6 +633,17 @@ ROSDIGITSDetector::ROSDIGITSDetector(ros::NodeHandle nh,
   nh_private.param("mean2", mean_2, 0.0);
   nh_private.param("mean3", mean_3, 0.0);
 
+  std::string filter_name;
+  nh_private.param("filter_mode", filter_name, std::string("point"));
+  filter_mode = cudaFilterModeFromStr(filter_name.c_str(), FILTER_POINT);
+
+  // Unknown names give back whichever default is passed
+  if (filter_mode != cudaFilterModeFromStr(filter_name.c_str(), FILTER_AREA))
+    ROS_INFO("Invalid filter_mode: %s, using point", filter_name.c_str());
+
+  nh_private.param("letterbox", letterbox, false);
+  nh_private.param("letterbox_padding", letterbox_padding, -1.0);
+
   int d_type;
   nh_private.param("data_type", d_type, 32);
 
@@ -179,22 +663,151 @@ ROSDIGITSDetector::ROSDIGITSDetector(ros::NodeHandle nh,
     break;
   }
 
+  nh_private.param("max_network_size_mb", max_network_size_mb, 1024);
+  nh_private.param("max_batch_size", max_batch_size, 1);
+  nh_private.param("batch_max_wait_ms", batch_max_wait_ms, 5.0);
+  nh_private.param("batch_sizes", batch_sizes, std::vector<int>());
+  nh_private.param("context_pool_size", context_pool_size, 1);
+  if (context_pool_size < 1) {
+    ROS_WARN("context_pool_size %d is less than 1, using 1", context_pool_size);
+    context_pool_size = 1;
+  }
+
+  nh_private.param("warmup_iterations", warmup_iterations, 10);
+
+  nh_private.param("calibration_images", calibration_images,
+                   std::string(""));
+  nh_private.param("calibration_table", calibration_table,
+                   package_path +
+                       std::string("/networks/detection.calibration"));
+  nh_private.param("calibration_batch_size", calibration_batch_size, 8);
+  nh_private.param("calibration_batches", calibration_batches, 0);
+
   nh_private.param("threshold", threshold, (float)0.2);
 
   nh_private.param("image_subscribe_topic", image_subscribe_topic,
                    std::string("/csi_cam/image_raw"));
 
-  ROS_DEBUG("image_subscribe_topic: %s", image_subscribe_topic.c_str());
+  // Several cameras replace the single topic and share one engine
+  nh_private.param("image_subscribe_topics", image_subscribe_topics,
+                   std::vector<std::string>());
+  if (image_subscribe_topics.empty())
+    image_subscribe_topics.push_back(image_subscribe_topic);
+
+  for (int camera = 0; camera < image_subscribe_topics.size(); camera++)
+    ROS_DEBUG("image_subscribe_topic %d: %s", camera,
+              image_subscribe_topics[camera].c_str());
+
+  // A batch holds at most one frame of every camera, so building for larger
+  // batches would only cost memory and build time
+  int nb_cameras = image_subscribe_topics.size();
+  if (max_batch_size < 1 || max_batch_size > nb_cameras) {
+    ROS_WARN("max_batch_size %d does not match the %d subscribed cameras, "
+             "using %d",
+             max_batch_size, nb_cameras, nb_cameras);
+    max_batch_size = nb_cameras;
+  }
+
+  nh_private.param("image_width", image_width, 1280);
+  nh_private.param("image_height", image_height, 720);
+  nh_private.param("image_encoding", image_encoding,
+                   sensor_msgs::image_encodings::RGB8);
+
+  nh_private.param("staging_buffers", staging_buffers,
+                   (int)FrameUploader::DEFAULT_BUFFERS);
+  nh_private.param("shared_workspace", shared_workspace, std::string(""));
+  nh_private.param("profile_interval", profile_interval, 0.0);
+  nh_private.param("latency_report_interval", latency_report_interval, 10.0);
+
+  // The newest version in the repository replaces bundle_path
+  initial_version = failed_version = 0;
+  if (!model_repository.empty()) {
+    repository = new ModelRepository(model_repository);
+    initial_version = repository->latestVersion(model_name);
+
+    if (initial_version > 0)
+      bundle_path = repository->bundlePath(model_name, initial_version);
+    else
+      ROS_WARN("Model repository %s has no versions of %s yet",
+               model_repository.c_str(), model_name.c_str());
+  }
+
+  if (!bundle_path.empty())
+    openBundle(nh_private);
+
+  if (profile_interval > 0)
+    profile_timer =
+        nh.createWallTimer(ros::WallDuration(profile_interval),
+                           &ROSDIGITSDetector::profileCallback, this);
+
+  if (latency_report_interval > 0)
+    latency_timer =
+        nh.createWallTimer(ros::WallDuration(latency_report_interval),
+                           &ROSDIGITSDetector::latencyCallback, this);
+
+  if (repository != nullptr && repository_poll_interval > 0)
+    repository_timer =
+        nh.createWallTimer(ros::WallDuration(repository_poll_interval),
+                           &ROSDIGITSDetector::repositoryCallback, this);
+
+  // Statistics
+  report_start = std::chrono::steady_clock::now();
+  dropped_frames = 0;
+  reload_dropped_frames = 0;
+  reloading = false;
+  engine_ready = false;
+
+  for (int camera = 0; camera < nb_cameras; camera++) {
+    camera_widths.push_back(image_width);
+    camera_heights.push_back(image_height);
+    camera_encodings.push_back(image_encoding);
+
+    uploaders.push_back(new FrameUploader(&staging_allocator, staging_buffers));
+
+    region_pubs.push_back(
+        nh_private.advertise<jetson_tensorrt::ClassifiedRegionsOfInterest>(
+            camera_name("detections", camera, nb_cameras, "_"), 5));
+  }
 
-  image_sub = nh.subscribe<sensor_msgs::Image>(
-      image_subscribe_topic, 2, &ROSDIGITSDetector::imageCallback, this);
+  // The workers and callbacks index the vectors above, so they only start
+  // once every camera has been added
+  for (int camera = 0; camera < nb_cameras; camera++)
+    frame_workers.push_back(
+        std::thread(&ROSDIGITSDetector::processFrames, this, camera));
 
-  region_pub =
-      nh_private.advertise<jetson_tensorrt::ClassifiedRegionsOfInterest>(
-          "detections", 5);
+  for (int camera = 0; camera < nb_cameras; camera++)
+    image_subs.push_back(nh.subscribe<sensor_msgs::Image>(
+        image_subscribe_topics[camera], 2,
+        boost::bind(&ROSDIGITSDetector::imageCallback, this, _1, camera)));
 
   this->nh = nh;
   this->nh_private = nh_private;
+
+  // Build or load the engine without blocking the subscribers. It resets the
+  // latencies of the uploaders, so it starts once everything else exists.
+  engine_loader = std::thread(&ROSDIGITSDetector::loadEngine, this);
+}
+
+ROSDIGITSDetector::~ROSDIGITSDetector() {
+  repository_timer.stop();
+
+  for (int camera = 0; camera < uploaders.size(); camera++)
+    uploaders[camera]->stop();
+
+  for (int camera = 0; camera < frame_workers.size(); camera++)
+    if (frame_workers[camera].joinable())
+      frame_workers[camera].join();
+
+  if (engine_loader.joinable())
+    engine_loader.join();
+
+  if (model_reloader.joinable())
+    model_reloader.join();
+
+  delete bundle;
+  delete repository;
+  for (int camera = 0; camera < uploaders.size(); camera++)
+    delete uploaders[camera];
 }
 
 } // namespace jetson_tensorrt
@@ -27,8 +27,15 @@
 #ifndef DIGITS_DETECT_H_
 #define DIGITS_DETECT_H_
 
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "boost/bind.hpp"
 #include "cv_bridge/cv_bridge.h"
 #include "jetson_tensorrt/ClassifiedRegionOfInterest.h"
 #include "jetson_tensorrt/ClassifiedRegionsOfInterest.h"
@@ -38,38 +45,115 @@
 #include "sensor_msgs/image_encodings.h"
 
 #include "CUDAPipeline.h"
+#include "EngineBundle.h"
+#include "FrameUploader.h"
+#include "LatencyHistogram.h"
+#include "MemoryArena.h"
+#include "ModelRepository.h"
+#include "PipelineCalibrator.h"
+#include "SharedWorkspace.h"
 #include "DIGITSDetector.h"
+#include "node_model.h"
 
 namespace jetson_tensorrt {
 
 class ROSDIGITSDetector {
 public:
   ROSDIGITSDetector(ros::NodeHandle nh, ros::NodeHandle nh_private);
-  void imageCallback(const sensor_msgs::Image::ConstPtr &msg);
+  ~ROSDIGITSDetector();
+  void imageCallback(const sensor_msgs::Image::ConstPtr &msg, int camera);
+  void profileCallback(const ros::WallTimerEvent &event);
+  void latencyCallback(const ros::WallTimerEvent &event);
+  void repositoryCallback(const ros::WallTimerEvent &event);
 
 private:
-  /* TensorRT */
-  jetson_tensorrt::CUDAPipeline *preprocessPipeline = nullptr;
-  jetson_tensorrt::LocatedExecutionMemory tensor_input, tensor_output;
-  jetson_tensorrt::DIGITSDetector *engine = nullptr;
+  typedef NodeModel<DIGITSDetector> Model;
+
+  void loadEngine();
+  void reloadModel(int version);
+  void prepareModel(Model &loaded);
+  std::shared_ptr<Model> activeModel();
+  void processFrames(int camera);
+  void processFrame(Model &active, int camera, const sensor_msgs::Image &msg,
+                    void *frame_data, bool publish = true);
+  void openBundle(ros::NodeHandle &nh_private);
+  void saveBundle(Model &loaded);
+  void warmUp(Model &loaded);
+  void resetLatencies(Model &active);
+  void resetModelLatencies(Model &target);
+  float3 letterboxPadding(float3 mean);
+  bool createPipeline(Model &target, int camera, int width, int height,
+                      std::string encoding);
+
+  /* TensorRT, the drain outlives every model */
+  ModelDrain<Model> model_drain;
+  std::shared_ptr<Model> model;
+  std::mutex model_mutex;
+  jetson_tensorrt::EngineBundle *bundle = nullptr;
+
+  /* Model repository */
+  jetson_tensorrt::ModelRepository *repository = nullptr;
+  std::thread model_reloader;
+  std::atomic<bool> reloading;
+  std::atomic<unsigned long> reload_dropped_frames;
+  int initial_version, failed_version;
+
+  /* Frame staging, one uploader and worker per camera */
+  jetson_tensorrt::PinnedHostAllocator staging_allocator;
+  std::vector<jetson_tensorrt::FrameUploader *> uploaders;
+  std::vector<std::thread> frame_workers;
+
+  /* Frames keep arriving in the format each camera last sent */
+  std::vector<int> camera_widths, camera_heights;
+  std::vector<std::string> camera_encodings;
+
+  /* Engine loading */
+  std::thread engine_loader;
+  std::atomic<bool> engine_ready;
+  std::atomic<unsigned long> dropped_frames;
 
   /* ROS */
-  ros::Publisher region_pub;
-  ros::Subscriber image_sub;
+  ros::WallTimer profile_timer, latency_timer, repository_timer;
+  std::vector<ros::Publisher> region_pubs;
+  std::vector<ros::Subscriber> image_subs;
 
   std::vector<std::string> classes;
 
   /* Params */
   float threshold;
-  std::string model_path, cache_path, weights_path, classes_path;
-  std::string image_subscribe_topic;
+  std::string model_path, cache_dir, weights_path, classes_path;
+  std::string bundle_path, save_bundle;
+  std::string model_repository, model_name;
+  double repository_poll_interval;
+  std::string image_subscribe_topic, image_encoding;
+  std::vector<std::string> image_subscribe_topics;
+  int image_width, image_height;
+  std::string calibration_images, calibration_table;
+  int calibration_batch_size, calibration_batches;
+  int staging_buffers;
+  std::string shared_workspace;
+  double profile_interval, latency_report_interval;
   nvinfer1::DataType data_type;
+  int max_network_size_mb, max_batch_size;
+  std::vector<int> batch_sizes;
+  int context_pool_size;
+  double batch_max_wait_ms;
+  int warmup_iterations;
   int model_image_depth, model_image_width, model_image_height,
       model_num_classes, model_stride;
   double mean_1, mean_2, mean_3;
+  cudaFilterMode filter_mode;
+  bool letterbox;
+  double letterbox_padding;
+
+  /* Statistics */
+  LatencyHistogram preprocess_latency, message_latency, publish_latency,
+      frame_latency;
 
-  std::chrono::time_point<std::chrono::system_clock> start_t;
-  int frames;
+  /* Stages of warm-up frames, kept out of the camera frame statistics */
+  LatencyHistogram warmup_preprocess_latency, warmup_message_latency;
+  std::chrono::steady_clock::time_point report_start;
+  std::mutex pipeline_mutex;
 
   ros::NodeHandle nh;
   ros::NodeHandle nh_private;
@@ -0,0 +1,252 @@
+/**
+ * @file	node_model.h
+ * @author	Carroll Vance
+ * @brief	Everything a ROS node runs one version of a model with
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NODE_MODEL_H_
+#define NODE_MODEL_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BatchScheduler.h"
+#include "CUDAPipeline.h"
+#include "RegisteredBindings.h"
+#include "TensorRTEngine.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Preprocessing and output buffers of the frames of one camera
+ */
+struct CameraPath {
+  CameraPath() {
+    pipeline = nullptr;
+    bindings = nullptr;
+    image_width = image_height = 0;
+  }
+
+  ~CameraPath() {
+    // Bindings refer to the pipeline output
+    delete bindings;
+    delete pipeline;
+  }
+
+  /* Preprocessing of camera frames into the network input */
+  jetson_tensorrt::CUDAPipeline *pipeline;
+
+  /* Camera frames the pipeline was created for */
+  int image_width, image_height;
+  std::string image_encoding;
+
+  jetson_tensorrt::LocatedExecutionMemory output;
+
+  /* Only used when frames are not batched */
+  jetson_tensorrt::RegisteredBindings *bindings;
+
+private:
+  CameraPath(const CameraPath &) = delete;
+  CameraPath &operator=(const CameraPath &) = delete;
+};
+
+/**
+ * @brief An engine together with the preprocessing, buffers and class labels
+ * of its model. Nodes swap the whole structure when a new version of the
+ * model is loaded, and it is destroyed once no frame uses it anymore.
+ */
+template <typename Engine> struct NodeModel {
+  NodeModel() {
+    engine = nullptr;
+    scheduler = nullptr;
+    mean = make_float3(0, 0, 0);
+    version = 0;
+  }
+
+  ~NodeModel() {
+    // The scheduler runs the engine, and bindings refer to the engine
+    delete scheduler;
+    for (size_t c = 0; c < cameras.size(); c++)
+      delete cameras[c];
+    delete engine;
+  }
+
+  /**
+   * @brief Allocates the buffers frames are run in. The input is left
+   * unallocated because every frame is read straight out of the pipeline
+   * output of its camera.
+   * @usage Frames of several cameras are batched together, the frames of a
+   * single camera are run one at a time
+   * @param nb_cameras Number of cameras
+   * @param max_wait Longest time a frame waits for frames of other cameras
+   * @param nb_workers Number of batches run at once, at most the context
+   * pool size of the engine
+   */
+  void allocate(size_t nb_cameras, std::chrono::microseconds max_wait,
+                size_t nb_workers = 1) {
+    input = engine->allocInputs(MemoryLocation::DEVICE, true);
+
+    for (size_t c = 0; c < nb_cameras; c++) {
+      cameras.push_back(new CameraPath());
+      cameras.back()->output = engine->allocOutputs(MemoryLocation::UNIFIED);
+    }
+
+    if (nb_cameras > 1)
+      scheduler =
+          new BatchScheduler(engine, MemoryLocation::DEVICE,
+                             MemoryLocation::UNIFIED, max_wait, 0, nb_workers);
+  }
+
+  /**
+   * @brief Gets the network input of a single frame
+   * @param frame_input Network input the frame was preprocessed into
+   * @return One record, whatever batch size the engine was built for
+   */
+  LocatedExecutionMemory frameInput(void *frame_input) {
+    LocatedExecutionMemory frame = input.view(1);
+    frame[0][0] = frame_input;
+    return frame;
+  }
+
+  /**
+   * @brief Gets the bindings which run a single frame of a camera
+   * @usage The pipeline always outputs into the same buffer, so the bindings
+   * are only resolved once and kept until the pipeline is replaced
+   * @param camera Camera the frame is from
+   * @param frame_input Network input the frame was preprocessed into
+   * @return The bindings, owned by the camera
+   */
+  RegisteredBindings &bindFrame(CameraPath &camera, void *frame_input) {
+    if (camera.bindings == nullptr) {
+      LocatedExecutionMemory frame = frameInput(frame_input);
+      camera.bindings = engine->registerBindings(frame, camera.output);
+    }
+
+    return *camera.bindings;
+  }
+
+  Engine *engine;
+  float3 mean;
+
+  /* One path per subscribed camera */
+  std::vector<CameraPath *> cameras;
+
+  /* Batches frames of several cameras, NULL for a single camera */
+  jetson_tensorrt::BatchScheduler *scheduler;
+
+  jetson_tensorrt::LocatedExecutionMemory input;
+
+  std::vector<std::string> classes;
+
+  /* Version in the model repository, 0 if not loaded from one */
+  int version;
+
+private:
+  NodeModel(const NodeModel &) = delete;
+  NodeModel &operator=(const NodeModel &) = delete;
+};
+
+/**
+ * @brief Hands a swapped out model back to the thread which swapped it out
+ * once the last frame using it drops its reference. That thread waits
+ * without polling and destroys the model itself instead of the frame thread.
+ */
+template <typename Model> class ModelDrain {
+public:
+  ModelDrain() {
+    retiring = nullptr;
+    drained = nullptr;
+  }
+
+  /**
+   * @brief Shares a newly loaded model
+   * @usage The drain must outlive every reference to the model
+   * @param model The model, owned by the returned pointer
+   * @return The model, which is deleted with its last reference unless it
+   * is being drained
+   */
+  std::shared_ptr<Model> track(Model *model) {
+    return std::shared_ptr<Model>(
+        model, [this](Model *released) { release(released); });
+  }
+
+  /**
+   * @brief Drops a reference to a swapped out model and waits until the
+   * frames still using it have dropped theirs
+   * @param retired The swapped out model, reset here
+   * @param drained_at Set to when the last reference was dropped
+   * @return The model, which nothing refers to anymore
+   */
+  std::unique_ptr<Model>
+  drain(std::shared_ptr<Model> &retired,
+        std::chrono::steady_clock::time_point &drained_at) {
+    std::unique_lock<std::mutex> lock(mutex);
+    retiring = retired.get();
+    lock.unlock();
+
+    retired.reset();
+
+    lock.lock();
+    released.wait(lock, [this]() { return drained != nullptr; });
+
+    std::unique_ptr<Model> model(drained);
+    drained_at = this->drained_at;
+    retiring = nullptr;
+    drained = nullptr;
+
+    return model;
+  }
+
+private:
+  void release(Model *model) {
+    bool handed = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (model == retiring) {
+        drained = model;
+        drained_at = std::chrono::steady_clock::now();
+        handed = true;
+      }
+    }
+
+    if (handed)
+      released.notify_all();
+    else
+      delete model;
+  }
+
+  std::mutex mutex;
+  std::condition_variable released;
+
+  /* The model being drained, and the same model once it was released */
+  Model *retiring, *drained;
+  std::chrono::steady_clock::time_point drained_at;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* NODE_MODEL_H_ */
@@ -24,9 +24,14 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <chrono>
 #include <fstream>
 #include <streambuf>
+#include <sys/stat.h>
 
+#include "ros/ros.h"
+
+#include "LatencyHistogram.h"
 #include "utility.h"
 
 std::vector<std::string> load_class_descriptions(std::string filename) {
@@ -52,3 +57,57 @@ std::vector<std::string> load_class_descriptions(std::string filename) {
 
   return classes;
 }
+
+jetson_tensorrt::ImageSource *open_calibration_images(std::string path,
+                                                      int frame_width,
+                                                      int frame_height) {
+  if (path.empty())
+    return NULL;
+
+  struct stat path_stat;
+  if (stat(path.c_str(), &path_stat) == 0 && S_ISDIR(path_stat.st_mode))
+    return new jetson_tensorrt::PPMDirectorySource(path);
+
+  return new jetson_tensorrt::FrameFileSource(path, frame_width, frame_height);
+}
+
+void warm_up(int iterations, std::function<void()> predict) {
+  jetson_tensorrt::LatencyHistogram latencies;
+  std::chrono::nanoseconds first(0);
+
+  for (int i = 0; i < iterations; i++) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    predict();
+    std::chrono::nanoseconds latency = std::chrono::steady_clock::now() - start;
+
+    if (i == 0)
+      first = latency;
+    latencies.record(latency);
+  }
+
+  ROS_INFO("Warmed up with %d predictions, the first took %.3f ms:\n%s",
+           iterations, first.count() / 1e6,
+           latencies.summary("warm-up").c_str());
+}
+
+void set_batch_sizes(jetson_tensorrt::TensorRTEngine &engine,
+                     std::vector<int> batch_sizes) {
+  std::vector<size_t> sizes;
+  for (size_t b = 0; b < batch_sizes.size(); b++)
+    sizes.push_back(batch_sizes[b] > 0 ? batch_sizes[b] : 0);
+
+  try {
+    engine.setBatchSizes(sizes);
+  } catch (std::exception &e) {
+    ROS_WARN("Ignoring batch_sizes: %s", e.what());
+  }
+}
+
+std::string camera_name(std::string name, int camera, size_t nb_cameras,
+                        std::string separator) {
+  if (nb_cameras <= 1)
+    return name;
+
+  return name + separator + std::to_string(camera);
+}
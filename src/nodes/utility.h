@@ -27,9 +27,55 @@
 #ifndef UTILITY_H_
 #define UTILITY_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
+#include "CalibrationImages.h"
+#include "TensorRTEngine.h"
+
 std::vector<std::string> load_class_descriptions(std::string filename);
 
+/**
+ * @brief Opens INT8 calibration images
+ * @param path A directory of .ppm images or a file of raw RGB8 frames. Empty
+ * if the calibration table already exists.
+ * @param frame_width Width of the frames in a frame file
+ * @param frame_height Height of the frames in a frame file
+ * @return The image source, NULL if path is empty
+ */
+jetson_tensorrt::ImageSource *open_calibration_images(std::string path,
+                                                      int frame_width,
+                                                      int frame_height);
+
+/**
+ * @brief Runs the warm-up predictions of a node and logs how long they took,
+ * so cold start regressions show up in the log
+ * @param iterations Number of predictions to run
+ * @param predict Runs one prediction through the whole node
+ */
+void warm_up(int iterations, std::function<void()> predict);
+
+/**
+ * @brief Runs batches smaller than the maximum batch size on networks built
+ * for their size, and logs why if they can not be
+ * @usage Networks are built in the background the first time a batch would
+ * run on them
+ * @param engine The engine, which needs a backend factory to build networks
+ * @param batch_sizes The batch_sizes param of the node
+ */
+void set_batch_sizes(jetson_tensorrt::TensorRTEngine &engine,
+                     std::vector<int> batch_sizes);
+
+/**
+ * @brief Names a topic or statistic of one camera of a node
+ * @param name Name shared by the cameras
+ * @param camera Index of the camera
+ * @param nb_cameras Number of cameras, a single camera keeps the plain name
+ * @param separator Separates the name from the camera index
+ * @return The name of the camera's topic or statistic
+ */
+std::string camera_name(std::string name, int camera, size_t nb_cameras,
+                        std::string separator);
+
 #endif
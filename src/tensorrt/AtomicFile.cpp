@@ -0,0 +1,85 @@
+/**
+ * @file	AtomicFile.cpp
+ * @author	Carroll Vance
+ * @brief	File which is written under a temporary name and renamed into place
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+#include "AtomicFile.h"
+
+namespace jetson_tensorrt {
+
+AtomicFile::AtomicFile(std::string path) {
+  this->path = path;
+  committed = false;
+
+  // Writers in other threads and processes each get their own file
+  std::ostringstream name;
+  name << path << ".tmp." << getpid() << "." << std::this_thread::get_id();
+  temporaryPath = name.str();
+
+  file.open(temporaryPath.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+    throw std::runtime_error("Unable to open " + temporaryPath +
+                             " for writing");
+}
+
+AtomicFile::~AtomicFile() {
+  if (committed)
+    return;
+
+  file.close();
+  std::remove(temporaryPath.c_str());
+}
+
+std::ofstream &AtomicFile::stream() { return file; }
+
+void AtomicFile::commit() {
+  file.close();
+  if (file.fail())
+    throw std::runtime_error("Unable to write " + temporaryPath);
+
+  // The data has to reach the disk before the rename does, or a crash could
+  // leave an empty file under the final path
+  int fd = open(temporaryPath.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+
+  if (rename(temporaryPath.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Unable to rename " + temporaryPath + " to " +
+                             path + ": " + std::string(strerror(errno)));
+
+  committed = true;
+}
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,77 @@
+/**
+ * @file	AtomicFile.h
+ * @author	Carroll Vance
+ * @brief	File which is written under a temporary name and renamed into place
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ATOMICFILE_H_
+#define ATOMICFILE_H_
+
+#include <fstream>
+#include <string>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Writes a file next to its final path and renames it over the final
+ * path once complete, so readers in any process see either the previous
+ * file or the complete new one, never a partial write.
+ */
+class AtomicFile {
+public:
+  /**
+   * @brief	Opens a temporary file in the directory of the final path
+   * @param	path	The final path of the file
+   */
+  AtomicFile(std::string path);
+
+  /**
+   * @brief	Deletes the temporary file unless it was committed
+   */
+  virtual ~AtomicFile();
+
+  /**
+   * @brief	Gets the stream writing the temporary file
+   * @return	The stream, which supports seeking
+   */
+  std::ofstream &stream();
+
+  /**
+   * @brief	Flushes the temporary file to disk and renames it to the final
+   * path, replacing any existing file
+   */
+  void commit();
+
+private:
+  AtomicFile(const AtomicFile &) = delete;
+  AtomicFile &operator=(const AtomicFile &) = delete;
+
+  std::string path;
+  std::string temporaryPath;
+  std::ofstream file;
+  bool committed;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* ATOMICFILE_H_ */
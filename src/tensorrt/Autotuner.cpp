@@ -0,0 +1,154 @@
+/**
+ * @file	Autotuner.cpp
+ * @author	Carroll Vance
+ * @brief	Sweeps build settings of a network and measures each one
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
+#include "Autotuner.h"
+#include "LatencyHistogram.h"
+
+namespace jetson_tensorrt {
+
+static double toMilliseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+Autotuner::Autotuner(TuningEngineFactory factory, size_t warmupIterations,
+                     size_t iterations, MemoryLocation location) {
+  if (iterations == 0)
+    throw std::invalid_argument("Autotuner needs at least one iteration");
+
+  this->factory = factory;
+  this->warmupIterations = warmupIterations;
+  this->iterations = iterations;
+  this->location = location;
+}
+
+std::vector<TuningConfig>
+Autotuner::combinations(std::vector<nvinfer1::DataType> dataTypes,
+                        std::vector<size_t> maxNetworkSizes,
+                        std::vector<size_t> batchSizes) {
+  std::vector<TuningConfig> configs;
+
+  for (int d = 0; d < dataTypes.size(); d++)
+    for (int n = 0; n < maxNetworkSizes.size(); n++)
+      for (int b = 0; b < batchSizes.size(); b++) {
+        TuningConfig config;
+        config.dataType = dataTypes[d];
+        config.maxNetworkSize = maxNetworkSizes[n];
+        config.batchSize = batchSizes[b];
+        configs.push_back(config);
+      }
+
+  return configs;
+}
+
+TuningResult Autotuner::measure(const TuningConfig &config) {
+  TuningResult result;
+  result.config = config;
+  result.succeeded = false;
+  result.buildSeconds = 0;
+  result.meanMs = result.p50Ms = result.p90Ms = result.p99Ms = 0;
+  result.maxMs = result.recordsPerSecond = 0;
+
+  try {
+    std::chrono::steady_clock::time_point buildStart =
+        std::chrono::steady_clock::now();
+
+    std::unique_ptr<TensorRTEngine> engine(factory(config));
+    if (!engine)
+      throw std::runtime_error("No engine was built");
+
+    result.buildSeconds = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - buildStart)
+                              .count();
+
+    LocatedExecutionMemory inputs = engine->allocInputs(location);
+    LocatedExecutionMemory outputs = engine->allocOutputs(location);
+
+    // Predict exactly the batch size that was built for
+    LocatedExecutionMemory batchInputs(location, {});
+    LocatedExecutionMemory batchOutputs(location, {});
+    for (int b = 0; b < config.batchSize && b < inputs.size(); b++) {
+      batchInputs.batch.push_back(inputs[b]);
+      batchOutputs.batch.push_back(outputs[b]);
+    }
+
+    if (batchInputs.size() != config.batchSize)
+      throw std::runtime_error("Engine was built for a smaller batch size");
+
+    // Lazy allocations and the first kernel launches are not part of the
+    // steady state
+    for (size_t i = 0; i < warmupIterations; i++)
+      engine->predict(batchInputs, batchOutputs);
+
+    LatencyHistogram latencies;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; i++) {
+      ScopedLatency timer(latencies);
+      engine->predict(batchInputs, batchOutputs);
+    }
+
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    result.meanMs = toMilliseconds(latencies.mean());
+    result.p50Ms = toMilliseconds(latencies.percentile(50));
+    result.p90Ms = toMilliseconds(latencies.percentile(90));
+    result.p99Ms = toMilliseconds(latencies.percentile(99));
+    result.maxMs = toMilliseconds(latencies.max());
+    result.recordsPerSecond =
+        elapsed > 0 ? iterations * config.batchSize / elapsed : 0;
+    result.succeeded = true;
+  } catch (std::exception &e) {
+    result.error = e.what();
+  }
+
+  return result;
+}
+
+std::vector<TuningResult>
+Autotuner::sweep(const std::vector<TuningConfig> &configs,
+                 std::function<void(const TuningResult &)> progress) {
+  std::vector<TuningResult> results;
+
+  // One engine at a time, so every configuration has the GPU to itself
+  for (int c = 0; c < configs.size(); c++) {
+    results.push_back(measure(configs[c]));
+
+    if (progress)
+      progress(results.back());
+  }
+
+  return results;
+}
+
+} // namespace jetson_tensorrt
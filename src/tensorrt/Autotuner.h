@@ -0,0 +1,139 @@
+/**
+ * @file	Autotuner.h
+ * @author	Carroll Vance
+ * @brief	Sweeps build settings of a network and measures each one
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef AUTOTUNER_H_
+#define AUTOTUNER_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "NvInfer.h"
+
+#include "TensorRTEngine.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Build settings of one network measured by the Autotuner
+ */
+struct TuningConfig {
+  nvinfer1::DataType dataType;
+  size_t maxNetworkSize;
+  size_t batchSize;
+};
+
+/**
+ * @brief Measured performance of one TuningConfig
+ */
+struct TuningResult {
+  TuningConfig config;
+
+  /* Whether the network could be built and run, error holds why not */
+  bool succeeded;
+  std::string error;
+
+  double buildSeconds;
+
+  /* Latency of one prediction of a whole batch */
+  double meanMs, p50Ms, p90Ms, p99Ms, maxMs;
+
+  double recordsPerSecond;
+};
+
+/**
+ * @brief Builds the engine of a configuration
+ * @param	config	The settings to build the network with
+ * @return	The loaded engine, owned by the caller
+ */
+typedef std::function<TensorRTEngine *(const TuningConfig &config)>
+    TuningEngineFactory;
+
+/**
+ * @brief Builds a network with every combination of settings and times
+ * predictions on each of them.
+ *
+ * Engines come from a factory, so the sweep can run against a MockBackend
+ * as well as TensorRT.
+ */
+class Autotuner {
+public:
+  static const size_t DEFAULT_WARMUP = 10;
+  static const size_t DEFAULT_ITERATIONS = 100;
+
+  /**
+   * @brief	Creates a new Autotuner
+   * @param	factory	Builds the engine of each configuration
+   * @param	warmupIterations	Untimed predictions before measuring
+   * @param	iterations	Timed predictions of each configuration
+   * @param	location	Where inputs and outputs are allocated, HOST for
+   * backends without a GPU
+   */
+  Autotuner(TuningEngineFactory factory,
+            size_t warmupIterations = DEFAULT_WARMUP,
+            size_t iterations = DEFAULT_ITERATIONS,
+            MemoryLocation location = MemoryLocation::DEVICE);
+
+  /**
+   * @brief	Lists every combination of settings
+   * @param	dataTypes	Precisions to build with
+   * @param	maxNetworkSizes	Builder workspace sizes in bytes
+   * @param	batchSizes	Batch sizes to build for and predict with
+   * @return	One configuration per combination
+   */
+  static std::vector<TuningConfig>
+  combinations(std::vector<nvinfer1::DataType> dataTypes,
+               std::vector<size_t> maxNetworkSizes,
+               std::vector<size_t> batchSizes);
+
+  /**
+   * @brief	Builds and times one configuration
+   * @usage	Failures are reported in the result instead of thrown
+   * @param	config	The configuration
+   * @return	The measurements
+   */
+  TuningResult measure(const TuningConfig &config);
+
+  /**
+   * @brief	Builds and times every configuration one after another
+   * @param	configs	The configurations
+   * @param	progress	Called after each configuration, may be empty
+   * @return	One result per configuration, in order
+   */
+  std::vector<TuningResult>
+  sweep(const std::vector<TuningConfig> &configs,
+        std::function<void(const TuningResult &)> progress = nullptr);
+
+private:
+  TuningEngineFactory factory;
+  size_t warmupIterations;
+  size_t iterations;
+  MemoryLocation location;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* AUTOTUNER_H_ */
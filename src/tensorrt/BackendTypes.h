@@ -0,0 +1,109 @@
+/**
+ * @file	BackendTypes.h
+ * @author	Carroll Vance
+ * @brief	CUDA and TensorRT types used by the execution backends
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BACKENDTYPES_H_
+#define BACKENDTYPES_H_
+
+#ifndef JETSON_TENSORRT_HOST_ONLY
+
+#include <cuda_runtime_api.h>
+
+#include "NvInfer.h"
+
+#else
+
+/*
+ * Hosts without CUDA or TensorRT only build the engine on the mock backend,
+ * which needs the declarations below and none of the libraries. They match
+ * the layout of the TensorRT 4 and CUDA headers.
+ */
+
+typedef struct CUstream_st *cudaStream_t;
+
+enum cudaError { cudaSuccess = 0, cudaErrorUnknown = 30 };
+typedef enum cudaError cudaError_t;
+
+namespace nvinfer1 {
+
+enum class DataType : int { kFLOAT = 0, kHALF = 1, kINT8 = 2, kINT32 = 3 };
+
+enum class DimensionType : int {
+  kSPATIAL = 0,
+  kCHANNEL = 1,
+  kINDEX = 2,
+  kSEQUENCE = 3
+};
+
+class Dims {
+public:
+  static const int MAX_DIMS = 8;
+  int nbDims;
+  int d[MAX_DIMS];
+  DimensionType type[MAX_DIMS];
+};
+
+class DimsCHW : public Dims {
+public:
+  DimsCHW() { nbDims = 3; }
+
+  DimsCHW(int channels, int height, int width) {
+    nbDims = 3;
+    d[0] = channels;
+    d[1] = height;
+    d[2] = width;
+    type[0] = DimensionType::kCHANNEL;
+    type[1] = type[2] = DimensionType::kSPATIAL;
+  }
+};
+
+class ILogger {
+public:
+  enum class Severity {
+    kINTERNAL_ERROR = 0,
+    kERROR = 1,
+    kWARNING = 2,
+    kINFO = 3
+  };
+
+  virtual void log(Severity severity, const char *msg) = 0;
+
+protected:
+  virtual ~ILogger() {}
+};
+
+class IProfiler {
+public:
+  virtual void reportLayerTime(const char *layerName, float ms) = 0;
+
+protected:
+  virtual ~IProfiler() {}
+};
+
+} // namespace nvinfer1
+
+#endif /* JETSON_TENSORRT_HOST_ONLY */
+
+#endif /* BACKENDTYPES_H_ */
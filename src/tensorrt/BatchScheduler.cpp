@@ -0,0 +1,174 @@
+/**
+ * @file	BatchScheduler.cpp
+ * @author	Carroll Vance
+ * @brief	Groups single record requests into batches for a TensorRTEngine
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdexcept>
+
+#include "BatchScheduler.h"
+
+namespace jetson_tensorrt {
+
+BatchScheduler::BatchScheduler(TensorRTEngine *engine,
+                               MemoryLocation inputLocation,
+                               MemoryLocation outputLocation,
+                               std::chrono::microseconds maxWait,
+                               size_t maxBatchSize, size_t nbWorkers) {
+  this->engine = engine;
+  this->inputLocation = inputLocation;
+  this->outputLocation = outputLocation;
+  this->maxWait = maxWait;
+
+  if (maxBatchSize == 0 || maxBatchSize > engine->maxBatchSize)
+    maxBatchSize = engine->maxBatchSize;
+  this->maxBatchSize = maxBatchSize;
+
+  if (this->maxBatchSize == 0)
+    throw std::invalid_argument(
+        "BatchScheduler requires an engine with a network loaded");
+
+  stopping = false;
+  batchCount = 0;
+  requestCount = 0;
+
+  for (size_t w = 0; w < nbWorkers; w++)
+    workers.push_back(std::thread(&BatchScheduler::work, this));
+}
+
+BatchScheduler::~BatchScheduler() {
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  queueChanged.notify_all();
+
+  for (int w = 0; w < workers.size(); w++)
+    workers[w].join();
+}
+
+std::future<void> BatchScheduler::submit(std::vector<void *> inputs,
+                                         std::vector<void *> outputs) {
+
+  if (inputs.size() != engine->networkInputs.size() ||
+      outputs.size() != engine->networkOutputs.size())
+    throw std::invalid_argument(
+        "Request does not match the network inputs and outputs");
+
+  Request *request = new Request();
+  request->inputs = inputs;
+  request->outputs = outputs;
+  request->arrival = std::chrono::steady_clock::now();
+
+  std::future<void> done = request->done.get_future();
+
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (stopping) {
+      delete request;
+      throw std::runtime_error("BatchScheduler is shutting down");
+    }
+    queue.push_back(request);
+  }
+  queueChanged.notify_all();
+
+  return done;
+}
+
+size_t BatchScheduler::batches() {
+  std::unique_lock<std::mutex> lock(queueMutex);
+  return batchCount;
+}
+
+size_t BatchScheduler::requests() {
+  std::unique_lock<std::mutex> lock(queueMutex);
+  return requestCount;
+}
+
+void BatchScheduler::work() {
+  std::unique_lock<std::mutex> lock(queueMutex);
+
+  while (true) {
+    queueChanged.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+    if (queue.empty())
+      return;
+
+    // Give the batch until the oldest request's deadline to fill up. When
+    // another worker takes the oldest requests meanwhile, the deadline of the
+    // request which is the oldest now applies.
+    while (!stopping && !queue.empty() && queue.size() < maxBatchSize) {
+      std::chrono::steady_clock::time_point deadline =
+          queue.front()->arrival + maxWait;
+      if (std::chrono::steady_clock::now() >= deadline)
+        break;
+
+      queueChanged.wait_until(lock, deadline);
+    }
+
+    // Another worker may have taken the requests in the meantime
+    if (queue.empty())
+      continue;
+
+    std::vector<Request *> batch;
+    while (!queue.empty() && batch.size() < maxBatchSize) {
+      batch.push_back(queue.front());
+      queue.pop_front();
+    }
+
+    batchCount++;
+    requestCount += batch.size();
+
+    lock.unlock();
+    runBatch(batch);
+    lock.lock();
+  }
+}
+
+void BatchScheduler::runBatch(std::vector<Request *> &batch) {
+
+  LocatedExecutionMemory inputs(
+      inputLocation, std::vector<std::vector<void *>>(batch.size()));
+  LocatedExecutionMemory outputs(
+      outputLocation, std::vector<std::vector<void *>>(batch.size()));
+
+  for (int b = 0; b < batch.size(); b++) {
+    inputs[b] = batch[b]->inputs;
+    outputs[b] = batch[b]->outputs;
+  }
+
+  try {
+    engine->predict(inputs, outputs);
+
+    for (int b = 0; b < batch.size(); b++)
+      batch[b]->done.set_value();
+  } catch (...) {
+    for (int b = 0; b < batch.size(); b++)
+      batch[b]->done.set_exception(std::current_exception());
+  }
+
+  for (int b = 0; b < batch.size(); b++)
+    delete batch[b];
+}
+
+} // namespace jetson_tensorrt
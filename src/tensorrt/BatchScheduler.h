@@ -0,0 +1,127 @@
+/**
+ * @file	BatchScheduler.h
+ * @author	Carroll Vance
+ * @brief	Groups single record requests into batches for a TensorRTEngine
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BATCHSCHEDULER_H_
+#define BATCHSCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CUDACommon.h"
+#include "TensorRTEngine.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Queues single record prediction requests from any number of
+ * producers and runs them through a TensorRTEngine in batches of up to
+ * maxBatchSize.
+ *
+ * A batch is dispatched as soon as it is full, or once the oldest request in
+ * it has waited maxWait, whichever happens first. Each request supplies its
+ * own input and output memory, so every producer gets its own slice of the
+ * batched outputs back.
+ */
+class BatchScheduler {
+public:
+  /**
+   * @brief	Creates a new BatchScheduler and starts its workers
+   * @param	engine	The loaded engine to run batches on. Must outlive the
+   * scheduler.
+   * @param	inputLocation	Where the inputs of every request are located
+   * @param	outputLocation	Where the outputs of every request are located
+   * @param	maxWait	Longest time a request waits for its batch to fill up
+   * @param	maxBatchSize	Largest batch to dispatch, 0 for the engine's
+   * maximum batch size
+   * @param	nbWorkers	Number of batches which can be in flight at once.
+   * Should not exceed the engine's context pool size.
+   */
+  BatchScheduler(TensorRTEngine *engine, MemoryLocation inputLocation,
+                 MemoryLocation outputLocation,
+                 std::chrono::microseconds maxWait,
+                 size_t maxBatchSize = 0, size_t nbWorkers = 1);
+
+  /**
+   * @brief	Runs every queued request and stops the workers
+   */
+  virtual ~BatchScheduler();
+
+  /**
+   * @brief	Queues a single record for prediction
+   * @usage	inputs and outputs must stay valid until the future is ready
+   * @param	inputs	One pointer per network input
+   * @param	outputs	One pointer per network output
+   * @return	A future which becomes ready once the outputs are written
+   */
+  std::future<void> submit(std::vector<void *> inputs,
+                           std::vector<void *> outputs);
+
+  /**
+   * @brief	Gets the number of batches dispatched so far
+   * @return	Number of batches
+   */
+  size_t batches();
+
+  /**
+   * @brief	Gets the number of requests dispatched so far
+   * @return	Number of requests
+   */
+  size_t requests();
+
+private:
+  struct Request {
+    std::vector<void *> inputs;
+    std::vector<void *> outputs;
+    std::chrono::steady_clock::time_point arrival;
+    std::promise<void> done;
+  };
+
+  TensorRTEngine *engine;
+  MemoryLocation inputLocation, outputLocation;
+  std::chrono::microseconds maxWait;
+  size_t maxBatchSize;
+
+  std::vector<std::thread> workers;
+  std::mutex queueMutex;
+  std::condition_variable queueChanged;
+  std::deque<Request *> queue;
+  bool stopping;
+
+  size_t batchCount;
+  size_t requestCount;
+
+  void work();
+  void runBatch(std::vector<Request *> &batch);
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* BATCHSCHEDULER_H_ */
@@ -43,6 +43,8 @@ void *safeCudaHostMalloc(size_t memSize) {
   } else if (hostMem == nullptr) {
     throw std::runtime_error("Out of device memory");
   }
+
+  return hostMem;
 }
 
 void *safeCudaMalloc(size_t memSize) {
@@ -34,8 +34,10 @@
 #include <stdexcept>
 #include <vector>
 
+#ifndef JETSON_TENSORRT_HOST_ONLY
 #include <cuda.h>
 #include <cuda_runtime.h>
+#endif
 
 namespace jetson_tensorrt {
 
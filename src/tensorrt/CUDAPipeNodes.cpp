@@ -173,7 +173,8 @@ CUDAPipeIO RGBAfToImageNetNode::pipe(CUDAPipeIO &input) {
   if (mean.x == 0.0 && mean.y == 0.0 && mean.z == 0.0) {
     cudaError_t kernelError =
         cudaPreImageNet((float4 *)input.data, inputWidth, inputHeight,
-                        (float *)output.data, outputWidth, outputHeight);
+                        (float *)output.data, outputWidth, outputHeight,
+                        filter);
     if (kernelError != 0)
       throw std::runtime_error(
           "cudaPreImageNet kernel returned an error. CUDA Error: " +
@@ -181,7 +182,7 @@ CUDAPipeIO RGBAfToImageNetNode::pipe(CUDAPipeIO &input) {
   } else {
     cudaError_t kernelError = cudaPreImageNetMean(
         (float4 *)input.data, inputWidth, inputHeight, (float *)output.data,
-        outputWidth, outputHeight, mean);
+        outputWidth, outputHeight, mean, filter);
     if (kernelError != 0)
       throw std::runtime_error(
           "cudaPreImageNetMean kernel returned an error. CUDA Error: " +
@@ -191,4 +192,186 @@ CUDAPipeIO RGBAfToImageNetNode::pipe(CUDAPipeIO &input) {
   return output;
 }
 
+CUDAPipeIO RGBToImageNetNode::pipe(CUDAPipeIO &input) {
+  if (input.location != MemoryLocation::DEVICE)
+    throw std::runtime_error(
+        "RGBToImageNetNode requires inputs in MemoryLocation::DEVICE");
+
+  if (input.size() < inputWidth * inputHeight * sizeof(uchar3))
+    throw std::runtime_error("RGBToImageNetNode input is smaller than a " +
+                             std::to_string(inputWidth) + "x" +
+                             std::to_string(inputHeight) + " RGB8 image");
+
+  // Three planes, exactly the size of the network input
+  CUDAPipeIO output =
+      CUDAPipeIO(MemoryLocation::DEVICE, nullptr,
+                 outputWidth * outputHeight * 3 * sizeof(float));
+
+  if (!allocated) {
+    data = safeCudaMalloc(output.size());
+    allocLocation = MemoryLocation::DEVICE;
+    allocSize = output.size();
+    allocated = true;
+  } else {
+    if (output.size() != allocSize)
+      throw std::runtime_error(
+          "CUDAPipeline does not support variable sized inputs");
+  }
+
+  output.data = data;
+
+  cudaError_t kernelError = cudaPreImageNetRGB(
+      (uchar3 *)input.data, inputWidth, inputHeight, (float *)output.data,
+      outputWidth, outputHeight, mean, filter);
+  if (kernelError != 0)
+    throw std::runtime_error(
+        "cudaPreImageNetRGB kernel returned an error. CUDA Error: " +
+        std::to_string(kernelError));
+
+  return output;
+}
+
+CUDAPipeIO NV12ToImageNetNode::pipe(CUDAPipeIO &input) {
+  if (input.location != MemoryLocation::DEVICE)
+    throw std::runtime_error(
+        "NV12ToImageNetNode requires inputs in MemoryLocation::DEVICE");
+
+  // Three planes, exactly the size of the network input
+  CUDAPipeIO output =
+      CUDAPipeIO(MemoryLocation::DEVICE, nullptr,
+                 outputWidth * outputHeight * 3 * sizeof(float));
+
+  if (!allocated) {
+    data = safeCudaMalloc(output.size());
+    allocLocation = MemoryLocation::DEVICE;
+    allocSize = output.size();
+    allocated = true;
+  } else {
+    if (output.size() != allocSize)
+      throw std::runtime_error(
+          "CUDAPipeline does not support variable sized inputs");
+  }
+
+  output.data = data;
+
+  cudaError_t kernelError = cudaNV12ToImageNet(
+      (uint8_t *)input.data, inputWidth, inputHeight, (float *)output.data,
+      outputWidth, outputHeight, mean, filter);
+  if (kernelError != 0)
+    throw std::runtime_error(
+        "cudaNV12ToImageNet kernel returned an error. CUDA Error: " +
+        std::to_string(kernelError));
+
+  return output;
+}
+
+RGBAfToLetterboxNode::RGBAfToLetterboxNode(size_t inputWidth,
+                                           size_t inputHeight,
+                                           size_t outputWidth,
+                                           size_t outputHeight, float3 mean,
+                                           float3 padding,
+                                           cudaFilterMode filter)
+    : CUDAPipeNode() {
+  this->inputWidth = inputWidth;
+  this->inputHeight = inputHeight;
+  this->outputWidth = outputWidth;
+  this->outputHeight = outputHeight;
+  this->mean = mean;
+  this->padding = padding;
+  this->filter = filter;
+
+  // The same rectangle the kernel fills
+  int2 offset, size;
+  cudaLetterboxRect(inputWidth, inputHeight, outputWidth, outputHeight, offset,
+                    size);
+
+  transform.scaleX = (float)size.x / (float)inputWidth;
+  transform.scaleY = (float)size.y / (float)inputHeight;
+  transform.offsetX = offset.x;
+  transform.offsetY = offset.y;
+  transform.imageWidth = inputWidth;
+  transform.imageHeight = inputHeight;
+}
+
+CUDAPipeIO RGBAfToLetterboxNode::pipe(CUDAPipeIO &input) {
+  if (input.location != MemoryLocation::DEVICE)
+    throw std::runtime_error(
+        "RGBAfToLetterboxNode requires inputs in MemoryLocation::DEVICE");
+
+  // Three planes, exactly the size of the network input
+  CUDAPipeIO output =
+      CUDAPipeIO(MemoryLocation::DEVICE, nullptr,
+                 outputWidth * outputHeight * 3 * sizeof(float));
+
+  if (!allocated) {
+    data = safeCudaMalloc(output.size());
+    allocLocation = MemoryLocation::DEVICE;
+    allocSize = output.size();
+    allocated = true;
+  } else {
+    if (output.size() != allocSize)
+      throw std::runtime_error(
+          "CUDAPipeline does not support variable sized inputs");
+  }
+
+  output.data = data;
+
+  cudaError_t kernelError = cudaPreImageNetLetterbox(
+      (float4 *)input.data, inputWidth, inputHeight, (float *)output.data,
+      outputWidth, outputHeight, mean, padding, filter);
+  if (kernelError != 0)
+    throw std::runtime_error(
+        "cudaPreImageNetLetterbox kernel returned an error. CUDA Error: " +
+        std::to_string(kernelError));
+
+  return output;
+}
+
+ImageTransform stretchTransform(size_t inputWidth, size_t inputHeight,
+                                size_t outputWidth, size_t outputHeight) {
+  ImageTransform transform;
+  transform.scaleX = (float)outputWidth / (float)inputWidth;
+  transform.scaleY = (float)outputHeight / (float)inputHeight;
+  transform.imageWidth = inputWidth;
+  transform.imageHeight = inputHeight;
+  return transform;
+}
+
+CUDAPipeNode *fuseNodes(CUDAPipeNode *first, CUDAPipeNode *second,
+                        PipelineFusion &fusion) {
+  RGBAfToImageNetNode *imageNet = dynamic_cast<RGBAfToImageNetNode *>(second);
+  if (imageNet == nullptr)
+    return nullptr;
+
+  CUDAPipeNode *fused = nullptr;
+  size_t inputWidth = imageNet->inputWidth, inputHeight = imageNet->inputHeight;
+
+  // Both convert every pixel to an RGBAf frame which is then only sampled
+  RGBToRGBAfNode *rgb = dynamic_cast<RGBToRGBAfNode *>(first);
+  if (rgb != nullptr && rgb->inputWidth == inputWidth &&
+      rgb->inputHeight == inputHeight)
+    fused = new RGBToImageNetNode(inputWidth, inputHeight,
+                                  imageNet->outputWidth,
+                                  imageNet->outputHeight, imageNet->mean,
+                                  imageNet->filter);
+
+  NV12toRGBAfNode *nv12 = dynamic_cast<NV12toRGBAfNode *>(first);
+  if (nv12 != nullptr && nv12->inputWidth == inputWidth &&
+      nv12->inputHeight == inputHeight)
+    fused = new NV12ToImageNetNode(inputWidth, inputHeight,
+                                   imageNet->outputWidth,
+                                   imageNet->outputHeight, imageNet->mean,
+                                   imageNet->filter);
+
+  if (fused == nullptr)
+    return nullptr;
+
+  fusion.first = first->getName();
+  fusion.second = second->getName();
+  fusion.fused = fused->getName();
+  fusion.intermediateBytes = inputWidth * inputHeight * sizeof(float4);
+
+  return fused;
+}
+
 } // namespace jetson_tensorrt
@@ -33,12 +33,24 @@
 
 namespace jetson_tensorrt {
 
+/**
+ * @brief	Transform of an image stretched to the output size
+ * @param	inputWidth	Width of the image
+ * @param	inputHeight	Height of the image
+ * @param	outputWidth	Width it is stretched to
+ * @param	outputHeight	Height it is stretched to
+ * @return	The transform
+ */
+ImageTransform stretchTransform(size_t inputWidth, size_t inputHeight,
+                                size_t outputWidth, size_t outputHeight);
+
 class ToDevicePTRNode : public CUDAPipeNode {
 public:
   ToDevicePTRNode() : CUDAPipeNode() {}
   virtual ~ToDevicePTRNode() {}
 
   CUDAPipeIO pipe(CUDAPipeIO &input);
+  const char *getName() { return "ToDevicePTRNode"; }
 };
 
 class RGBToRGBAfNode : public CUDAPipeNode {
@@ -50,6 +62,7 @@ public:
   virtual ~RGBToRGBAfNode() {}
 
   CUDAPipeIO pipe(CUDAPipeIO &input);
+  const char *getName() { return "RGBToRGBAfNode"; }
 
   size_t inputWidth, inputHeight;
 };
@@ -63,6 +76,7 @@ public:
   virtual ~NV12toRGBAfNode() {}
 
   CUDAPipeIO pipe(CUDAPipeIO &input);
+  const char *getName() { return "NV12toRGBAfNode"; }
 
   size_t inputWidth, inputHeight;
 };
@@ -70,23 +84,136 @@ public:
 class RGBAfToImageNetNode : public CUDAPipeNode {
 public:
   RGBAfToImageNetNode(size_t inputWidth, size_t inputHeight, size_t outputWidth,
-                      size_t outputHeight, float3 mean)
+                      size_t outputHeight, float3 mean,
+                      cudaFilterMode filter = FILTER_POINT)
       : CUDAPipeNode() {
     this->inputWidth = inputWidth;
     this->inputHeight = inputHeight;
     this->outputWidth = outputWidth;
     this->outputHeight = outputHeight;
     this->mean = mean;
+    this->filter = filter;
   }
   virtual ~RGBAfToImageNetNode() {}
 
   CUDAPipeIO pipe(CUDAPipeIO &input);
+  const char *getName() { return "RGBAfToImageNetNode"; }
+  ImageTransform getTransform() {
+    return stretchTransform(inputWidth, inputHeight, outputWidth,
+                            outputHeight);
+  }
+
+  size_t inputWidth, inputHeight;
+  size_t outputWidth, outputHeight;
+  float3 mean;
+  cudaFilterMode filter;
+};
+
+/**
+ * @brief Converts packed RGB8 frames straight to the resized, mean subtracted,
+ * planar BGR input of ImageNet networks. Produces the same output as
+ * RGBToRGBAfNode followed by RGBAfToImageNetNode, but only reads the sampled
+ * pixels and never writes a full resolution RGBAf frame.
+ */
+class RGBToImageNetNode : public CUDAPipeNode {
+public:
+  RGBToImageNetNode(size_t inputWidth, size_t inputHeight, size_t outputWidth,
+                    size_t outputHeight, float3 mean,
+                    cudaFilterMode filter = FILTER_POINT)
+      : CUDAPipeNode() {
+    this->inputWidth = inputWidth;
+    this->inputHeight = inputHeight;
+    this->outputWidth = outputWidth;
+    this->outputHeight = outputHeight;
+    this->mean = mean;
+    this->filter = filter;
+  }
+  virtual ~RGBToImageNetNode() {}
+
+  CUDAPipeIO pipe(CUDAPipeIO &input);
+  const char *getName() { return "RGBToImageNetNode"; }
+  ImageTransform getTransform() {
+    return stretchTransform(inputWidth, inputHeight, outputWidth,
+                            outputHeight);
+  }
+
+  size_t inputWidth, inputHeight;
+  size_t outputWidth, outputHeight;
+  float3 mean;
+  cudaFilterMode filter;
+};
+
+/**
+ * @brief Converts NV12 frames straight to the resized, mean subtracted,
+ * planar BGR input of ImageNet networks. Produces the same output as
+ * NV12toRGBAfNode followed by RGBAfToImageNetNode without the full
+ * resolution RGBAf frame in between.
+ */
+class NV12ToImageNetNode : public CUDAPipeNode {
+public:
+  NV12ToImageNetNode(size_t inputWidth, size_t inputHeight, size_t outputWidth,
+                     size_t outputHeight, float3 mean,
+                     cudaFilterMode filter = FILTER_POINT)
+      : CUDAPipeNode() {
+    this->inputWidth = inputWidth;
+    this->inputHeight = inputHeight;
+    this->outputWidth = outputWidth;
+    this->outputHeight = outputHeight;
+    this->mean = mean;
+    this->filter = filter;
+  }
+  virtual ~NV12ToImageNetNode() {}
+
+  CUDAPipeIO pipe(CUDAPipeIO &input);
+  const char *getName() { return "NV12ToImageNetNode"; }
+  ImageTransform getTransform() {
+    return stretchTransform(inputWidth, inputHeight, outputWidth,
+                            outputHeight);
+  }
 
   size_t inputWidth, inputHeight;
   size_t outputWidth, outputHeight;
   float3 mean;
+  cudaFilterMode filter;
 };
 
+/**
+ * @brief Converts RGBAf frames to the mean subtracted, planar BGR input of
+ * ImageNet networks, scaled to fit the network input with their aspect ratio
+ * preserved instead of stretched. The borders are filled with a padding
+ * pixel, and getTransform() tells where the frame ended up.
+ */
+class RGBAfToLetterboxNode : public CUDAPipeNode {
+public:
+  RGBAfToLetterboxNode(size_t inputWidth, size_t inputHeight,
+                       size_t outputWidth, size_t outputHeight, float3 mean,
+                       float3 padding, cudaFilterMode filter = FILTER_POINT);
+  virtual ~RGBAfToLetterboxNode() {}
+
+  CUDAPipeIO pipe(CUDAPipeIO &input);
+  const char *getName() { return "RGBAfToLetterboxNode"; }
+  ImageTransform getTransform() { return transform; }
+
+  size_t inputWidth, inputHeight;
+  size_t outputWidth, outputHeight;
+  float3 mean, padding;
+  cudaFilterMode filter;
+
+  /* Scale and offset of the frame within the output */
+  ImageTransform transform;
+};
+
+/**
+ * @brief	Creates the fused implementation of two adjacent nodes
+ * @param	first	Node which runs first
+ * @param	second	Node which consumes the output of first
+ * @param	fusion	Filled in with the nodes which were fused
+ * @return	A node replacing both, or nullptr if they have no fused
+ * implementation
+ */
+CUDAPipeNode *fuseNodes(CUDAPipeNode *first, CUDAPipeNode *second,
+                        PipelineFusion &fusion);
+
 } // namespace jetson_tensorrt
 
 #endif
@@ -26,6 +26,11 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
 #include "CUDAPipeline.h"
 
 #include "CUDAPipeNodes.h"
@@ -42,21 +47,158 @@ CUDAPipeIO::CUDAPipeIO(MemoryLocation location, void *data, size_t dataSize) {
 
 size_t CUDAPipeIO::size() { return dataSize; }
 
+ImageTransform::ImageTransform() {
+  scaleX = scaleY = 1.0f;
+  offsetX = offsetY = 0.0f;
+  imageWidth = imageHeight = 0;
+}
+
+float ImageTransform::toImageX(float x) const {
+  float imageX = (x - offsetX) / scaleX;
+  if (imageWidth > 0)
+    imageX = std::min(std::max(imageX, 0.0f), (float)imageWidth);
+  return imageX;
+}
+
+float ImageTransform::toImageY(float y) const {
+  float imageY = (y - offsetY) / scaleY;
+  if (imageHeight > 0)
+    imageY = std::min(std::max(imageY, 0.0f), (float)imageHeight);
+  return imageY;
+}
+
+ImageTransform ImageTransform::then(const ImageTransform &next) const {
+  ImageTransform combined;
+  combined.scaleX = scaleX * next.scaleX;
+  combined.scaleY = scaleY * next.scaleY;
+  combined.offsetX = offsetX * next.scaleX + next.offsetX;
+  combined.offsetY = offsetY * next.scaleY + next.offsetY;
+
+  // Only the first node which knows its input size saw the original image
+  combined.imageWidth = imageWidth > 0 ? imageWidth : next.imageWidth;
+  combined.imageHeight = imageHeight > 0 ? imageHeight : next.imageHeight;
+  return combined;
+}
+
 void CUDAPipeline::addNode(CUDAPipeNode *node) { nodes.push_back(node); }
 
 CUDAPipeline::CUDAPipeline() {}
 CUDAPipeline::~CUDAPipeline() {
   for (int node = 0; node < nodes.size(); node++)
     delete nodes[node];
+
+  for (int node = 0; node < nodeLatencies.size(); node++)
+    delete nodeLatencies[node];
+
+  for (int event = 0; event < nodeEvents.size(); event++)
+    cudaEventDestroy(nodeEvents[event]);
+}
+
+void CUDAPipeline::enableTiming() {
+  if (nodeEvents.size() > 0)
+    return;
+
+  // One event before every node and one after the last
+  for (int event = 0; event <= nodes.size(); event++) {
+    cudaEvent_t nodeEvent;
+    cudaError_t eventError = cudaEventCreate(&nodeEvent);
+    if (eventError != cudaSuccess)
+      throw std::runtime_error("Unable to create CUDA event. CUDA Error: " +
+                               std::to_string(eventError));
+    nodeEvents.push_back(nodeEvent);
+  }
+
+  for (int node = 0; node < nodes.size(); node++)
+    nodeLatencies.push_back(new LatencyHistogram());
+}
+
+std::vector<PipelineFusion> CUDAPipeline::fuse() {
+  if (nodeEvents.size() > 0)
+    throw std::runtime_error(
+        "CUDAPipeline nodes must be fused before timing is enabled");
+
+  std::vector<PipelineFusion> applied;
+
+  for (size_t node = 0; node + 1 < nodes.size();) {
+    PipelineFusion fusion;
+    CUDAPipeNode *fused = fuseNodes(nodes[node], nodes[node + 1], fusion);
+    if (fused == nullptr) {
+      node++;
+      continue;
+    }
+
+    delete nodes[node];
+    delete nodes[node + 1];
+    nodes[node] = fused;
+    nodes.erase(nodes.begin() + node + 1);
+
+    applied.push_back(fusion);
+
+    // The fused node may fuse again with the node before it
+    if (node > 0)
+      node--;
+  }
+
+  fusions.insert(fusions.end(), applied.begin(), applied.end());
+  return applied;
+}
+
+std::string CUDAPipeline::fusionReport() {
+  std::string report;
+
+  for (size_t fusion = 0; fusion < fusions.size(); fusion++) {
+    char intermediate[32];
+    snprintf(intermediate, sizeof(intermediate), "%.1f MB",
+             fusions[fusion].intermediateBytes / 1e6);
+
+    if (!report.empty())
+      report += "\n";
+    report += fusions[fusion].first + " + " + fusions[fusion].second +
+              " -> " + fusions[fusion].fused + ", skips a " + intermediate +
+              " intermediate image";
+  }
+
+  return report;
+}
+
+ImageTransform CUDAPipeline::getTransform() {
+  ImageTransform transform;
+
+  for (int node = 0; node < nodes.size(); node++)
+    transform = transform.then(nodes[node]->getTransform());
+
+  return transform;
 }
 
 CUDAPipeIO CUDAPipeline::pipe(CUDAPipeIO &input) {
   CUDAPipeIO result = input;
+  bool timed = nodeEvents.size() > 0;
+
+  if (timed)
+    cudaEventRecord(nodeEvents[0]);
 
   // Move through the pipe
-  for (int node = 0; node < nodes.size(); node++)
+  for (int node = 0; node < nodes.size(); node++) {
     result = nodes[node]->pipe(result);
 
+    if (timed)
+      cudaEventRecord(nodeEvents[node + 1]);
+  }
+
+  if (timed) {
+    cudaEventSynchronize(nodeEvents[nodes.size()]);
+
+    for (int node = 0; node < nodes.size(); node++) {
+      float ms = 0;
+      if (cudaEventElapsedTime(&ms, nodeEvents[node], nodeEvents[node + 1]) !=
+          cudaSuccess)
+        continue;
+
+      nodeLatencies[node]->record(
+          std::chrono::nanoseconds((int64_t)(ms * 1000000.0f)));
+    }
+  }
+
   return result;
 }
 
@@ -64,16 +206,18 @@ CUDAPipeline *CUDAPipeline::createNV12ImageNetPipeline(int inputWidth,
                                                        int inputHeight,
                                                        int outputWidth,
                                                        int outputHeight,
-                                                       float3 mean) {
+                                                       float3 mean,
+                                                       cudaFilterMode filter) {
   ToDevicePTRNode *ptrNode = new ToDevicePTRNode();
   NV12toRGBAfNode *nv12Node = new NV12toRGBAfNode(inputWidth, inputHeight);
   RGBAfToImageNetNode *imgNetNode = new RGBAfToImageNetNode(
-      inputWidth, inputHeight, outputWidth, outputHeight, mean);
+      inputWidth, inputHeight, outputWidth, outputHeight, mean, filter);
 
   CUDAPipeline *pipe = new CUDAPipeline();
   pipe->addNode(ptrNode);
   pipe->addNode(nv12Node);
   pipe->addNode(imgNetNode);
+  pipe->fuse();
 
   return pipe;
 }
@@ -82,16 +226,18 @@ CUDAPipeline *CUDAPipeline::createRGBImageNetPipeline(int inputWidth,
                                                       int inputHeight,
                                                       int outputWidth,
                                                       int outputHeight,
-                                                      float3 mean) {
+                                                      float3 mean,
+                                                      cudaFilterMode filter) {
   ToDevicePTRNode *ptrNode = new ToDevicePTRNode();
   RGBToRGBAfNode *rbgNode = new RGBToRGBAfNode(inputWidth, inputHeight);
   RGBAfToImageNetNode *imgNetNode = new RGBAfToImageNetNode(
-      inputWidth, inputHeight, outputWidth, outputHeight, mean);
+      inputWidth, inputHeight, outputWidth, outputHeight, mean, filter);
 
   CUDAPipeline *pipe = new CUDAPipeline();
   pipe->addNode(ptrNode);
   pipe->addNode(rbgNode);
   pipe->addNode(imgNetNode);
+  pipe->fuse();
 
   return pipe;
 }
@@ -100,10 +246,11 @@ CUDAPipeline *CUDAPipeline::createRGBAfImageNetPipeline(int inputWidth,
                                                         int inputHeight,
                                                         int outputWidth,
                                                         int outputHeight,
-                                                        float3 mean) {
+                                                        float3 mean,
+                                                        cudaFilterMode filter) {
   ToDevicePTRNode *ptrNode = new ToDevicePTRNode();
   RGBAfToImageNetNode *imgNetNode = new RGBAfToImageNetNode(
-      inputWidth, inputHeight, outputWidth, outputHeight, mean);
+      inputWidth, inputHeight, outputWidth, outputHeight, mean, filter);
 
   CUDAPipeline *pipe = new CUDAPipeline();
   pipe->addNode(ptrNode);
@@ -112,4 +259,21 @@ CUDAPipeline *CUDAPipeline::createRGBAfImageNetPipeline(int inputWidth,
   return pipe;
 }
 
+CUDAPipeline *CUDAPipeline::createRGBLetterboxPipeline(
+    int inputWidth, int inputHeight, int outputWidth, int outputHeight,
+    float3 mean, float3 padding, cudaFilterMode filter) {
+  ToDevicePTRNode *ptrNode = new ToDevicePTRNode();
+  RGBToRGBAfNode *rbgNode = new RGBToRGBAfNode(inputWidth, inputHeight);
+  RGBAfToLetterboxNode *letterboxNode =
+      new RGBAfToLetterboxNode(inputWidth, inputHeight, outputWidth,
+                               outputHeight, mean, padding, filter);
+
+  CUDAPipeline *pipe = new CUDAPipeline();
+  pipe->addNode(ptrNode);
+  pipe->addNode(rbgNode);
+  pipe->addNode(letterboxNode);
+
+  return pipe;
+}
+
 } // namespace jetson_tensorrt
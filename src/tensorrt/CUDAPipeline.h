@@ -29,9 +29,13 @@
 #ifndef CUDAPIPELINE_H_
 #define CUDAPIPELINE_H_
 
+#include <cuda_runtime_api.h>
+#include <string>
 #include <vector>
 
 #include "CUDACommon.h"
+#include "LatencyHistogram.h"
+#include "cudaFilterMode.h"
 
 namespace jetson_tensorrt {
 
@@ -47,9 +51,50 @@ public:
   void *data;
 };
 
+/**
+ * @brief Where the pixels of the original image end up in the output of a
+ * node or pipeline, which maps output coordinates x as
+ * x = imageX * scaleX + offsetX. Lets results computed on a network input,
+ * like detections, be mapped back to the original image.
+ */
+struct ImageTransform {
+  ImageTransform();
+
+  /**
+     @brief Map an output X coordinate back to the original image
+     @param x The output coordinate
+     @return The image coordinate, clamped to the image if its size is known
+   */
+  float toImageX(float x) const;
+
+  /**
+     @brief Map an output Y coordinate back to the original image
+     @param y The output coordinate
+     @return The image coordinate, clamped to the image if its size is known
+   */
+  float toImageY(float y) const;
+
+  /**
+     @brief Combine with the transform of a later node
+     @param next Transform applied to the output of this one
+     @return The transform doing both, from the original image
+   */
+  ImageTransform then(const ImageTransform &next) const;
+
+  float scaleX, scaleY;
+  float offsetX, offsetY;
+
+  /* Size of the original image, 0 if unknown */
+  size_t imageWidth, imageHeight;
+};
+
 class CUDAPipeNode {
 public:
   CUDAPipeNode() { this->allocated = false; }
+  virtual ~CUDAPipeNode() {
+    if (allocated)
+      cudaFree(data);
+  }
   /**
      @brief Send an input through the node and get back the output
      @param input The input to the node
@@ -57,6 +102,18 @@ public:
    */
   virtual CUDAPipeIO pipe(CUDAPipeIO &input) {}
 
+  /**
+     @brief Get the name of the node used when reporting timings
+     @return The name
+   */
+  virtual const char *getName() { return "CUDAPipeNode"; }
+
+  /**
+     @brief Get how the node moves and scales the pixels of its input
+     @return The transform, identity for nodes which only convert pixels
+   */
+  virtual ImageTransform getTransform() { return ImageTransform(); }
+
   void *data;
   size_t size();
 
@@ -66,6 +123,18 @@ protected:
   MemoryLocation allocLocation;
 };
 
+/**
+ * @brief Two adjacent nodes which CUDAPipeline::fuse() replaced with a single
+ * node
+ */
+struct PipelineFusion {
+  std::string first, second, fused;
+
+  /* Size of the intermediate image the first node no longer writes and the
+   * second no longer reads back on every pipe() */
+  size_t intermediateBytes;
+};
+
 class CUDAPipeline {
 
 public:
@@ -78,6 +147,28 @@ public:
    */
   void addNode(CUDAPipeNode *node);
 
+  /**
+     @brief Time every node with CUDA events, recording the GPU time of each
+     node in nodeLatencies
+     @usage Each pipe() then waits for the GPU to finish the pipeline before
+     returning, which the following inference would wait for anyway
+   */
+  void enableTiming();
+
+  /**
+     @brief Replace adjacent nodes which have a fused implementation with it.
+     Nodes without one run as they were added.
+     @usage Call after adding the nodes and before enableTiming()
+     @return The fusions applied, which are also kept in fusions
+   */
+  std::vector<PipelineFusion> fuse();
+
+  /**
+     @brief Describe the fusions applied by fuse(), one per line
+     @return The description, empty if nothing was fused
+   */
+  std::string fusionReport();
+
   /**
      @brief Send an input through the pipeline and get back the output
      @param input The input to the pipeline
@@ -85,6 +176,12 @@ public:
    */
   CUDAPipeIO pipe(CUDAPipeIO &input);
 
+  /**
+     @brief Get how the pipeline moves and scales the pixels of its input
+     @return The transforms of every node combined
+   */
+  ImageTransform getTransform();
+
   /**
   @brief Create an NV12 -> ImageNet preprocessing pipeline
   @param inputWidth NV12 image width
@@ -92,11 +189,13 @@ public:
   @param outputWidth BGR image width
   @param outputHeight BGR image height
   @param mean ImageNet mean
+  @param filter How the image is sampled when resizing it
   @return CUDAPipeline configured to do the required image preprocessing
   */
   static CUDAPipeline *
   createNV12ImageNetPipeline(int inputWidth, int inputHeight, int outputWidth,
-                             int outputHeight, float3 mean);
+                             int outputHeight, float3 mean,
+                             cudaFilterMode filter = FILTER_POINT);
   /**
   @brief Create an RGB -> ImageNet preprocessing pipeline
   @param inputWidth RGB image width
@@ -104,12 +203,13 @@ public:
   @param outputWidth BGR image width
   @param outputHeight BGR image height
   @param mean ImageNet mean
+  @param filter How the image is sampled when resizing it
   @return CUDAPipeline configured to do the required image preprocessing
   */
-  static CUDAPipeline *createRGBImageNetPipeline(int inputWidth,
-                                                 int inputHeight,
-                                                 int outputWidth,
-                                                 int outputHeight, float3 mean);
+  static CUDAPipeline *
+  createRGBImageNetPipeline(int inputWidth, int inputHeight, int outputWidth,
+                            int outputHeight, float3 mean,
+                            cudaFilterMode filter = FILTER_POINT);
 
   /**
   @brief Create an RGBAf -> ImageNet preprocessing pipeline
@@ -118,13 +218,41 @@ public:
   @param outputWidth BGR image width
   @param outputHeight BGR image height
   @param mean ImageNet mean
+  @param filter How the image is sampled when resizing it
   @return CUDAPipeline configured to do the required image preprocessing
   */
   static CUDAPipeline *
   createRGBAfImageNetPipeline(int inputWidth, int inputHeight, int outputWidth,
-                              int outputHeight, float3 mean);
+                              int outputHeight, float3 mean,
+                              cudaFilterMode filter = FILTER_POINT);
+
+  /**
+  @brief Create an RGB -> ImageNet preprocessing pipeline which scales the
+  image to fit the output with its aspect ratio preserved, padding the rest
+  @param inputWidth RGB image width
+  @param inputHeight RGB image height
+  @param outputWidth BGR image width
+  @param outputHeight BGR image height
+  @param mean ImageNet mean
+  @param padding Pixel value of the padding, in the same BGR order as mean
+  @param filter How the image is sampled when resizing it
+  @return CUDAPipeline configured to do the required image preprocessing
+  */
+  static CUDAPipeline *
+  createRGBLetterboxPipeline(int inputWidth, int inputHeight, int outputWidth,
+                             int outputHeight, float3 mean, float3 padding,
+                             cudaFilterMode filter = FILTER_POINT);
 
   std::vector<CUDAPipeNode *> nodes;
+
+  /* Fusions applied to nodes by fuse() */
+  std::vector<PipelineFusion> fusions;
+
+  /* Latency of each node, indexed like nodes, once timing is enabled */
+  std::vector<LatencyHistogram *> nodeLatencies;
+
+private:
+  std::vector<cudaEvent_t> nodeEvents;
 };
 
 } // namespace jetson_tensorrt
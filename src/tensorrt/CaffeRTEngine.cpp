@@ -34,16 +34,18 @@
 #include "NvUtils.h"
 
 #include "CaffeRTEngine.h"
+#include "TensorRTBackend.h"
 
 using namespace nvinfer1;
 
 namespace jetson_tensorrt {
 
-CaffeRTEngine::CaffeRTEngine() : TensorRTEngine() {
-  parser = nvcaffeparser1::createCaffeParser();
-}
+CaffeRTEngine::CaffeRTEngine() : TensorRTEngine() {}
 
-CaffeRTEngine::~CaffeRTEngine() { parser->destroy(); }
+CaffeRTEngine::~CaffeRTEngine() {
+  // Builds in the background use the members of this engine
+  clearFamily();
+}
 
 void CaffeRTEngine::addInput(std::string layer, nvinfer1::Dims dims,
                              size_t eleSize) {
@@ -57,21 +59,47 @@ void CaffeRTEngine::addOutput(std::string layer, nvinfer1::Dims dims,
 
 void CaffeRTEngine::loadModel(std::string prototextPath, std::string modelPath,
                               size_t maxBatchSize, nvinfer1::DataType dataType,
-                              size_t maxNetworkSize) {
+                              size_t maxNetworkSize,
+                              nvinfer1::IInt8Calibrator *calibrator) {
+
+  ICudaEngine *engine = buildEngine(prototextPath, modelPath, maxBatchSize,
+                                    dataType, maxNetworkSize, calibrator);
+
+  this->dataType = dataType;
+  attachBackend(new TensorRTBackend(logger, engine), maxBatchSize);
+}
+
+ICudaEngine *CaffeRTEngine::buildEngine(std::string prototextPath,
+                                        std::string modelPath,
+                                        size_t maxBatchSize,
+                                        nvinfer1::DataType dataType,
+                                        size_t maxNetworkSize,
+                                        nvinfer1::IInt8Calibrator *calibrator) {
 
   if (networkInputs.size() == 0 || networkOutputs.size() == 0)
     throw std::invalid_argument(
         "Must add inputs and outputs before calling loadModel");
 
-  this->dataType = dataType;
-  this->maxBatchSize = maxBatchSize;
+  if (dataType == DataType::kINT8 && !calibrator)
+    throw std::invalid_argument("INT8 networks need a calibrator");
+
+  std::lock_guard<std::mutex> lock(buildMutex);
+
+  // Everything but the engine is released when building throws
+  TensorRTPtr<IBuilder> builder(createInferBuilder(logger));
+  TensorRTPtr<INetworkDefinition> network(builder->createNetwork());
 
-  IBuilder *builder = createInferBuilder(logger);
+  // The parser owns the weights of the network, so it lives until the
+  // engine is built
+  TensorRTPtr<nvcaffeparser1::ICaffeParser> parser(
+      nvcaffeparser1::createCaffeParser());
 
-  INetworkDefinition *network = builder->createNetwork();
+  // INT8 networks are built from float weights and calibrated
+  DataType weightType =
+      dataType == DataType::kINT8 ? DataType::kFLOAT : dataType;
 
   const nvcaffeparser1::IBlobNameToTensor *blobNameToTensor = parser->parse(
-      prototextPath.c_str(), modelPath.c_str(), *network, dataType);
+      prototextPath.c_str(), modelPath.c_str(), *network, weightType);
 
   if (dataType == DataType::kFLOAT) {
 
@@ -80,6 +108,7 @@ void CaffeRTEngine::loadModel(std::string prototextPath, std::string modelPath,
 
   } else if (dataType == DataType::kINT8) {
     builder->setInt8Mode(true);
+    builder->setInt8Calibrator(calibrator);
   }
 
   if (!blobNameToTensor)
@@ -95,7 +124,7 @@ void CaffeRTEngine::loadModel(std::string prototextPath, std::string modelPath,
   builder->setMaxBatchSize(maxBatchSize);
   builder->setMaxWorkspaceSize(maxNetworkSize);
 
-  engine = builder->buildCudaEngine(*network);
+  TensorRTPtr<ICudaEngine> engine(builder->buildCudaEngine(*network));
   if (!engine)
     throw std::runtime_error("Failed to create TensorRT engine");
 
@@ -113,14 +142,77 @@ void CaffeRTEngine::loadModel(std::string prototextPath, std::string modelPath,
                                     "was registered with addInput");
   }
 
-  /* Reclaim memory */
-  network->destroy();
-  builder->destroy();
-  parser->destroy();
+  return engine.release();
+}
+
+void CaffeRTEngine::loadModel(
+    EngineCache &cache, std::string prototextPath, std::string modelPath,
+    size_t maxBatchSize, nvinfer1::DataType dataType, size_t maxNetworkSize,
+    std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator) {
+
+  ExecutionBackend *loaded =
+      loadBackend(cache, prototextPath, modelPath, maxBatchSize, dataType,
+                  maxNetworkSize, calibrator);
 
-  context = engine->createExecutionContext();
+  this->dataType = dataType;
+  attachBackend(loaded, maxBatchSize);
+
+  // Networks for other batch sizes come from the same cache. The factory
+  // shares the calibrator, so it stays alive when the caller releases it.
+  setBackendFactory([this, cache, prototextPath, modelPath, dataType,
+                     maxNetworkSize, calibrator](size_t batchSize) mutable {
+    return loadBackend(cache, prototextPath, modelPath, batchSize, dataType,
+                       maxNetworkSize, calibrator);
+  });
+}
+
+ExecutionBackend *CaffeRTEngine::loadBackend(
+    EngineCache &cache, std::string prototextPath, std::string modelPath,
+    size_t maxBatchSize, nvinfer1::DataType dataType, size_t maxNetworkSize,
+    std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator) {
+
+  // Calibrating may write the table the key depends on, so the cache
+  // computes the key again after building
+  return cache.fetch(
+      [this, prototextPath, modelPath, maxBatchSize, dataType, maxNetworkSize,
+       calibrator]() {
+        return cacheKey(prototextPath, modelPath, maxBatchSize, dataType,
+                        maxNetworkSize, calibrator.get());
+      },
+      [this]() { return new TensorRTBackend(logger); },
+      [this, prototextPath, modelPath, maxBatchSize, dataType, maxNetworkSize,
+       calibrator]() {
+        return new TensorRTBackend(logger,
+                                   buildEngine(prototextPath, modelPath,
+                                               maxBatchSize, dataType,
+                                               maxNetworkSize,
+                                               calibrator.get()));
+      });
+}
+
+std::string CaffeRTEngine::cacheKey(std::string prototextPath,
+                                    std::string modelPath, size_t maxBatchSize,
+                                    nvinfer1::DataType dataType,
+                                    size_t maxNetworkSize,
+                                    nvinfer1::IInt8Calibrator *calibrator) {
+  EngineCacheKey key;
+  key.addFile(prototextPath);
+  key.addFile(modelPath);
+  key.addNetwork(networkInputs, networkOutputs);
+  key.addValue(maxBatchSize);
+  key.addValue((uint64_t)dataType);
+  key.addValue(maxNetworkSize);
+  key.addPlatform();
+
+  if (dataType == DataType::kINT8 && calibrator) {
+    size_t tableSize = 0;
+    const void *table = calibrator->readCalibrationCache(tableSize);
+    key.addValue(tableSize);
+    if (table)
+      key.addBytes(table, tableSize);
+  }
 
-  numBindings = engine->getNbBindings();
+  return key.str();
 }
 
 } // namespace jetson_tensorrt
@@ -28,12 +28,15 @@
 #ifndef CAFFERTENGINE_H_
 #define CAFFERTENGINE_H_
 
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "NvCaffeParser.h"
 #include "NvInfer.h"
 #include "NvUtils.h"
 
+#include "EngineCache.h"
 #include "TensorRTEngine.h"
 
 namespace jetson_tensorrt {
@@ -66,11 +69,40 @@ public:
    * TensorRT
    * @param	maxNetworkSize	Maximum amount of GPU RAM the Tensorflow graph
    * is allowed to use
+   * @param	calibrator	Provides calibration data for kINT8 networks
    */
   void loadModel(std::string prototextPath, std::string modelPath,
                  size_t maxBatchSize = 1,
                  nvinfer1::DataType dataType = nvinfer1::DataType::kFLOAT,
-                 size_t maxNetworkSize = (1 << 30));
+                 size_t maxNetworkSize = (1 << 30),
+                 nvinfer1::IInt8Calibrator *calibrator = NULL);
+
+  /**
+   * @brief	Loads a trained Caffe model from an engine cache, building and
+   * caching it if the cache has no engine for the exact model files, inputs,
+   * outputs, build settings, TensorRT version and GPU.
+   * @usage	Should be called after registering inputs and outputs with
+   * addInput() and addOutput(). Networks for the batch sizes passed to
+   * setBatchSizes() afterwards are loaded from and saved to the same cache.
+   * @param	cache	The engine cache to look in
+   * @param	prototextPath	Path to the models prototxt file
+   * @param	modelPath	Path to the .caffemodel file
+   * @param	maxBatchSize	The maximum number of records to run a forward
+   * network pass on
+   * @param	dataType	The data type of the network to load into
+   * TensorRT
+   * @param	maxNetworkSize	Maximum amount of GPU RAM the network is
+   * allowed to use
+   * @param	calibrator	Provides calibration data for kINT8 networks. Its
+   * calibration table is part of the cache key. Networks for other batch
+   * sizes are built with it too, so the engine keeps a reference to it.
+   */
+  void loadModel(EngineCache &cache, std::string prototextPath,
+                 std::string modelPath, size_t maxBatchSize = 1,
+                 nvinfer1::DataType dataType = nvinfer1::DataType::kFLOAT,
+                 size_t maxNetworkSize = (1 << 30),
+                 std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator =
+                     nullptr);
 
   /**
    * @brief	Registers an input to the Caffe network.
@@ -91,7 +123,26 @@ public:
   void addOutput(std::string layer, nvinfer1::Dims dims, size_t eleSize);
 
 private:
-  nvcaffeparser1::ICaffeParser *parser;
+  /* Networks of several batch sizes may be built at once */
+  std::mutex buildMutex;
+
+  nvinfer1::ICudaEngine *buildEngine(std::string prototextPath,
+                                     std::string modelPath,
+                                     size_t maxBatchSize,
+                                     nvinfer1::DataType dataType,
+                                     size_t maxNetworkSize,
+                                     nvinfer1::IInt8Calibrator *calibrator);
+
+  ExecutionBackend *
+  loadBackend(EngineCache &cache, std::string prototextPath,
+              std::string modelPath, size_t maxBatchSize,
+              nvinfer1::DataType dataType, size_t maxNetworkSize,
+              std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator);
+
+  std::string cacheKey(std::string prototextPath, std::string modelPath,
+                       size_t maxBatchSize, nvinfer1::DataType dataType,
+                       size_t maxNetworkSize,
+                       nvinfer1::IInt8Calibrator *calibrator);
 };
 
 } // namespace jetson_tensorrt
@@ -0,0 +1,166 @@
+/**
+ * @file	CalibrationImages.cpp
+ * @author	Carroll Vance
+ * @brief	Host side image sources for INT8 calibration
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <stdexcept>
+
+#include "CalibrationImages.h"
+
+namespace jetson_tensorrt {
+
+PPMDirectorySource::PPMDirectorySource(std::string directory) {
+  DIR *dir = opendir(directory.c_str());
+  if (!dir)
+    throw std::runtime_error("Unable to open calibration directory " +
+                             directory + ": " + std::string(strerror(errno)));
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ppm") == 0)
+      paths.push_back(directory + "/" + name);
+  }
+  closedir(dir);
+
+  // Directory order is arbitrary, calibration should be reproducible
+  std::sort(paths.begin(), paths.end());
+
+  next = 0;
+}
+
+bool PPMDirectorySource::read(HostImage &image) {
+  if (next >= paths.size())
+    return false;
+
+  readPPM(paths[next++], image);
+  return true;
+}
+
+void PPMDirectorySource::rewind() { next = 0; }
+
+size_t PPMDirectorySource::size() { return paths.size(); }
+
+/**
+ * @brief Reads the next header field of a PPM file, skipping comments
+ */
+static int readPPMField(std::istream &in) {
+  in >> std::ws;
+  while (in.peek() == '#') {
+    in.ignore(1 << 16, '\n');
+    in >> std::ws;
+  }
+
+  int value = -1;
+  in >> value;
+  return value;
+}
+
+void PPMDirectorySource::readPPM(std::string path, HostImage &image) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+    throw std::runtime_error("Unable to open " + path);
+
+  char magic[2];
+  in.read(magic, sizeof(magic));
+  if (!in.good() || magic[0] != 'P' || magic[1] != '6')
+    throw std::runtime_error(path + " is not a binary PPM file");
+
+  int width = readPPMField(in);
+  int height = readPPMField(in);
+  int maxValue = readPPMField(in);
+
+  if (width <= 0 || height <= 0)
+    throw std::runtime_error(path + " has invalid dimensions");
+  if (maxValue != 255)
+    throw std::runtime_error(path + " is not an 8 bit PPM file");
+
+  // Exactly one whitespace character separates the header from the pixels
+  in.get();
+
+  image.width = width;
+  image.height = height;
+  image.data.resize((size_t)width * height * 3);
+
+  in.read((char *)&image.data[0], image.data.size());
+  if (in.gcount() != (std::streamsize)image.data.size())
+    throw std::runtime_error(path + " is truncated");
+}
+
+FrameFileSource::FrameFileSource(std::string path, int width, int height)
+    : file(path, std::ios::binary) {
+
+  if (!file.is_open())
+    throw std::runtime_error("Unable to open frame file " + path);
+  if (width <= 0 || height <= 0)
+    throw std::invalid_argument("Frame dimensions must be positive");
+
+  this->width = width;
+  this->height = height;
+}
+
+bool FrameFileSource::read(HostImage &image) {
+  image.width = width;
+  image.height = height;
+  image.data.resize((size_t)width * height * 3);
+
+  file.read((char *)&image.data[0], image.data.size());
+
+  // A partial frame at the end of a recording is ignored
+  return file.gcount() == (std::streamsize)image.data.size();
+}
+
+void FrameFileSource::rewind() {
+  file.clear();
+  file.seekg(0, std::ios::beg);
+}
+
+ImageBatcher::ImageBatcher(ImageSource *images, size_t batchSize) {
+  if (batchSize == 0)
+    throw std::invalid_argument("Batch size must be positive");
+
+  this->images = images;
+  this->batchSize = batchSize;
+  batchCount = 0;
+}
+
+bool ImageBatcher::next(ImageFunction consume) {
+  for (size_t b = 0; b < batchSize; b++) {
+    if (!images->read(image))
+      return false;
+
+    consume(image, b);
+  }
+
+  batchCount++;
+  return true;
+}
+
+size_t ImageBatcher::batches() { return batchCount; }
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,172 @@
+/**
+ * @file	CalibrationImages.h
+ * @author	Carroll Vance
+ * @brief	Host side image sources for INT8 calibration
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CALIBRATIONIMAGES_H_
+#define CALIBRATIONIMAGES_H_
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief An 8 bit RGB image in host memory
+ */
+struct HostImage {
+  HostImage() {
+    width = 0;
+    height = 0;
+  }
+
+  int width;
+  int height;
+
+  /* Row major, 3 bytes per pixel, no row padding */
+  std::vector<unsigned char> data;
+};
+
+/**
+ * @brief Sequence of images which are read one at a time so large
+ * calibration sets never have to fit in memory
+ */
+class ImageSource {
+public:
+  virtual ~ImageSource() {}
+
+  /**
+   * @brief	Reads the next image
+   * @param	image	Image to read into, its buffer is reused when possible
+   * @return	False once every image has been read
+   */
+  virtual bool read(HostImage &image) = 0;
+
+  /**
+   * @brief	Starts reading from the first image again
+   */
+  virtual void rewind() = 0;
+};
+
+/**
+ * @brief Reads every binary (P6) .ppm file of a directory in name order
+ */
+class PPMDirectorySource : public ImageSource {
+public:
+  /**
+   * @brief	Lists the images of a directory
+   * @param	directory	Directory containing .ppm files
+   */
+  PPMDirectorySource(std::string directory);
+
+  bool read(HostImage &image);
+  void rewind();
+
+  /**
+   * @brief	Gets the number of images in the directory
+   * @return	Number of .ppm files
+   */
+  size_t size();
+
+  /**
+   * @brief	Decodes a binary PPM file with a maximum value of 255
+   * @param	path	Path to the file
+   * @param	image	Image to decode into
+   */
+  static void readPPM(std::string path, HostImage &image);
+
+private:
+  std::vector<std::string> paths;
+  size_t next;
+};
+
+/**
+ * @brief Reads fixed size RGB8 frames stored back to back in one file, i.e.
+ * the data of recorded sensor_msgs/Image messages
+ */
+class FrameFileSource : public ImageSource {
+public:
+  /**
+   * @brief	Opens a recorded frame file
+   * @param	path	Path to the file
+   * @param	width	Width of every frame
+   * @param	height	Height of every frame
+   */
+  FrameFileSource(std::string path, int width, int height);
+
+  bool read(HostImage &image);
+  void rewind();
+
+private:
+  std::ifstream file;
+  int width, height;
+};
+
+/**
+ * @brief Splits the images of a source into batches of a fixed size, which
+ * are handed out one image at a time
+ */
+class ImageBatcher {
+public:
+  /**
+   * @brief	Called with every image of a batch and its position in the batch
+   */
+  typedef std::function<void(const HostImage &image, size_t position)>
+      ImageFunction;
+
+  /**
+   * @brief	Creates a new ImageBatcher
+   * @param	images	Source of the images, must outlive the batcher
+   * @param	batchSize	Number of images in each batch
+   */
+  ImageBatcher(ImageSource *images, size_t batchSize);
+
+  /**
+   * @brief	Reads the next batch
+   * @usage	A partial last batch is dropped, its images are still passed to
+   * consume
+   * @param	consume	Called with every image of the batch in order
+   * @return	False once there is no complete batch left
+   */
+  bool next(ImageFunction consume);
+
+  /**
+   * @brief	Gets the number of complete batches read so far
+   * @return	Number of batches
+   */
+  size_t batches();
+
+private:
+  ImageSource *images;
+  size_t batchSize;
+  size_t batchCount;
+
+  HostImage image;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* CALIBRATIONIMAGES_H_ */
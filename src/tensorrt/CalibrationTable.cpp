@@ -0,0 +1,85 @@
+/**
+ * @file	CalibrationTable.cpp
+ * @author	Carroll Vance
+ * @brief	INT8 calibration table persisted on disk
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "AtomicFile.h"
+#include "CalibrationTable.h"
+
+namespace jetson_tensorrt {
+
+CalibrationTable::CalibrationTable(std::string path, std::string header) {
+  this->path = path;
+  this->header = header;
+}
+
+bool CalibrationTable::load() {
+  table.clear();
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  std::vector<char> loaded((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+
+  if (!loaded.empty() && !header.empty()) {
+    std::string found(loaded.begin(),
+                      std::find(loaded.begin(), loaded.end(), '\n'));
+    if (found != header)
+      throw std::runtime_error("Calibration table " + path + " starts with " +
+                               found + " instead of " + header);
+  }
+
+  table.swap(loaded);
+
+  return table.size() > 0;
+}
+
+void CalibrationTable::save(const void *table, size_t size) {
+  this->table.assign((const char *)table, (const char *)table + size);
+
+  // Other nodes calibrating the same model may read the table at any time
+  AtomicFile file(path);
+  file.stream().write((const char *)table, size);
+  file.commit();
+}
+
+const void *CalibrationTable::data() {
+  if (table.size() == 0)
+    return NULL;
+
+  return &table[0];
+}
+
+size_t CalibrationTable::size() { return table.size(); }
+
+std::string CalibrationTable::getPath() { return path; }
+
+} // namespace jetson_tensorrt
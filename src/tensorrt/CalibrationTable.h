@@ -0,0 +1,90 @@
+/**
+ * @file	CalibrationTable.h
+ * @author	Carroll Vance
+ * @brief	INT8 calibration table persisted on disk
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CALIBRATIONTABLE_H_
+#define CALIBRATIONTABLE_H_
+
+#include <string>
+#include <vector>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief The calibration table TensorRT produces for an INT8 network, kept
+ * in a file so later builds can skip calibration
+ */
+class CalibrationTable {
+public:
+  /**
+   * @brief	Creates a table backed by a file
+   * @param	path	Path to the calibration table file
+   * @param	header	First line of tables the calibrator can use, which
+   * names the TensorRT version and algorithm. Empty to accept any table.
+   */
+  CalibrationTable(std::string path, std::string header = "");
+
+  /**
+   * @brief	Reads the table from its file
+   * @usage	Throws an exception if the table starts with another header,
+   * the table is left empty then
+   * @return	False if there is no table yet
+   */
+  bool load();
+
+  /**
+   * @brief	Replaces the table and writes it to its file
+   * @param	table	Start of the table
+   * @param	size	Size of the table in bytes
+   */
+  void save(const void *table, size_t size);
+
+  /**
+   * @brief	Gets the loaded or saved table
+   * @return	Start of the table, NULL if there is none
+   */
+  const void *data();
+
+  /**
+   * @brief	Gets the size of the table
+   * @return	Size of the table in bytes
+   */
+  size_t size();
+
+  /**
+   * @brief	Gets the path of the table file
+   * @return	Path to the calibration table file
+   */
+  std::string getPath();
+
+private:
+  std::string path;
+  std::string header;
+  std::vector<char> table;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* CALIBRATIONTABLE_H_ */
@@ -26,7 +26,7 @@
  */
 
 #include <cassert>
-#include <fstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -41,12 +41,12 @@ namespace jetson_tensorrt {
 const std::string DIGITSClassifier::INPUT_NAME = "data";
 const std::string DIGITSClassifier::OUTPUT_NAME = "prob";
 
-DIGITSClassifier::DIGITSClassifier(std::string prototextPath,
-                                   std::string modelPath, std::string cachePath,
-                                   size_t nbChannels, size_t width,
-                                   size_t height, size_t nbClasses,
-                                   nvinfer1::DataType dataType,
-                                   size_t maxNetworkSize)
+DIGITSClassifier::DIGITSClassifier(
+    std::string prototextPath, std::string modelPath,
+    std::string cacheDirectory, size_t nbChannels, size_t width, size_t height,
+    size_t nbClasses, nvinfer1::DataType dataType, size_t maxNetworkSize,
+    size_t maxCacheEntries,
+    std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator, size_t maxBatchSize)
     : CaffeRTEngine() {
 
   addInput(INPUT_NAME, nvinfer1::DimsCHW(nbChannels, height, width),
@@ -57,13 +57,9 @@ DIGITSClassifier::DIGITSClassifier(std::string prototextPath,
   outputDims.d[0] = nbClasses;
   addOutput(OUTPUT_NAME, outputDims, sizeof(float));
 
-  std::ifstream infile(cachePath);
-  if (infile.good()) {
-    loadCache(cachePath);
-  } else {
-    loadModel(prototextPath, modelPath, 1, dataType, maxNetworkSize);
-    saveCache(cachePath);
-  }
+  EngineCache cache(cacheDirectory, maxCacheEntries);
+  loadModel(cache, prototextPath, modelPath, maxBatchSize, dataType,
+            maxNetworkSize, calibrator);
 
   this->modelWidth = width;
   this->modelHeight = height;
@@ -71,25 +67,96 @@ DIGITSClassifier::DIGITSClassifier(std::string prototextPath,
   this->nbClasses = nbClasses;
 }
 
+DIGITSClassifier::DIGITSClassifier(EngineBundle &bundle) : CaffeRTEngine() {
+  if (bundle.inputs.size() != 1 || bundle.inputs[0].dims.nbDims != 3 ||
+      bundle.outputs.size() != 1)
+    throw std::invalid_argument(
+        "Classifier bundles need one CHW input and one output");
+
+  loadBundle(bundle);
+
+  nvinfer1::Dims inputDims = networkInputs[0].dims;
+  this->modelDepth = inputDims.d[0];
+  this->modelHeight = inputDims.d[1];
+  this->modelWidth = inputDims.d[2];
+  this->nbClasses = networkOutputs[0].size() / networkOutputs[0].eleSize;
+}
+
 DIGITSClassifier::~DIGITSClassifier() {}
 
 std::vector<RTClassification>
 DIGITSClassifier::classify(LocatedExecutionMemory &inputs,
                            LocatedExecutionMemory &outputs, float threshold) {
+  return classifyBatch(inputs, outputs, threshold)[0];
+}
+
+std::vector<RTClassification>
+DIGITSClassifier::classify(RegisteredBindings &registered, float threshold) {
+  return classifyBatch(registered, threshold)[0];
+}
+
+std::vector<RTClassification>
+DIGITSClassifier::classify(BatchScheduler &scheduler,
+                           LocatedExecutionMemory &inputs,
+                           LocatedExecutionMemory &outputs, float threshold) {
+
+  // Execute inference together with the images of other threads
+  {
+    ScopedLatency timer(inferenceLatency);
+    scheduler.submit(inputs[0], outputs[0]).get();
+  }
+
+  return decode(outputs, 1, threshold)[0];
+}
+
+std::vector<std::vector<RTClassification>>
+DIGITSClassifier::classifyBatch(LocatedExecutionMemory &inputs,
+                                LocatedExecutionMemory &outputs,
+                                float threshold) {
+
+  // Execute inference
+  {
+    ScopedLatency timer(inferenceLatency);
+    predict(inputs, outputs);
+  }
+
+  return decode(outputs, inputs.size(), threshold);
+}
+
+std::vector<std::vector<RTClassification>>
+DIGITSClassifier::classifyBatch(RegisteredBindings &registered,
+                                float threshold) {
 
   // Execute inference
-  predict(inputs, outputs);
+  {
+    ScopedLatency timer(inferenceLatency);
+    predict(registered);
+  }
+
+  return decode(registered.outputs, registered.size(), threshold);
+}
+
+std::vector<std::vector<RTClassification>>
+DIGITSClassifier::decode(LocatedExecutionMemory &outputs, size_t batchCount,
+                         float threshold) {
+  ScopedLatency timer(decodeLatency);
+
+  std::vector<std::vector<RTClassification>> batchClassifications;
+
+  for (int b = 0; b < batchCount; b++) {
+    float *classProbabilities = (float *)outputs[b][0];
 
-  float *classProbabilities = (float *)outputs[0][0];
+    std::vector<RTClassification> classifications;
 
-  std::vector<RTClassification> classifications;
+    for (int c = 0; c < nbClasses; c++) {
+      if (classProbabilities[c] > threshold)
+        classifications.push_back(RTClassification(c, classProbabilities[c]));
+    }
 
-  for (int c = 0; c < nbClasses; c++) {
-    if (classProbabilities[c] > threshold)
-      classifications.push_back(RTClassification(c, classProbabilities[c]));
+    batchClassifications.push_back(classifications);
   }
 
-  return classifications;
+  return batchClassifications;
 }
 
 } // namespace jetson_tensorrt
@@ -28,6 +28,7 @@
 #ifndef CLASSIFICATIONRTENGINE_H_
 #define CLASSIFICATIONRTENGINE_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -35,8 +36,12 @@
 #include "NvInfer.h"
 #include "NvUtils.h"
 
+#include "BatchScheduler.h"
 #include "CaffeRTEngine.h"
+#include "EngineBundle.h"
+#include "LatencyHistogram.h"
 #include "NetworkDataTypes.h"
+#include "RegisteredBindings.h"
 
 namespace jetson_tensorrt {
 
@@ -52,8 +57,8 @@ public:
    * @brief	Creates a new instance of DIGITSClassifier
    * @param	prototextPath	Path to the .prototext file
    * @param	modelPath	Path to the .caffemodel file
-   * @param	cachePath	Path to the .tensorcache file which will be
-   * loaded instead of building the network if present
+   * @param	cacheDirectory	Engine cache directory which is checked for an
+   * engine built from the same model and settings before building one
    * @param	nbChannels	Number of channels in the input image. 1 for
    * greyscale, 3 for RGB
    * @param	width	Width of the input image
@@ -63,15 +68,31 @@ public:
    * network. Use FLOAT unless you know how it will effect your model.
    * @param	maxNetworkSize	Maximum size in bytes of the TensorRT network in
    * device memory
+   * @param	maxCacheEntries	Number of engines kept in the cache directory
+   * @param	calibrator	Provides calibration data when dataType is kINT8.
+   * The engine keeps a reference to build networks of other batch sizes.
+   * @param	maxBatchSize	Maximum number of images classified at once
    */
   DIGITSClassifier(std::string prototextPath, std::string modelPath,
-                   std::string cachePath = "classification.tensorcache",
+                   std::string cacheDirectory = "tensorcache",
                    size_t nbChannels = DEFAULT::DEPTH,
                    size_t width = DEFAULT::WIDTH,
                    size_t height = DEFAULT::HEIGHT,
                    size_t nbClasses = DEFAULT::CLASSES,
                    nvinfer1::DataType dataType = nvinfer1::DataType::kFLOAT,
-                   size_t maxNetworkSize = (1 << 30));
+                   size_t maxNetworkSize = (1 << 30),
+                   size_t maxCacheEntries = EngineCache::DEFAULT_MAX_ENTRIES,
+                   std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator =
+                       nullptr,
+                   size_t maxBatchSize = 1);
+
+  /**
+   * @brief	Creates a new instance of DIGITSClassifier from a network saved
+   * with saveBundle()
+   * @param	bundle	The opened bundle, which must hold one CHW input and
+   * one output of class probabilities
+   */
+  DIGITSClassifier(EngineBundle &bundle);
 
   /**
    * @brief	DIGITSClassifier destructor
@@ -91,6 +112,55 @@ public:
                                          LocatedExecutionMemory &outputs,
                                          float threshold = 0.5);
 
+  /**
+   * @brief	Classifies a single BGR format image from registered bindings.
+   * @param	registered	Bindings returned by registerBindings()
+   * @param	threshold	Minimum probability of a class detection for it
+   * to be returned as a result
+   * @return	vector of Classification objects above the threshold
+   */
+  std::vector<RTClassification> classify(RegisteredBindings &registered,
+                                         float threshold = 0.5);
+
+  /**
+   * @brief	Classifies a single BGR format image, batched with the images
+   * other threads submit to the same scheduler
+   * @param	scheduler	Scheduler running batches on this classifier
+   * @param	inputs	Graph inputs of the image in the input location of the
+   * scheduler
+   * @param	outputs	Graph outputs of the image in the output location of
+   * the scheduler
+   * @param	threshold	Minimum probability of a class detection for it
+   * to be returned as a result
+   * @return	vector of Classification objects above the threshold
+   */
+  std::vector<RTClassification> classify(BatchScheduler &scheduler,
+                                         LocatedExecutionMemory &inputs,
+                                         LocatedExecutionMemory &outputs,
+                                         float threshold = 0.5);
+
+  /**
+   * @brief	Classifies a batch of BGR format images.
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   * @param	threshold	Minimum probability of a class detection for it
+   * to be returned as a result
+   * @return	The classifications of every image indexed by [batchIndex]
+   */
+  std::vector<std::vector<RTClassification>>
+  classifyBatch(LocatedExecutionMemory &inputs,
+                LocatedExecutionMemory &outputs, float threshold = 0.5);
+
+  /**
+   * @brief	Classifies a batch of BGR format images from registered bindings.
+   * @param	registered	Bindings returned by registerBindings()
+   * @param	threshold	Minimum probability of a class detection for it
+   * to be returned as a result
+   * @return	The classifications of every image indexed by [batchIndex]
+   */
+  std::vector<std::vector<RTClassification>>
+  classifyBatch(RegisteredBindings &registered, float threshold = 0.5);
+
   static const size_t CHANNELS_GREYSCALE = 1;
   static const size_t CHANNELS_BGR = 3;
 
@@ -100,9 +170,18 @@ public:
 
   size_t nbClasses;
 
-private:
   static const std::string INPUT_NAME;
+
+  /* Time spent executing the network in classify() */
+  LatencyHistogram inferenceLatency;
+  /* Time spent thresholding the class probabilities */
+  LatencyHistogram decodeLatency;
+
+private:
   static const std::string OUTPUT_NAME;
+
+  std::vector<std::vector<RTClassification>>
+  decode(LocatedExecutionMemory &outputs, size_t batchCount, float threshold);
 };
 
 } // namespace jetson_tensorrt
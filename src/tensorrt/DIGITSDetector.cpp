@@ -25,8 +25,6 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
-#include <fstream>
-
 #include "DIGITSDetector.h"
 
 namespace jetson_tensorrt {
@@ -35,11 +33,12 @@ const std::string DIGITSDetector::INPUT_NAME = "data";
 const std::string DIGITSDetector::OUTPUT_COVERAGE_NAME = "coverage";
 const std::string DIGITSDetector::OUTPUT_BBOXES_NAME = "bboxes";
 
-DIGITSDetector::DIGITSDetector(std::string prototextPath, std::string modelPath,
-                               std::string cachePath, size_t nbChannels,
-                               size_t width, size_t height, size_t stride,
-                               size_t nbClasses, nvinfer1::DataType dataType,
-                               size_t maxNetworkSize)
+DIGITSDetector::DIGITSDetector(
+    std::string prototextPath, std::string modelPath,
+    std::string cacheDirectory, size_t nbChannels, size_t width, size_t height,
+    size_t stride, size_t nbClasses, nvinfer1::DataType dataType,
+    size_t maxNetworkSize, size_t maxCacheEntries,
+    std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator, size_t maxBatchSize)
     : CaffeRTEngine() {
 
   if (nbChannels != CHANNELS_BGR)
@@ -62,41 +61,120 @@ DIGITSDetector::DIGITSDetector(std::string prototextPath, std::string modelPath,
   outputDimsBboxes.d[2] = (size_t)(width / stride);
   addOutput(OUTPUT_BBOXES_NAME, outputDimsBboxes, sizeof(float));
 
-  std::ifstream infile(cachePath);
-  if (infile.good()) {
-    loadCache(cachePath);
-  } else {
-    loadModel(prototextPath, modelPath, 1, dataType, maxNetworkSize);
-    saveCache(cachePath);
-  }
+  EngineCache cache(cacheDirectory, maxCacheEntries);
+  loadModel(cache, prototextPath, modelPath, maxBatchSize, dataType,
+            maxNetworkSize, calibrator);
 
   this->modelWidth = width;
   this->modelHeight = height;
   this->modelDepth = nbChannels;
   this->nbClasses = nbClasses;
 
-  // Configure non-maximum suppression based on what we currently know
+  // Configure non-maximum suppression based on what we currently know.
+  // Regions are found in network input coordinates, the transform of each
+  // image maps them back to the original image.
+  suppressor.setupImage(width, height);
   suppressor.setupInput(width, height);
   suppressor.setupGrid((size_t)(width / stride), (size_t)(height / stride));
 }
 
+DIGITSDetector::DIGITSDetector(EngineBundle &bundle) : CaffeRTEngine() {
+  if (bundle.inputs.size() != 1 || bundle.inputs[0].dims.nbDims != 3 ||
+      bundle.outputs.size() != 2 || bundle.outputs[0].dims.nbDims != 3)
+    throw std::invalid_argument("Detector bundles need one CHW input and the "
+                                "coverage and bounding box outputs");
+
+  if (bundle.inputs[0].dims.d[0] != CHANNELS_BGR)
+    throw std::invalid_argument("Only BGR DetectNets are supported currently");
+
+  loadBundle(bundle);
+
+  nvinfer1::Dims inputDims = networkInputs[0].dims;
+  nvinfer1::Dims coverageDims = networkOutputs[0].dims;
+  this->modelDepth = inputDims.d[0];
+  this->modelHeight = inputDims.d[1];
+  this->modelWidth = inputDims.d[2];
+  this->nbClasses = coverageDims.d[0];
+
+  suppressor.setupImage(modelWidth, modelHeight);
+  suppressor.setupInput(modelWidth, modelHeight);
+  suppressor.setupGrid(coverageDims.d[2], coverageDims.d[1]);
+}
+
 DIGITSDetector::~DIGITSDetector() {}
 
 std::vector<RTClassifiedRegionOfInterest>
 DIGITSDetector::detect(LocatedExecutionMemory &inputs,
-                       LocatedExecutionMemory &outputs, float threshold) {
+                       LocatedExecutionMemory &outputs, float threshold,
+                       const ImageTransform &transform) {
+  return detectBatch(inputs, outputs, threshold, transform)[0];
+}
+
+std::vector<RTClassifiedRegionOfInterest>
+DIGITSDetector::detect(RegisteredBindings &registered, float threshold,
+                       const ImageTransform &transform) {
+  return detectBatch(registered, threshold, transform)[0];
+}
+
+std::vector<RTClassifiedRegionOfInterest>
+DIGITSDetector::detect(BatchScheduler &scheduler,
+                       LocatedExecutionMemory &inputs,
+                       LocatedExecutionMemory &outputs, float threshold,
+                       const ImageTransform &transform) {
+
+  // Execute inference together with the images of other threads
+  {
+    ScopedLatency timer(inferenceLatency);
+    scheduler.submit(inputs[0], outputs[0]).get();
+  }
+
+  return suppress(outputs, 1, threshold, transform)[0];
+}
+
+std::vector<std::vector<RTClassifiedRegionOfInterest>>
+DIGITSDetector::detectBatch(LocatedExecutionMemory &inputs,
+                            LocatedExecutionMemory &outputs,
+                            float threshold, const ImageTransform &transform) {
 
   // Execute inference
-  predict(inputs, outputs);
+  {
+    ScopedLatency timer(inferenceLatency);
+    predict(inputs, outputs);
+  }
 
-  float *coverage = (float *)outputs.batch[0][0];
-  float *bboxes = (float *)outputs.batch[0][1];
+  return suppress(outputs, inputs.size(), threshold, transform);
+}
 
-  // Configure non-maximum suppressor for the current image size
-  // TODO: convert bounding rects back to original image scale
-  suppressor.setupImage(modelWidth, modelHeight);
+std::vector<std::vector<RTClassifiedRegionOfInterest>>
+DIGITSDetector::detectBatch(RegisteredBindings &registered, float threshold,
+                            const ImageTransform &transform) {
+
+  // Execute inference
+  {
+    ScopedLatency timer(inferenceLatency);
+    predict(registered);
+  }
+
+  return suppress(registered.outputs, registered.size(), threshold,
+                  transform);
+}
+
+std::vector<std::vector<RTClassifiedRegionOfInterest>>
+DIGITSDetector::suppress(LocatedExecutionMemory &outputs, size_t batchCount,
+                         float threshold, const ImageTransform &transform) {
+  ScopedLatency timer(suppressionLatency);
+
+  std::vector<std::vector<RTClassifiedRegionOfInterest>> detections;
+
+  for (int b = 0; b < batchCount; b++) {
+    float *coverage = (float *)outputs[b][0];
+    float *bboxes = (float *)outputs[b][1];
+
+    detections.push_back(
+        suppressor.execute(coverage, bboxes, nbClasses, threshold, transform));
+  }
 
-  return suppressor.execute(coverage, bboxes, nbClasses, threshold);
+  return detections;
 }
 
 ClusteredNonMaximumSuppression::ClusteredNonMaximumSuppression() {
@@ -221,7 +299,8 @@ static void mergeRect(std::vector<float6> &rects, const float6 &rect) {
 std::vector<RTClassifiedRegionOfInterest>
 ClusteredNonMaximumSuppression::execute(float *coverage, float *bboxes,
                                         size_t nbClasses,
-                                        float coverageThreshold) {
+                                        float coverageThreshold,
+                                        const ImageTransform &transform) {
 
   // Cluster the rects
   std::vector<std::vector<float6>> rects;
@@ -270,10 +349,10 @@ ClusteredNonMaximumSuppression::execute(float *coverage, float *bboxes,
       const int classID = (size_t)r.u;
       const float coverage = r.v;
 
-      const size_t x1 = (size_t)r.x;
-      const size_t y1 = (size_t)r.y;
-      const size_t x2 = (size_t)r.z;
-      const size_t y2 = (size_t)r.w;
+      const size_t x1 = (size_t)transform.toImageX(r.x);
+      const size_t y1 = (size_t)transform.toImageY(r.y);
+      const size_t x2 = (size_t)transform.toImageX(r.z);
+      const size_t y2 = (size_t)transform.toImageY(r.w);
 
       classRectangles.push_back(RTClassifiedRegionOfInterest(
           classID, coverage, x1, y1, x2 - x1, y2 - y1));
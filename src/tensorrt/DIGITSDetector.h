@@ -28,6 +28,7 @@
 #ifndef DIGITS_DETECTOR_H_
 #define DIGITS_DETECTOR_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -35,9 +36,13 @@
 #include "NvInfer.h"
 #include "NvUtils.h"
 
+#include "BatchScheduler.h"
 #include "CUDAPipeline.h"
 #include "CaffeRTEngine.h"
+#include "EngineBundle.h"
+#include "LatencyHistogram.h"
 #include "NetworkDataTypes.h"
+#include "RegisteredBindings.h"
 
 namespace jetson_tensorrt {
 
@@ -92,11 +97,14 @@ public:
    * @param	nbClasses	Number of classes in the coverage map
    * @param	coverageThreshold	The threshold a detection region must
    * have to be considered
+   * @param	transform	How the preprocessing placed the original image in
+   * the network input, used to map the regions back to the image
    * @return	A vector of class tagged detection regions
    */
   std::vector<RTClassifiedRegionOfInterest>
   execute(float *coverage, float *bboxes, size_t nbClasses = 1,
-          float detectionThreshold = 0.5);
+          float detectionThreshold = 0.5,
+          const ImageTransform &transform = ImageTransform());
 
 private:
   bool imageReady, inputReady, gridReady;
@@ -124,8 +132,8 @@ public:
    * @brief	Creates a new instance of DIGITSDetector
    * @param	prototextPath	Path to the .prototext file
    * @param	modelPath	Path to the .caffemodel file
-   * @param	cachePath	Path to the .tensorcache file which will be
-   * loaded instead of building the network if present
+   * @param	cacheDirectory	Engine cache directory which is checked for an
+   * engine built from the same model and settings before building one
    * @param	nbChannels	Number of channels in the input image. 1 for
    * greyscale, 3 for RGB
    * @param	width	Width of the input image
@@ -136,15 +144,31 @@ public:
    * network. Use FLOAT unless you know how it will effect your model.
    * @param	maxNetworkSize	Maximum size in bytes of the TensorRT network in
    * device memory
+   * @param	maxCacheEntries	Number of engines kept in the cache directory
+   * @param	calibrator	Provides calibration data when dataType is kINT8.
+   * The engine keeps a reference to build networks of other batch sizes.
+   * @param	maxBatchSize	Maximum number of images detected at once
    */
   DIGITSDetector(std::string prototextPath, std::string modelPath,
-                 std::string cachePath = "detection.tensorcache",
+                 std::string cacheDirectory = "tensorcache",
                  size_t nbChannels = DEFAULT::DEPTH,
                  size_t width = DEFAULT::WIDTH, size_t height = DEFAULT::HEIGHT,
                  size_t stride = DEFAULT::STRIDE,
                  size_t nbClasses = DEFAULT::CLASSES,
                  nvinfer1::DataType dataType = nvinfer1::DataType::kFLOAT,
-                 size_t maxNetworkSize = (1 << 30));
+                 size_t maxNetworkSize = (1 << 30),
+                 size_t maxCacheEntries = EngineCache::DEFAULT_MAX_ENTRIES,
+                 std::shared_ptr<nvinfer1::IInt8Calibrator> calibrator =
+                     nullptr,
+                 size_t maxBatchSize = 1);
+
+  /**
+   * @brief	Creates a new instance of DIGITSDetector from a network saved
+   * with saveBundle()
+   * @param	bundle	The opened bundle, which must hold one BGR input and the
+   * coverage and bounding box outputs
+   */
+  DIGITSDetector(EngineBundle &bundle);
 
   /**
    * @brief DIGITSDetector destructor
@@ -156,11 +180,70 @@ public:
    * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
    * @param	outputs Graph inputs indexed by [batchIndex][inputIndex]
    * @param	threshold	Minimum coverage threshold for detected regions
+   * @param	transform	Transform of the preprocessing, the detections are in
+   * network input coordinates if it is the identity
    * @returned	vector of ClassRectangles representing the detections
    */
   std::vector<RTClassifiedRegionOfInterest>
   detect(LocatedExecutionMemory &inputs, LocatedExecutionMemory &outputs,
-         float threshold = 0.5);
+         float threshold = 0.5,
+         const ImageTransform &transform = ImageTransform());
+
+  /**
+   * @brief	Detects a single BGR format image from registered bindings.
+   * @param	registered	Bindings returned by registerBindings()
+   * @param	threshold	Minimum coverage threshold for detected regions
+   * @param	transform	Transform of the preprocessing, the detections are in
+   * network input coordinates if it is the identity
+   * @returned	vector of ClassRectangles representing the detections
+   */
+  std::vector<RTClassifiedRegionOfInterest>
+  detect(RegisteredBindings &registered, float threshold = 0.5,
+         const ImageTransform &transform = ImageTransform());
+
+  /**
+   * @brief	Detects a single BGR format image, batched with the images other
+   * threads submit to the same scheduler
+   * @param	scheduler	Scheduler running batches on this detector
+   * @param	inputs	Graph inputs of the image in the input location of the
+   * scheduler
+   * @param	outputs	Graph outputs of the image in the output location of
+   * the scheduler
+   * @param	threshold	Minimum coverage threshold for detected regions
+   * @param	transform	Transform of the preprocessing, the detections are in
+   * network input coordinates if it is the identity
+   * @returned	vector of ClassRectangles representing the detections
+   */
+  std::vector<RTClassifiedRegionOfInterest>
+  detect(BatchScheduler &scheduler, LocatedExecutionMemory &inputs,
+         LocatedExecutionMemory &outputs, float threshold = 0.5,
+         const ImageTransform &transform = ImageTransform());
+
+  /**
+   * @brief	Detects a batch of BGR format images.
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   * @param	threshold	Minimum coverage threshold for detected regions
+   * @param	transform	Transform of the preprocessing, shared by every
+   * image
+   * @returned	The detections of every image indexed by [batchIndex]
+   */
+  std::vector<std::vector<RTClassifiedRegionOfInterest>>
+  detectBatch(LocatedExecutionMemory &inputs, LocatedExecutionMemory &outputs,
+              float threshold = 0.5,
+              const ImageTransform &transform = ImageTransform());
+
+  /**
+   * @brief	Detects a batch of BGR format images from registered bindings.
+   * @param	registered	Bindings returned by registerBindings()
+   * @param	threshold	Minimum coverage threshold for detected regions
+   * @param	transform	Transform of the preprocessing, shared by every
+   * image
+   * @returned	The detections of every image indexed by [batchIndex]
+   */
+  std::vector<std::vector<RTClassifiedRegionOfInterest>>
+  detectBatch(RegisteredBindings &registered, float threshold = 0.5,
+              const ImageTransform &transform = ImageTransform());
 
   size_t modelWidth;
   size_t modelHeight;
@@ -171,12 +254,22 @@ public:
   static const size_t CHANNELS_GREYSCALE = 1;
   static const size_t CHANNELS_BGR = 3;
 
-private:
   static const std::string INPUT_NAME;
+
+  /* Time spent executing the network in detect() */
+  LatencyHistogram inferenceLatency;
+  /* Time spent clustering the network outputs into detections */
+  LatencyHistogram suppressionLatency;
+
+private:
   static const std::string OUTPUT_COVERAGE_NAME;
   static const std::string OUTPUT_BBOXES_NAME;
 
   ClusteredNonMaximumSuppression suppressor;
+
+  std::vector<std::vector<RTClassifiedRegionOfInterest>>
+  suppress(LocatedExecutionMemory &outputs, size_t batchCount,
+           float threshold, const ImageTransform &transform);
 };
 
 } /* namespace jetson_tensorrt */
@@ -0,0 +1,256 @@
+/**
+ * @file	EngineBundle.cpp
+ * @author	Carroll Vance
+ * @brief	Single file holding a network and everything needed to run it
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "AtomicFile.h"
+#include "EngineBundle.h"
+
+namespace jetson_tensorrt {
+
+/*
+ * Layout of a bundle, in host byte order:
+ *
+ *   char[8]  magic "JTBUNDLE"
+ *   uint32   format version
+ *   uint32   reserved
+ *   uint64   offset of the serialized network
+ *   uint64   size of the serialized network
+ *   ...      description, see writeDescription()
+ *   ...      padding up to the network offset
+ *   ...      serialized network
+ *
+ * Strings are a uint32 length followed by their bytes.
+ */
+static const char BUNDLE_MAGIC[8] = {'J', 'T', 'B', 'U', 'N', 'D', 'L', 'E'};
+static const uint64_t ENGINE_OFFSET_POSITION = 16;
+static const size_t ENGINE_ALIGNMENT = 64;
+
+/**
+ * @brief	Reads values from a mapped bundle, checking that each one lies
+ * within the file
+ */
+class BundleReader {
+public:
+  BundleReader(const void *data, size_t size, std::string path)
+      : position((const char *)data), end((const char *)data + size),
+        path(path) {}
+
+  void read(void *value, size_t size) {
+    if (size > (size_t)(end - position))
+      throw std::runtime_error("Engine bundle " + path + " is truncated");
+
+    memcpy(value, position, size);
+    position += size;
+  }
+
+  template <typename T> T read() {
+    T value;
+    read(&value, sizeof(T));
+    return value;
+  }
+
+  std::string readString() {
+    uint32_t length = read<uint32_t>();
+    if (length > (size_t)(end - position))
+      throw std::runtime_error("Engine bundle " + path + " is truncated");
+
+    std::string value(position, length);
+    position += length;
+    return value;
+  }
+
+  nvinfer1::Dims readDims() {
+    nvinfer1::Dims dims;
+    dims.nbDims = read<int32_t>();
+    if (dims.nbDims < 0 || dims.nbDims > nvinfer1::Dims::MAX_DIMS)
+      throw std::runtime_error("Engine bundle " + path +
+                               " has invalid dimensions");
+
+    for (int d = 0; d < dims.nbDims; d++) {
+      dims.d[d] = read<int32_t>();
+      dims.type[d] = (nvinfer1::DimensionType)read<int32_t>();
+    }
+
+    return dims;
+  }
+
+private:
+  const char *position;
+  const char *end;
+  std::string path;
+};
+
+template <typename T> static void write(std::ostream &out, T value) {
+  out.write((const char *)&value, sizeof(T));
+}
+
+static void writeString(std::ostream &out, std::string value) {
+  write<uint32_t>(out, value.size());
+  out.write(value.data(), value.size());
+}
+
+static void writeDims(std::ostream &out, nvinfer1::Dims dims) {
+  write<int32_t>(out, dims.nbDims);
+  for (int d = 0; d < dims.nbDims; d++) {
+    write<int32_t>(out, dims.d[d]);
+    write<int32_t>(out, (int32_t)dims.type[d]);
+  }
+}
+
+EngineBundle::EngineBundle() {
+  dataType = nvinfer1::DataType::kFLOAT;
+  maxBatchSize = 1;
+  mean[0] = mean[1] = mean[2] = 0;
+  channelOrder = "BGR";
+  encoding = "rgb8";
+
+  file = NULL;
+  engine = NULL;
+  engineBytes = 0;
+}
+
+EngineBundle::EngineBundle(std::string path) {
+  file = new MappedFile(path);
+
+  try {
+    BundleReader reader(file->data(), file->size(), path);
+
+    char magic[sizeof(BUNDLE_MAGIC)];
+    reader.read(magic, sizeof(magic));
+    if (memcmp(magic, BUNDLE_MAGIC, sizeof(magic)) != 0)
+      throw std::runtime_error(path + " is not an engine bundle");
+
+    uint32_t version = reader.read<uint32_t>();
+    if (version == 0 || version > VERSION)
+      throw std::runtime_error("Engine bundle " + path + " has version " +
+                               std::to_string(version) +
+                               ", only versions up to " +
+                               std::to_string(VERSION) + " can be read");
+    reader.read<uint32_t>();
+
+    uint64_t engineOffset = reader.read<uint64_t>();
+    uint64_t engineSize = reader.read<uint64_t>();
+    if (engineSize == 0 || engineOffset > file->size() ||
+        engineSize > file->size() - engineOffset)
+      throw std::runtime_error("Engine bundle " + path + " is truncated");
+
+    engine = (const char *)file->data() + engineOffset;
+    engineBytes = engineSize;
+
+    dataType = (nvinfer1::DataType)reader.read<int32_t>();
+    maxBatchSize = reader.read<uint32_t>();
+
+    uint32_t nbInputs = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < nbInputs; i++) {
+      std::string name = reader.readString();
+      nvinfer1::Dims dims = reader.readDims();
+      inputs.push_back(NetworkInput(name, dims, reader.read<uint32_t>()));
+    }
+
+    uint32_t nbOutputs = reader.read<uint32_t>();
+    for (uint32_t o = 0; o < nbOutputs; o++) {
+      std::string name = reader.readString();
+      nvinfer1::Dims dims = reader.readDims();
+      outputs.push_back(NetworkOutput(name, dims, reader.read<uint32_t>()));
+    }
+
+    uint32_t nbClasses = reader.read<uint32_t>();
+    for (uint32_t c = 0; c < nbClasses; c++)
+      classes.push_back(reader.readString());
+
+    for (int c = 0; c < 3; c++)
+      mean[c] = reader.read<float>();
+    channelOrder = reader.readString();
+    encoding = reader.readString();
+  } catch (...) {
+    delete file;
+    throw;
+  }
+}
+
+EngineBundle::~EngineBundle() { delete file; }
+
+void EngineBundle::save(std::string path, ExecutionBackend *backend) {
+  AtomicFile file(path);
+  std::ofstream &out = file.stream();
+
+  out.write(BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+  write<uint32_t>(out, VERSION);
+  write<uint32_t>(out, 0);
+
+  // The network offset and size are filled in once the network is written
+  write<uint64_t>(out, 0);
+  write<uint64_t>(out, 0);
+
+  write<int32_t>(out, (int32_t)dataType);
+  write<uint32_t>(out, maxBatchSize);
+
+  write<uint32_t>(out, inputs.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    writeString(out, inputs[i].name);
+    writeDims(out, inputs[i].dims);
+    write<uint32_t>(out, inputs[i].eleSize);
+  }
+
+  write<uint32_t>(out, outputs.size());
+  for (int o = 0; o < outputs.size(); o++) {
+    writeString(out, outputs[o].name);
+    writeDims(out, outputs[o].dims);
+    write<uint32_t>(out, outputs[o].eleSize);
+  }
+
+  write<uint32_t>(out, classes.size());
+  for (int c = 0; c < classes.size(); c++)
+    writeString(out, classes[c]);
+
+  for (int c = 0; c < 3; c++)
+    write<float>(out, mean[c]);
+  writeString(out, channelOrder);
+  writeString(out, encoding);
+
+  while (out.tellp() % ENGINE_ALIGNMENT != 0)
+    out.put(0);
+
+  uint64_t engineOffset = out.tellp();
+  backend->serialize(out);
+  uint64_t engineSize = (uint64_t)out.tellp() - engineOffset;
+
+  out.seekp(ENGINE_OFFSET_POSITION);
+  write<uint64_t>(out, engineOffset);
+  write<uint64_t>(out, engineSize);
+
+  file.commit();
+}
+
+const void *EngineBundle::engineData() { return engine; }
+
+size_t EngineBundle::engineSize() { return engineBytes; }
+
+} // namespace jetson_tensorrt
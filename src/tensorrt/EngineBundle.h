@@ -0,0 +1,118 @@
+/**
+ * @file	EngineBundle.h
+ * @author	Carroll Vance
+ * @brief	Single file holding a network and everything needed to run it
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ENGINEBUNDLE_H_
+#define ENGINEBUNDLE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "NvInfer.h"
+
+#include "ExecutionBackend.h"
+#include "MappedFile.h"
+#include "TensorRTEngine.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief A serialized network together with its bindings, the class labels it
+ * predicts and the preprocessing it was trained with, so that it can be run
+ * without any model specific code.
+ *
+ * Bundles start with a versioned description followed by the serialized
+ * network. Opening one maps the whole file once, the network is deserialized
+ * straight from the mapping.
+ */
+class EngineBundle {
+public:
+  static const uint32_t VERSION = 1;
+
+  /**
+   * @brief	Creates an empty bundle whose description is filled in before
+   * saving it with TensorRTEngine::saveBundle()
+   */
+  EngineBundle();
+
+  /**
+   * @brief	Opens a bundle and reads its description
+   * @usage	The network stays mapped until the bundle is destroyed
+   * @param	path	Path to the bundle file
+   */
+  EngineBundle(std::string path);
+
+  /**
+   * @brief	EngineBundle destructor
+   */
+  virtual ~EngineBundle();
+
+  /**
+   * @brief	Writes the description followed by a serialized network
+   * @param	path	Path to the bundle file
+   * @param	backend	Backend holding the network
+   */
+  void save(std::string path, ExecutionBackend *backend);
+
+  /**
+   * @brief	Gets the serialized network of an opened bundle
+   * @return	Start of the network in the mapping, NULL if not opened
+   */
+  const void *engineData();
+
+  /**
+   * @brief	Gets the size of the serialized network of an opened bundle
+   * @return	Size in bytes
+   */
+  size_t engineSize();
+
+  std::vector<NetworkInput> inputs;
+  std::vector<NetworkOutput> outputs;
+  nvinfer1::DataType dataType;
+  size_t maxBatchSize;
+
+  /* Labels of the predicted classes indexed by class ID */
+  std::vector<std::string> classes;
+
+  /* Mean subtracted from each channel of the network input */
+  float mean[3];
+  /* Channel order of the network input, i.e. "BGR" */
+  std::string channelOrder;
+  /* Encoding of the camera frames, i.e. "rgb8" */
+  std::string encoding;
+
+private:
+  EngineBundle(const EngineBundle &) = delete;
+  EngineBundle &operator=(const EngineBundle &) = delete;
+
+  MappedFile *file;
+  const void *engine;
+  size_t engineBytes;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* ENGINEBUNDLE_H_ */
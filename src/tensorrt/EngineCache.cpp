@@ -0,0 +1,333 @@
+/**
+ * @file	EngineCache.cpp
+ * @author	Carroll Vance
+ * @brief	Content addressed cache of built TensorRT engines
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cuda_runtime_api.h>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "AtomicFile.h"
+#include "EngineCache.h"
+#include "FileLock.h"
+#include "MappedFile.h"
+
+namespace jetson_tensorrt {
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+// Engines of several nodes in one process may be loaded in parallel, and
+// every index update is a read, modify, write of the same file. The lock
+// file of the index does the same across processes.
+static std::mutex indexMutex;
+
+EngineCacheKey::EngineCacheKey() { hash = FNV_OFFSET_BASIS; }
+
+void EngineCacheKey::addBytes(const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+}
+
+void EngineCacheKey::addFile(std::string path) {
+  MappedFile file(path);
+
+  addValue(file.size());
+  addBytes(file.data(), file.size());
+}
+
+void EngineCacheKey::addString(std::string value) {
+  addValue(value.size());
+  addBytes(value.data(), value.size());
+}
+
+void EngineCacheKey::addValue(uint64_t value) {
+  addBytes(&value, sizeof(value));
+}
+
+void EngineCacheKey::addNetwork(std::vector<NetworkInput> &inputs,
+                                std::vector<NetworkOutput> &outputs) {
+
+  addValue(inputs.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    addString(inputs[i].name);
+    addValue(inputs[i].eleSize);
+    addValue(inputs[i].dims.nbDims);
+    for (int d = 0; d < inputs[i].dims.nbDims; d++)
+      addValue(inputs[i].dims.d[d]);
+  }
+
+  addValue(outputs.size());
+  for (int o = 0; o < outputs.size(); o++) {
+    addString(outputs[o].name);
+    addValue(outputs[o].eleSize);
+    addValue(outputs[o].dims.nbDims);
+    for (int d = 0; d < outputs[o].dims.nbDims; d++)
+      addValue(outputs[o].dims.d[d]);
+  }
+}
+
+void EngineCacheKey::addPlatform() {
+  addValue(NV_TENSORRT_MAJOR);
+  addValue(NV_TENSORRT_MINOR);
+  addValue(NV_TENSORRT_PATCH);
+
+  int device;
+  cudaDeviceProp properties;
+  if (cudaGetDevice(&device) != 0 ||
+      cudaGetDeviceProperties(&properties, device) != 0)
+    throw std::runtime_error("Unable to query the CUDA device");
+
+  addString(properties.name);
+  addValue(properties.major);
+  addValue(properties.minor);
+}
+
+std::string EngineCacheKey::str() {
+  char text[17];
+  snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+  return std::string(text);
+}
+
+/**
+ * @brief Creates a directory and all of its parents
+ */
+static void makeDirectories(std::string path) {
+  for (size_t slash = path.find('/', 1); slash != std::string::npos;
+       slash = path.find('/', slash + 1))
+    mkdir(path.substr(0, slash).c_str(), 0755);
+
+  if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST)
+    throw std::runtime_error("Unable to create cache directory " + path +
+                             ": " + std::string(strerror(errno)));
+}
+
+EngineCache::EngineCache(std::string directory, size_t maxEntries) {
+  if (maxEntries == 0)
+    throw std::invalid_argument("Engine cache must hold at least one entry");
+
+  this->directory = directory;
+  this->maxEntries = maxEntries;
+
+  makeDirectories(directory);
+}
+
+std::string EngineCache::entryPath(std::string key) {
+  return directory + "/" + key + ".tensorcache";
+}
+
+bool EngineCache::lookup(std::string key) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  FileLock indexLock(lockPath("index"));
+  std::map<std::string, uint64_t> index = readIndex();
+
+  std::ifstream entry(entryPath(key));
+  if (!entry.good()) {
+    // Drop entries whose file was deleted behind our back
+    if (index.erase(key) > 0)
+      writeIndex(index);
+    return false;
+  }
+
+  index[key] = nextUse(index);
+  writeIndex(index);
+
+  return true;
+}
+
+void EngineCache::insert(std::string key) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  FileLock indexLock(lockPath("index"));
+  std::map<std::string, uint64_t> index = readIndex();
+  index[key] = nextUse(index);
+
+  while (index.size() > maxEntries) {
+    std::map<std::string, uint64_t>::iterator oldest = index.begin();
+    for (std::map<std::string, uint64_t>::iterator it = index.begin();
+         it != index.end(); it++)
+      if (it->second < oldest->second)
+        oldest = it;
+
+    std::remove(entryPath(oldest->first).c_str());
+    index.erase(oldest);
+  }
+
+  writeIndex(index);
+}
+
+void EngineCache::remove(std::string key) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  FileLock indexLock(lockPath("index"));
+  std::map<std::string, uint64_t> index = readIndex();
+
+  std::remove(entryPath(key).c_str());
+  index.erase(key);
+
+  writeIndex(index);
+}
+
+void EngineCache::save(std::string key, ExecutionBackend *backend) {
+  AtomicFile entry(entryPath(key));
+  backend->serialize(entry.stream());
+  entry.commit();
+
+  insert(key);
+}
+
+ExecutionBackend *
+EngineCache::fetch(std::function<std::string()> key,
+                   std::function<ExecutionBackend *()> create,
+                   std::function<ExecutionBackend *()> build) {
+
+  // Hashing the key may read the whole model, so it is only done again
+  // when building changed what it depends on
+  std::string requested = key();
+
+  ExecutionBackend *cached = loadEntry(requested, create);
+  if (cached)
+    return cached;
+
+  // Processes started together would otherwise all build the same engine.
+  // Whoever gets the lock of the key first builds, the rest find its entry
+  // afterwards. Engines with other keys are built at the same time.
+  FileLock buildLock(lockPath(requested));
+
+  cached = loadEntry(requested, create);
+  if (cached) {
+    buildLock.remove();
+    return cached;
+  }
+
+  ExecutionBackend *built = build();
+  try {
+    save(key(), built);
+  } catch (...) {
+    delete built;
+    throw;
+  }
+
+  // Nobody needs the lock once the entry exists
+  buildLock.remove();
+
+  return built;
+}
+
+ExecutionBackend *
+EngineCache::loadEntry(std::string key,
+                       std::function<ExecutionBackend *()> &create) {
+  if (!lookup(key))
+    return NULL;
+
+  std::string path = entryPath(key);
+
+  struct stat entryStat;
+  if (stat(path.c_str(), &entryStat) != 0) {
+    int statError = errno;
+
+    // Evicted by another process since the lookup
+    if (statError == ENOENT)
+      return NULL;
+
+    throw std::runtime_error("Unable to stat " + path + ": " +
+                             std::string(strerror(statError)));
+  }
+
+  // Entries are renamed into place once complete, so an empty one was
+  // truncated afterwards
+  if (entryStat.st_size == 0) {
+    remove(key);
+    return NULL;
+  }
+
+  ExecutionBackend *cached = create();
+  try {
+    // Deserialize straight from the page cache
+    MappedFile entry(path);
+    cached->load(entry.data(), entry.size());
+    return cached;
+  } catch (std::invalid_argument &e) {
+    // The backend rejected the data, so the entry is corrupt or was written
+    // in another format. It is rebuilt like a missing one.
+    delete cached;
+    remove(key);
+    return NULL;
+  } catch (...) {
+    // Anything else, i.e. running out of memory, says nothing about the
+    // entry, so it is kept
+    delete cached;
+    throw;
+  }
+}
+
+std::string EngineCache::indexPath() { return directory + "/index"; }
+
+std::string EngineCache::lockPath(std::string name) {
+  return directory + "/" + name + ".lock";
+}
+
+std::map<std::string, uint64_t> EngineCache::readIndex() {
+  std::map<std::string, uint64_t> index;
+
+  // Each line holds a key and the sequence number of its last use
+  std::ifstream file(indexPath());
+  std::string key;
+  uint64_t lastUse;
+  while (file >> key >> lastUse)
+    index[key] = lastUse;
+
+  return index;
+}
+
+void EngineCache::writeIndex(std::map<std::string, uint64_t> &index) {
+  AtomicFile file(indexPath());
+
+  for (std::map<std::string, uint64_t>::iterator it = index.begin();
+       it != index.end(); it++)
+    file.stream() << it->first << " " << it->second << "\n";
+
+  file.commit();
+}
+
+uint64_t EngineCache::nextUse(std::map<std::string, uint64_t> &index) {
+  uint64_t latest = 0;
+
+  for (std::map<std::string, uint64_t>::iterator it = index.begin();
+       it != index.end(); it++)
+    if (it->second > latest)
+      latest = it->second;
+
+  return latest + 1;
+}
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,193 @@
+/**
+ * @file	EngineCache.h
+ * @author	Carroll Vance
+ * @brief	Content addressed cache of built TensorRT engines
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ENGINECACHE_H_
+#define ENGINECACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "NvInfer.h"
+
+#include "ExecutionBackend.h"
+#include "TensorRTEngine.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Accumulates everything a built engine depends on into a 64 bit
+ * FNV-1a hash which identifies the engine in an EngineCache
+ */
+class EngineCacheKey {
+public:
+  /**
+   * @brief	Creates an empty key
+   */
+  EngineCacheKey();
+
+  /**
+   * @brief	Adds raw bytes to the key
+   * @param	data	Start of the bytes
+   * @param	size	Number of bytes
+   */
+  void addBytes(const void *data, size_t size);
+
+  /**
+   * @brief	Adds the contents of a file to the key
+   * @param	path	Path to the file
+   */
+  void addFile(std::string path);
+
+  /**
+   * @brief	Adds a string to the key
+   * @param	value	The string, including its length
+   */
+  void addString(std::string value);
+
+  /**
+   * @brief	Adds an integer to the key
+   * @param	value	The integer
+   */
+  void addValue(uint64_t value);
+
+  /**
+   * @brief	Adds the layer names, dimensions and element sizes of a network
+   * @param	inputs	Inputs of the network
+   * @param	outputs	Outputs of the network
+   */
+  void addNetwork(std::vector<NetworkInput> &inputs,
+                  std::vector<NetworkOutput> &outputs);
+
+  /**
+   * @brief	Adds the TensorRT version and the current CUDA device, since
+   * built engines only run where they were built
+   */
+  void addPlatform();
+
+  /**
+   * @brief	Gets the key as text
+   * @return	16 hexadecimal digits
+   */
+  std::string str();
+
+private:
+  uint64_t hash;
+};
+
+/**
+ * @brief Directory of serialized engines named by their EngineCacheKey.
+ *
+ * A small index file records when each entry was last used so that the least
+ * recently used entries are evicted once the cache holds more than
+ * maxEntries engines. Entries never go stale, a changed model simply hashes
+ * to a new key and the old entry ages out.
+ *
+ * Several processes may share a cache. The index is guarded by a lock file,
+ * files are replaced by renaming complete temporary files, and fetch() lets
+ * one process build a missing engine while the others wait for it.
+ */
+class EngineCache {
+public:
+  static const size_t DEFAULT_MAX_ENTRIES = 4;
+
+  /**
+   * @brief	Opens a cache directory, creating it if it does not exist
+   * @param	directory	Directory holding the engines and the index
+   * @param	maxEntries	Number of engines kept before evicting
+   */
+  EngineCache(std::string directory,
+              size_t maxEntries = DEFAULT_MAX_ENTRIES);
+
+  /**
+   * @brief	Gets the path an engine is stored at
+   * @param	key	Key of the engine
+   * @return	Path of the engine file
+   */
+  std::string entryPath(std::string key);
+
+  /**
+   * @brief	Looks up an engine and marks it as the most recently used
+   * @param	key	Key of the engine
+   * @return	True if the engine file is in the cache
+   */
+  bool lookup(std::string key);
+
+  /**
+   * @brief	Records an engine which was saved to entryPath() and evicts the
+   * least recently used engines beyond maxEntries
+   * @param	key	Key of the engine
+   */
+  void insert(std::string key);
+
+  /**
+   * @brief	Removes an engine from the cache, i.e. when it is corrupt
+   * @param	key	Key of the engine
+   */
+  void remove(std::string key);
+
+  /**
+   * @brief	Serializes an engine to entryPath() and records it with insert()
+   * @usage	Readers never see a partially written engine
+   * @param	key	Key of the engine
+   * @param	backend	Backend holding the engine
+   */
+  void save(std::string key, ExecutionBackend *backend);
+
+  /**
+   * @brief	Loads an engine, building and saving it if it is not cached.
+   * Only one thread or process builds an engine with the same key at a time,
+   * the others wait and then load what it saved.
+   * @param	key	Computes the key of the engine. The key the engine is
+   * looked up and locked with is computed once, and it is only computed
+   * again to save a built engine, since building may change what the key
+   * depends on, i.e. the calibration table.
+   * @param	create	Creates an empty backend to load a cached engine into
+   * @param	build	Builds the engine if it is not cached
+   * @return	The backend holding the engine, owned by the caller
+   */
+  ExecutionBackend *fetch(std::function<std::string()> key,
+                          std::function<ExecutionBackend *()> create,
+                          std::function<ExecutionBackend *()> build);
+
+private:
+  std::string directory;
+  size_t maxEntries;
+
+  std::string indexPath();
+  std::string lockPath(std::string name);
+  ExecutionBackend *
+  loadEntry(std::string key, std::function<ExecutionBackend *()> &create);
+  std::map<std::string, uint64_t> readIndex();
+  void writeIndex(std::map<std::string, uint64_t> &index);
+  uint64_t nextUse(std::map<std::string, uint64_t> &index);
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* ENGINECACHE_H_ */
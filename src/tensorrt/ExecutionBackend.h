@@ -0,0 +1,205 @@
+/**
+ * @file	ExecutionBackend.h
+ * @author	Carroll Vance
+ * @brief	Interface between TensorRTEngine and an inference runtime
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EXECUTIONBACKEND_H_
+#define EXECUTIONBACKEND_H_
+
+#include <functional>
+#include <ostream>
+
+#include "BackendTypes.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Executes inference for a loaded network. Owns any per execution
+ * state, so one context must only be used by one thread at a time.
+ */
+class ExecutionContext {
+public:
+  /**
+   * @brief	ExecutionContext destructor
+   */
+  virtual ~ExecutionContext();
+
+  /**
+   * @brief	Synchronously runs inference on a batch
+   * @param	batchSize	Number of records in the batch
+   * @param	bindings	Device pointers for every binding of the network
+   */
+  virtual void execute(int batchSize, void **bindings) = 0;
+
+  /**
+   * @brief	Enqueues inference on a batch and returns immediately
+   * @param	batchSize	Number of records in the batch
+   * @param	bindings	Device pointers for every binding of the network
+   * @param	stream	The stream to enqueue the inference on
+   */
+  virtual void enqueue(int batchSize, void **bindings,
+                       cudaStream_t stream) = 0;
+
+  /**
+   * @brief	Reports the time of every layer of synchronous executions
+   * @param	profiler	The profiler to report to, NULL to stop profiling
+   */
+  virtual void setProfiler(nvinfer1::IProfiler *profiler) = 0;
+
+  /**
+   * @brief	Points a context created with createSharedContext() at the
+   * device memory it executes in
+   * @usage	Contexts which own their memory ignore it
+   * @param	workspace	At least getWorkspaceSize() bytes of device memory
+   */
+  virtual void setWorkspace(void *workspace);
+};
+
+/**
+ * @brief Loads, serializes and executes a network and manages the memory its
+ * bindings live in
+ */
+class ExecutionBackend {
+public:
+  /**
+   * @brief	ExecutionBackend destructor
+   */
+  virtual ~ExecutionBackend();
+
+  /**
+   * @brief	Loads a network from serialized data
+   * @usage	Throws std::invalid_argument if the data is not a network of
+   * this backend, which makes EngineCache rebuild the entry
+   * @param	blob	Serialized network produced by serialize()
+   * @param	size	Size of the serialized network in bytes
+   */
+  virtual void load(const void *blob, size_t size) = 0;
+
+  /**
+   * @brief	Serializes the loaded network
+   * @param	out	Stream the serialized network is written to
+   */
+  virtual void serialize(std::ostream &out) = 0;
+
+  /**
+   * @brief	Creates a new execution context for the loaded network
+   * @return	The context, owned by the caller
+   */
+  virtual ExecutionContext *createContext() = 0;
+
+  /**
+   * @brief	Creates a new execution context which does not own the device
+   * memory it executes in
+   * @usage	The context must be given a workspace with setWorkspace() before
+   * every execution. Backends which cannot run in external memory return an
+   * ordinary context.
+   * @return	The context, owned by the caller
+   */
+  virtual ExecutionContext *createSharedContext();
+
+  /**
+   * @brief	Gets the device memory a context of the loaded network executes
+   * in
+   * @return	Size in bytes, 0 if contexts always own their memory
+   */
+  virtual size_t getWorkspaceSize();
+
+  /**
+   * @brief	Gets the number of bindings of the loaded network
+   * @return	Number of inputs and outputs
+   */
+  virtual int getNbBindings() = 0;
+
+  /**
+   * @brief	Gets whether a binding is an input
+   * @param	index	Binding index
+   * @return	true if the binding is an input, false if it is an output
+   */
+  virtual bool bindingIsInput(int index) = 0;
+
+  /**
+   * @brief	Gets the dimensions of a binding
+   * @param	index	Binding index
+   * @return	Dimensions of the binding
+   */
+  virtual nvinfer1::Dims getBindingDimensions(int index) = 0;
+
+  /**
+   * @brief	Allocates memory a binding can be executed from
+   * @param	size	Size of the allocation in bytes
+   * @return	Pointer to the allocation
+   */
+  virtual void *allocBinding(size_t size) = 0;
+
+  /**
+   * @brief	Frees memory allocated with allocBinding()
+   * @param	binding	Pointer returned by allocBinding()
+   */
+  virtual void freeBinding(void *binding) = 0;
+
+  /**
+   * @brief	Gets the pointer a binding uses for MAPPED host memory
+   * @param	host	Host pointer of the mapped allocation
+   * @return	Pointer which can be passed as a binding
+   */
+  virtual void *mapBinding(void *host) = 0;
+
+  /**
+   * @brief	Copies memory into a binding
+   * @param	binding	Destination binding memory
+   * @param	host	Source memory, host or device when the platform has
+   * unified addressing
+   * @param	size	Number of bytes to copy
+   * @param	stream	Stream to copy on when async is set
+   * @param	async	Whether to enqueue the copy instead of blocking
+   */
+  virtual void copyToBinding(void *binding, const void *host, size_t size,
+                             cudaStream_t stream, bool async) = 0;
+
+  /**
+   * @brief	Copies a binding back into memory
+   * @param	host	Destination memory, host or device when the platform has
+   * unified addressing
+   * @param	binding	Source binding memory
+   * @param	size	Number of bytes to copy
+   * @param	stream	Stream to copy on when async is set
+   * @param	async	Whether to enqueue the copy instead of blocking
+   */
+  virtual void copyFromBinding(void *host, const void *binding, size_t size,
+                               cudaStream_t stream, bool async) = 0;
+
+  /**
+   * @brief	Invokes a callback once all work enqueued on a stream so far has
+   * completed
+   * @param	stream	The stream to wait on
+   * @param	callback	Called with the stream status. Must not call back
+   * into the backend.
+   */
+  virtual void addCallback(cudaStream_t stream,
+                           std::function<void(cudaError_t)> callback) = 0;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* EXECUTIONBACKEND_H_ */
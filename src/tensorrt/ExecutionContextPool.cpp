@@ -0,0 +1,143 @@
+/**
+ * @file	ExecutionContextPool.cpp
+ * @author	Carroll Vance
+ * @brief	Pool of execution contexts sharing one loaded network
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdexcept>
+
+#include "ExecutionContextPool.h"
+
+namespace jetson_tensorrt {
+
+ExecutionContextPool::ExecutionContextPool() { backend = NULL; }
+
+ExecutionContextPool::~ExecutionContextPool() { destroy(); }
+
+void ExecutionContextPool::create(ExecutionBackend *backend,
+                                  size_t maxBatchSize, size_t size,
+                                  bool sharedWorkspace) {
+
+  if (size == 0)
+    throw std::invalid_argument("Context pool must hold at least one context");
+
+  destroy();
+
+  // The pool stays empty unless every context could be created
+  std::vector<ExecutionSlot *> created;
+  try {
+    for (size_t s = 0; s < size; s++) {
+      created.push_back(new ExecutionSlot());
+      created.back()->backend = backend;
+      created.back()->maxBatchSize = maxBatchSize;
+      created.back()->context = sharedWorkspace
+                                    ? backend->createSharedContext()
+                                    : backend->createContext();
+    }
+  } catch (...) {
+    for (int s = 0; s < created.size(); s++) {
+      delete created[s]->context;
+      delete created[s];
+    }
+    throw;
+  }
+
+  std::unique_lock<std::mutex> lock(poolMutex);
+
+  this->backend = backend;
+  slots = created;
+  available = created;
+}
+
+void ExecutionContextPool::destroy() {
+  std::unique_lock<std::mutex> lock(poolMutex);
+
+  slotReleased.wait(lock,
+                    [this]() { return available.size() == slots.size(); });
+
+  for (int s = 0; s < slots.size(); s++) {
+    ExecutionSlot *slot = slots[s];
+
+    for (int b = 0; b < slot->preAllocatedGPUBuffers.size(); b++)
+      if (slot->preAllocatedGPUBuffers[b] != nullptr)
+        backend->freeBinding(slot->preAllocatedGPUBuffers[b]);
+
+    delete slot->context;
+    delete slot;
+  }
+
+  slots.clear();
+  available.clear();
+}
+
+ExecutionSlot *ExecutionContextPool::acquire() {
+  std::unique_lock<std::mutex> lock(poolMutex);
+
+  if (slots.size() == 0)
+    throw std::runtime_error("No network has been loaded");
+
+  slotReleased.wait(lock, [this]() { return available.size() > 0; });
+
+  ExecutionSlot *slot = available.back();
+  available.pop_back();
+
+  return slot;
+}
+
+void ExecutionContextPool::release(ExecutionSlot *slot) {
+  {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    available.push_back(slot);
+  }
+  slotReleased.notify_all();
+}
+
+size_t ExecutionContextPool::size() {
+  std::unique_lock<std::mutex> lock(poolMutex);
+  return slots.size();
+}
+
+void ExecutionContextPool::setProfiler(nvinfer1::IProfiler *profiler) {
+  std::unique_lock<std::mutex> lock(poolMutex);
+
+  for (int s = 0; s < slots.size(); s++)
+    slots[s]->context->setProfiler(profiler);
+}
+
+PooledExecutionSlot::PooledExecutionSlot(ExecutionContextPool &pool)
+    : pool(pool) {
+  slot = pool.acquire();
+}
+
+PooledExecutionSlot::~PooledExecutionSlot() {
+  if (slot)
+    pool.release(slot);
+}
+
+ExecutionSlot *PooledExecutionSlot::detach() {
+  ExecutionSlot *detached = slot;
+  slot = NULL;
+  return detached;
+}
+
+} // namespace jetson_tensorrt
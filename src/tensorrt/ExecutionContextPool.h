@@ -0,0 +1,159 @@
+/**
+ * @file	ExecutionContextPool.h
+ * @author	Carroll Vance
+ * @brief	Pool of execution contexts sharing one loaded network
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EXECUTIONCONTEXTPOOL_H_
+#define EXECUTIONCONTEXTPOOL_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "ExecutionBackend.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief An execution context together with the network it executes and the
+ * binding buffers batches which are not contiguous device memory are copied
+ * through when running on it
+ */
+struct ExecutionSlot {
+  ExecutionSlot() {
+    context = NULL;
+    backend = NULL;
+    maxBatchSize = 0;
+  }
+
+  ExecutionContext *context;
+
+  /* The network of the context and the largest batch it was built for */
+  ExecutionBackend *backend;
+  size_t maxBatchSize;
+
+  /* One buffer per binding holding a whole batch, NULL until first used */
+  std::vector<void *> preAllocatedGPUBuffers;
+};
+
+/**
+ * @brief Fixed size pool of ExecutionSlots which all execute the network of
+ * one ExecutionBackend. Each slot is used by at most one caller at a time.
+ */
+class ExecutionContextPool {
+public:
+  /**
+   * @brief	Creates an empty ExecutionContextPool
+   */
+  ExecutionContextPool();
+
+  /**
+   * @brief	ExecutionContextPool destructor
+   */
+  virtual ~ExecutionContextPool();
+
+  /**
+   * @brief	Creates the contexts of the pool
+   * @usage	Any previous contexts are destroyed first
+   * @param	backend	The backend to create contexts from
+   * @param	maxBatchSize	Largest batch the network of the backend runs
+   * @param	size	Number of contexts in the pool
+   * @param	sharedWorkspace	Create contexts without device memory, which
+   * execute in a SharedWorkspace
+   */
+  void create(ExecutionBackend *backend, size_t maxBatchSize, size_t size,
+              bool sharedWorkspace = false);
+
+  /**
+   * @brief	Destroys every context and its buffers
+   * @usage	Blocks until every acquired slot has been released
+   */
+  void destroy();
+
+  /**
+   * @brief	Checks a slot out of the pool, blocking until one is available
+   * @return	The slot, which must be returned with release()
+   */
+  ExecutionSlot *acquire();
+
+  /**
+   * @brief	Returns a slot to the pool
+   * @param	slot	A slot returned by acquire()
+   */
+  void release(ExecutionSlot *slot);
+
+  /**
+   * @brief	Gets the number of contexts in the pool
+   * @return	Number of contexts
+   */
+  size_t size();
+
+  /**
+   * @brief	Sets the profiler of every context in the pool
+   * @usage	Should be called while no predictions are running
+   * @param	profiler	The profiler to report to, NULL to stop profiling
+   */
+  void setProfiler(nvinfer1::IProfiler *profiler);
+
+private:
+  ExecutionBackend *backend;
+
+  std::vector<ExecutionSlot *> slots;
+  std::vector<ExecutionSlot *> available;
+
+  std::mutex poolMutex;
+  std::condition_variable slotReleased;
+};
+
+/**
+ * @brief Scoped checkout of an ExecutionSlot
+ */
+class PooledExecutionSlot {
+public:
+  /**
+   * @brief	Acquires a slot from a pool
+   * @param	pool	The pool to acquire from
+   */
+  PooledExecutionSlot(ExecutionContextPool &pool);
+
+  /**
+   * @brief	Returns the slot to the pool unless it was detached
+   */
+  virtual ~PooledExecutionSlot();
+
+  /**
+   * @brief	Stops the slot from being returned on destruction
+   * @return	The slot, which now has to be released by the caller
+   */
+  ExecutionSlot *detach();
+
+  ExecutionSlot *slot;
+
+private:
+  ExecutionContextPool &pool;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* EXECUTIONCONTEXTPOOL_H_ */
@@ -0,0 +1,89 @@
+/**
+ * @file	FileLock.cpp
+ * @author	Carroll Vance
+ * @brief	Advisory lock coordinating threads and processes through a file
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FileLock.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief	Gets whether a path still names an open file
+ */
+static bool isLinked(int fd, std::string path) {
+  struct stat opened, linked;
+  if (stat(path.c_str(), &linked) != 0)
+    return errno != ENOENT;
+  if (fstat(fd, &opened) != 0)
+    return true;
+
+  return opened.st_dev == linked.st_dev && opened.st_ino == linked.st_ino;
+}
+
+FileLock::FileLock(std::string path, bool exclusive) {
+  this->path = path;
+
+  while (true) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("Unable to open lock file " + path + ": " +
+                               std::string(strerror(errno)));
+
+    int locked;
+    do
+      locked = flock(fd, exclusive ? LOCK_EX : LOCK_SH);
+    while (locked != 0 && errno == EINTR);
+
+    if (locked != 0) {
+      int lockError = errno;
+      close(fd);
+      throw std::runtime_error("Unable to lock " + path + ": " +
+                               std::string(strerror(lockError)));
+    }
+
+    // The previous holder deleted the file while we waited, so the path may
+    // already be locked through a new file
+    if (isLinked(fd, path))
+      return;
+
+    close(fd);
+  }
+}
+
+FileLock::~FileLock() {
+  flock(fd, LOCK_UN);
+  close(fd);
+}
+
+void FileLock::remove() { unlink(path.c_str()); }
+
+} // namespace jetson_tensorrt
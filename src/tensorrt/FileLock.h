@@ -0,0 +1,73 @@
+/**
+ * @file	FileLock.h
+ * @author	Carroll Vance
+ * @brief	Advisory lock coordinating threads and processes through a file
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FILELOCK_H_
+#define FILELOCK_H_
+
+#include <string>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Scoped flock() on a lock file. Every FileLock opens the file itself,
+ * so locks exclude threads of the same process as well as other processes,
+ * and the kernel releases them when a process dies.
+ *
+ * The holder may delete the lock file. Anyone who was waiting on the deleted
+ * file notices once they get it and locks the path again.
+ */
+class FileLock {
+public:
+  /**
+   * @brief	Creates the lock file if needed and blocks until it is locked
+   * @param	path	Path to the lock file
+   * @param	exclusive	Exclude every other holder, otherwise only exclusive
+   * holders are excluded
+   */
+  FileLock(std::string path, bool exclusive = true);
+
+  /**
+   * @brief	Unlocks the file
+   */
+  virtual ~FileLock();
+
+  /**
+   * @brief	Deletes the lock file, which stays locked until the FileLock is
+   * destroyed
+   */
+  void remove();
+
+private:
+  FileLock(const FileLock &) = delete;
+  FileLock &operator=(const FileLock &) = delete;
+
+  std::string path;
+  int fd;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* FILELOCK_H_ */
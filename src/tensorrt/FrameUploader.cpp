@@ -0,0 +1,238 @@
+/**
+ * @file	FrameUploader.cpp
+ * @author	Carroll Vance
+ * @brief	Stages frames in pinned memory and uploads them asynchronously
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdexcept>
+#include <string>
+
+#include "CUDACommon.h"
+#include "FrameUploader.h"
+
+namespace jetson_tensorrt {
+
+static void checkCuda(cudaError_t cudaError, std::string action) {
+  if (cudaError != cudaSuccess)
+    throw std::runtime_error("Unable to " + action +
+                             ". CUDA Error: " + std::to_string(cudaError));
+}
+
+UploadedFrame::UploadedFrame(StagingBuffer *staging) {
+  this->staging = staging;
+  device = NULL;
+  size = 0;
+  deviceCapacity = 0;
+
+  checkCuda(cudaEventCreateWithFlags(&uploaded, cudaEventDisableTiming),
+            "create upload event");
+  checkCuda(cudaEventCreateWithFlags(&consumed, cudaEventDisableTiming),
+            "create release event");
+}
+
+FrameUploader::FrameUploader(HostAllocator *allocator, size_t nbBuffers)
+    : pool(allocator, nbBuffers) {
+  stopping = false;
+
+  checkCuda(cudaStreamCreateWithFlags(&uploadStream, cudaStreamNonBlocking),
+            "create upload stream");
+
+  for (size_t b = 0; b < pool.size(); b++)
+    frames.push_back(new UploadedFrame(pool.at(b)));
+
+  uploader = std::thread(&FrameUploader::uploadFrames, this);
+}
+
+FrameUploader::~FrameUploader() {
+  stop();
+  uploader.join();
+
+  cudaStreamSynchronize(uploadStream);
+  cudaStreamDestroy(uploadStream);
+
+  for (int f = 0; f < frames.size(); f++) {
+    cudaEventDestroy(frames[f]->uploaded);
+    cudaEventDestroy(frames[f]->consumed);
+    cudaFree(frames[f]->device);
+    delete frames[f];
+  }
+}
+
+bool FrameUploader::submit(size_t size, CopyFunction copy,
+                           std::shared_ptr<const void> source) {
+  StagingBuffer *staging = pool.tryAcquire(size);
+  if (staging == NULL)
+    return false;
+
+  UploadedFrame *frame = frames[staging->index];
+  frame->size = size;
+  frame->copy = copy;
+  frame->source = source;
+  frame->submitted = std::chrono::steady_clock::now();
+
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+
+    if (stopping) {
+      frame->copy = nullptr;
+      frame->source.reset();
+      pool.release(staging);
+      return false;
+    }
+
+    pending.push_back(frame);
+  }
+  pendingChanged.notify_one();
+
+  return true;
+}
+
+UploadedFrame *FrameUploader::next(cudaStream_t stream) {
+  UploadedFrame *frame;
+
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    readyChanged.wait(lock, [this]() {
+      return stopping || error || !ready.empty();
+    });
+
+    if (error) {
+      std::exception_ptr uploadError = error;
+      error = nullptr;
+      std::rethrow_exception(uploadError);
+    }
+
+    if (stopping)
+      return NULL;
+
+    frame = ready.front();
+    ready.pop_front();
+  }
+
+  checkCuda(cudaStreamWaitEvent(stream, frame->uploaded, 0),
+            "wait for frame upload");
+
+  return frame;
+}
+
+void FrameUploader::release(UploadedFrame *frame, cudaStream_t stream) {
+  cudaEventRecord(frame->consumed, stream);
+
+  frame->source.reset();
+  pool.release(frame->staging);
+}
+
+void FrameUploader::stop() {
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  pendingChanged.notify_all();
+  readyChanged.notify_all();
+}
+
+void FrameUploader::uploadFrames() {
+  while (true) {
+    UploadedFrame *frame;
+
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      pendingChanged.wait(lock,
+                          [this]() { return stopping || !pending.empty(); });
+
+      if (stopping)
+        break;
+
+      frame = pending.front();
+      pending.pop_front();
+    }
+
+    try {
+      upload(frame);
+    } catch (...) {
+      frame->copy = nullptr;
+      frame->source.reset();
+      pool.release(frame->staging);
+
+      std::unique_lock<std::mutex> lock(queueMutex);
+      error = std::current_exception();
+      readyChanged.notify_all();
+      continue;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      ready.push_back(frame);
+    }
+    readyChanged.notify_one();
+  }
+
+  // Frames which were never handed out go back to the pool
+  std::unique_lock<std::mutex> lock(queueMutex);
+  pending.insert(pending.end(), ready.begin(), ready.end());
+  ready.clear();
+
+  for (int f = 0; f < pending.size(); f++) {
+    pending[f]->copy = nullptr;
+    pending[f]->source.reset();
+    pool.release(pending[f]->staging);
+  }
+  pending.clear();
+}
+
+void FrameUploader::upload(UploadedFrame *frame) {
+  // The previous upload out of the staging buffer has to finish before the
+  // buffer is overwritten
+  checkCuda(cudaEventSynchronize(frame->uploaded), "wait for previous upload");
+
+  {
+    ScopedLatency timer(stagingLatency);
+    frame->copy(frame->staging->data);
+    frame->copy = nullptr;
+  }
+
+  // Nothing may still read the device buffer when it is reallocated or
+  // overwritten
+  if (frame->deviceCapacity < frame->size) {
+    checkCuda(cudaEventSynchronize(frame->consumed), "wait for frame release");
+
+    cudaFree(frame->device);
+    frame->device = NULL;
+    frame->deviceCapacity = 0;
+
+    frame->device = safeCudaMalloc(frame->size);
+    frame->deviceCapacity = frame->size;
+  }
+
+  checkCuda(cudaStreamWaitEvent(uploadStream, frame->consumed, 0),
+            "wait for frame release");
+
+  checkCuda(cudaMemcpyAsync(frame->device, frame->staging->data, frame->size,
+                            cudaMemcpyHostToDevice, uploadStream),
+            "upload frame");
+
+  checkCuda(cudaEventRecord(frame->uploaded, uploadStream),
+            "record frame upload");
+}
+
+} // namespace jetson_tensorrt
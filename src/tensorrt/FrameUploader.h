@@ -0,0 +1,167 @@
+/**
+ * @file	FrameUploader.h
+ * @author	Carroll Vance
+ * @brief	Stages frames in pinned memory and uploads them asynchronously
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEUPLOADER_H_
+#define FRAMEUPLOADER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "HostAllocator.h"
+#include "LatencyHistogram.h"
+#include "StagingPool.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief A frame which has been copied to the GPU by a FrameUploader
+ */
+struct UploadedFrame {
+  UploadedFrame(StagingBuffer *staging);
+
+  StagingBuffer *staging;
+
+  /* Device copy of the frame */
+  void *device;
+  /* Size in bytes of the frame */
+  size_t size;
+
+  /* Keeps the memory the frame was copied from alive until it is released */
+  std::shared_ptr<const void> source;
+
+  /* When the frame was submitted */
+  std::chrono::steady_clock::time_point submitted;
+
+private:
+  friend class FrameUploader;
+
+  size_t deviceCapacity;
+  std::function<void(void *)> copy;
+
+  /* Recorded after the upload and after the consumer released the frame */
+  cudaEvent_t uploaded, consumed;
+};
+
+/**
+ * @brief Copies incoming frames into a pool of page-locked staging buffers on
+ * a helper thread and uploads them to the GPU on a separate stream, so a
+ * frame is transferred while the previous one is still being processed
+ */
+class FrameUploader {
+public:
+  typedef std::function<void(void *staging)> CopyFunction;
+
+  /* A frame being processed, one uploading and one waiting */
+  static const size_t DEFAULT_BUFFERS = 3;
+
+  /**
+   * @brief	Creates a new FrameUploader and starts its helper thread
+   * @param	allocator	Allocates the staging buffers, must outlive the
+   * uploader. Use a PinnedHostAllocator for asynchronous uploads.
+   * @param	nbBuffers	Number of frames which can be in flight
+   */
+  FrameUploader(HostAllocator *allocator,
+                size_t nbBuffers = DEFAULT_BUFFERS);
+
+  /**
+   * @brief	Stops the helper thread and frees the buffers
+   * @usage	Every frame returned by next() must have been released
+   */
+  virtual ~FrameUploader();
+
+  /**
+   * @brief	Queues a frame for staging and upload without blocking
+   * @param	size	Size of the frame in bytes
+   * @param	copy	Called on the helper thread to copy the frame into the
+   * staging buffer it is given
+   * @param	source	Kept until the frame is released, typically the
+   * message the frame is copied from
+   * @return	False if the frame was dropped because every buffer is in
+   * flight
+   */
+  bool submit(size_t size, CopyFunction copy,
+              std::shared_ptr<const void> source = nullptr);
+
+  /**
+   * @brief	Waits for the oldest uploaded frame
+   * @usage	Rethrows errors of the helper thread
+   * @param	stream	Work queued on the stream after this call waits for the
+   * upload to complete
+   * @return	The frame, which must be returned with release(), or NULL once
+   * the uploader is stopped
+   */
+  UploadedFrame *next(cudaStream_t stream = 0);
+
+  /**
+   * @brief	Returns a frame to the uploader
+   * @param	frame	A frame returned by next()
+   * @param	stream	The buffers are reused once the work queued on the stream
+   * before this call has completed
+   */
+  void release(UploadedFrame *frame, cudaStream_t stream = 0);
+
+  /**
+   * @brief	Stops accepting frames and wakes up callers blocked in next()
+   */
+  void stop();
+
+  /* Time the helper thread spends copying frames into staging buffers */
+  LatencyHistogram stagingLatency;
+
+private:
+  FrameUploader(const FrameUploader &) = delete;
+  FrameUploader &operator=(const FrameUploader &) = delete;
+
+  void uploadFrames();
+  void upload(UploadedFrame *frame);
+
+  StagingPool pool;
+  std::vector<UploadedFrame *> frames;
+
+  std::deque<UploadedFrame *> pending, ready;
+  bool stopping;
+  std::exception_ptr error;
+
+  std::mutex queueMutex;
+  std::condition_variable pendingChanged, readyChanged;
+
+  cudaStream_t uploadStream;
+  std::thread uploader;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* FRAMEUPLOADER_H_ */
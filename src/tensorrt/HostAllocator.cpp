@@ -0,0 +1,61 @@
+/**
+ * @file	HostAllocator.cpp
+ * @author	Carroll Vance
+ * @brief	Allocators for host memory the GPU copies from
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <cuda_runtime_api.h>
+
+#include "CUDACommon.h"
+#include "HostAllocator.h"
+
+namespace jetson_tensorrt {
+
+void *PinnedHostAllocator::allocate(size_t size) {
+  void *hostMem = NULL;
+
+  cudaError_t hostAllocError =
+      cudaHostAlloc(&hostMem, size, cudaHostAllocDefault);
+  if (hostAllocError != cudaSuccess)
+    throw std::runtime_error("CUDA Host Alloc Error: " +
+                             std::to_string(hostAllocError));
+  else if (hostMem == NULL)
+    throw std::runtime_error("Out of page-locked host memory");
+
+  return hostMem;
+}
+
+void PinnedHostAllocator::deallocate(void *data) {
+  if (data)
+    cudaFreeHost(data);
+}
+
+void *PageableHostAllocator::allocate(size_t size) { return safeMalloc(size); }
+
+void PageableHostAllocator::deallocate(void *data) { free(data); }
+
+} // namespace jetson_tensorrt
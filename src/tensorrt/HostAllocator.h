@@ -0,0 +1,78 @@
+/**
+ * @file	HostAllocator.h
+ * @author	Carroll Vance
+ * @brief	Allocators for host memory the GPU copies from
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HOSTALLOCATOR_H_
+#define HOSTALLOCATOR_H_
+
+#include <cstddef>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Allocates host memory for buffers which are shared with the GPU
+ */
+class HostAllocator {
+public:
+  virtual ~HostAllocator() {}
+
+  /**
+   * @brief	Allocates host memory or throws an exception
+   * @param	size	The size of the allocation in bytes
+   * @return	The allocation
+   */
+  virtual void *allocate(size_t size) = 0;
+
+  /**
+   * @brief	Frees memory returned by allocate()
+   * @param	data	The allocation, NULL is ignored
+   */
+  virtual void deallocate(void *data) = 0;
+};
+
+/**
+ * @brief Allocates page-locked host memory, which the GPU can copy from
+ * asynchronously and at full bandwidth
+ */
+class PinnedHostAllocator : public HostAllocator {
+public:
+  void *allocate(size_t size);
+  void deallocate(void *data);
+};
+
+/**
+ * @brief Allocates ordinary pageable host memory
+ * @usage	For hosts without a GPU. CUDA copies from it are staged through
+ * a driver buffer and are synchronous.
+ */
+class PageableHostAllocator : public HostAllocator {
+public:
+  void *allocate(size_t size);
+  void deallocate(void *data);
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* HOSTALLOCATOR_H_ */
@@ -0,0 +1,144 @@
+/**
+ * @file	LatencyHistogram.cpp
+ * @author	Carroll Vance
+ * @brief	Lock free latency histogram with HDR style buckets
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include "LatencyHistogram.h"
+
+namespace jetson_tensorrt {
+
+LatencyHistogram::LatencyHistogram() { reset(); }
+
+int LatencyHistogram::bucketIndex(uint64_t nanoseconds) {
+  if (nanoseconds < SUB_BUCKET_COUNT)
+    return (int)nanoseconds;
+
+  // Shift the value so its top bit lands in the upper half of a sub bucket
+  int topBit = 63 - __builtin_clzll(nanoseconds);
+  int shift = topBit - (SUB_BUCKET_BITS - 1);
+
+  if (shift > MAX_SHIFT)
+    return BUCKET_COUNT - 1;
+
+  int subBucket = (int)(nanoseconds >> shift) - SUB_BUCKET_HALF;
+  return SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+  if (index < SUB_BUCKET_COUNT)
+    return index;
+
+  int shift = (index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF + 1;
+  uint64_t subBucket =
+      (index - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+
+  return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  uint64_t nanoseconds = latency.count() > 0 ? latency.count() : 0;
+
+  buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  total.fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+  uint64_t previous = maximum.load(std::memory_order_relaxed);
+  while (nanoseconds > previous &&
+         !maximum.compare_exchange_weak(previous, nanoseconds,
+                                        std::memory_order_relaxed))
+    ;
+}
+
+uint64_t LatencyHistogram::count() {
+  return total.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() {
+  uint64_t recorded = count();
+  if (recorded == 0)
+    return std::chrono::nanoseconds(0);
+
+  return std::chrono::nanoseconds(sum.load(std::memory_order_relaxed) /
+                                  recorded);
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() {
+  return std::chrono::nanoseconds(maximum.load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double percentile) {
+  uint64_t recorded = 0;
+  for (int b = 0; b < BUCKET_COUNT; b++)
+    recorded += buckets[b].load(std::memory_order_relaxed);
+
+  if (recorded == 0)
+    return std::chrono::nanoseconds(0);
+
+  // Rank of the percentile, counting from one
+  uint64_t rank = (uint64_t)(percentile / 100.0 * recorded + 0.5);
+  if (rank < 1)
+    rank = 1;
+  if (rank > recorded)
+    rank = recorded;
+
+  uint64_t seen = 0;
+  for (int b = 0; b < BUCKET_COUNT; b++) {
+    seen += buckets[b].load(std::memory_order_relaxed);
+    // The bucket bound may lie past the slowest recording
+    if (seen >= rank)
+      return std::min(std::chrono::nanoseconds(bucketUpperBound(b)), max());
+  }
+
+  return max();
+}
+
+std::string LatencyHistogram::summary(std::string name) {
+  const double NS_PER_MS = 1e6;
+  char line[256];
+
+  snprintf(line, sizeof(line),
+           "%-16s n=%-8llu mean=%8.3f p50=%8.3f p90=%8.3f p99=%8.3f "
+           "p99.9=%8.3f max=%8.3f ms",
+           name.c_str(), (unsigned long long)count(),
+           mean().count() / NS_PER_MS, percentile(50).count() / NS_PER_MS,
+           percentile(90).count() / NS_PER_MS,
+           percentile(99).count() / NS_PER_MS,
+           percentile(99.9).count() / NS_PER_MS, max().count() / NS_PER_MS);
+
+  return std::string(line);
+}
+
+void LatencyHistogram::reset() {
+  for (int b = 0; b < BUCKET_COUNT; b++)
+    buckets[b].store(0, std::memory_order_relaxed);
+
+  total.store(0, std::memory_order_relaxed);
+  sum.store(0, std::memory_order_relaxed);
+  maximum.store(0, std::memory_order_relaxed);
+}
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,166 @@
+/**
+ * @file	LatencyHistogram.h
+ * @author	Carroll Vance
+ * @brief	Lock free latency histogram with HDR style buckets
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Histogram of latencies with log-linear buckets in the style of
+ * HdrHistogram.
+ *
+ * Latencies below 128ns get exact buckets. Above that, each power of two is
+ * split into 64 buckets, so every percentile is reported within 1.6% of the
+ * recorded value up to about 9 hours. Recording is a few instructions and
+ * one relaxed atomic increment, so histograms can stay enabled in production
+ * and be shared by several threads.
+ */
+class LatencyHistogram {
+public:
+  /**
+   * @brief	Creates an empty histogram
+   */
+  LatencyHistogram();
+
+  /**
+   * @brief	Records one latency
+   * @param	latency	The latency, clamped to the largest bucket
+   */
+  void record(std::chrono::nanoseconds latency);
+
+  /**
+   * @brief	Gets the number of recorded latencies
+   * @return	Number of latencies
+   */
+  uint64_t count();
+
+  /**
+   * @brief	Gets the exact mean of the recorded latencies
+   * @return	The mean, zero if nothing was recorded
+   */
+  std::chrono::nanoseconds mean();
+
+  /**
+   * @brief	Gets the exact largest recorded latency
+   * @return	The maximum, zero if nothing was recorded
+   */
+  std::chrono::nanoseconds max();
+
+  /**
+   * @brief	Gets a percentile of the recorded latencies
+   * @param	percentile	The percentile between 0 and 100
+   * @return	Upper bound of the bucket holding the percentile
+   */
+  std::chrono::nanoseconds percentile(double percentile);
+
+  /**
+   * @brief	Formats the count, mean, p50, p90, p99, p99.9 and max
+   * @param	name	Name of the measured stage
+   * @return	One line summary in milliseconds
+   */
+  std::string summary(std::string name);
+
+  /**
+   * @brief	Forgets every recorded latency
+   * @usage	Latencies recorded concurrently may be partially kept
+   */
+  void reset();
+
+  static const int SUB_BUCKET_BITS = 7;
+  static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+  static const int SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+  static const int MAX_SHIFT = 38;
+  static const int BUCKET_COUNT =
+      SUB_BUCKET_COUNT + MAX_SHIFT * SUB_BUCKET_HALF;
+
+  /**
+   * @brief	Gets the bucket a latency is counted in
+   * @param	nanoseconds	The latency
+   * @return	Index of the bucket
+   */
+  static int bucketIndex(uint64_t nanoseconds);
+
+  /**
+   * @brief	Gets the largest latency counted in a bucket
+   * @param	index	Index of the bucket
+   * @return	Upper bound of the bucket in nanoseconds
+   */
+  static uint64_t bucketUpperBound(int index);
+
+private:
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  std::atomic<uint64_t> buckets[BUCKET_COUNT];
+  std::atomic<uint64_t> total;
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> maximum;
+};
+
+/**
+ * @brief Records the lifetime of a scope in a LatencyHistogram
+ */
+class ScopedLatency {
+public:
+  /**
+   * @brief	Starts timing
+   * @param	histogram	The histogram the latency is recorded in
+   */
+  ScopedLatency(LatencyHistogram &histogram)
+      : histogram(histogram), start(std::chrono::steady_clock::now()),
+        stopped(false) {}
+
+  /**
+   * @brief	Records the time since construction unless already stopped
+   */
+  ~ScopedLatency() { stop(); }
+
+  /**
+   * @brief	Records the time since construction before the scope ends
+   */
+  void stop() {
+    if (stopped)
+      return;
+
+    histogram.record(std::chrono::steady_clock::now() - start);
+    stopped = true;
+  }
+
+private:
+  LatencyHistogram &histogram;
+  std::chrono::steady_clock::time_point start;
+  bool stopped;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -0,0 +1,154 @@
+/**
+ * @file	LayerProfiler.cpp
+ * @author	Carroll Vance
+ * @brief	Rolling per layer timing statistics of a network
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+#include "LayerProfiler.h"
+
+namespace jetson_tensorrt {
+
+LayerProfiler::LayerProfiler(size_t window) {
+  if (window == 0)
+    throw std::invalid_argument("Profiler window must hold a sample");
+
+  this->window = window;
+}
+
+LayerProfiler::~LayerProfiler() {}
+
+void LayerProfiler::reportLayerTime(const char *layerName, float ms) {
+  std::unique_lock<std::mutex> lock(samplesMutex);
+
+  std::unordered_map<std::string, size_t>::iterator found =
+      layerIndex.find(layerName);
+
+  if (found == layerIndex.end()) {
+    LayerSamples layer;
+    layer.name = layerName;
+    layer.next = 0;
+    layer.count = 0;
+    layer.samples.reserve(window);
+
+    found = layerIndex.insert(std::make_pair(layer.name, layers.size())).first;
+    layers.push_back(layer);
+  }
+
+  // Once the window is full the oldest sample is overwritten
+  LayerSamples &layer = layers[found->second];
+  if (layer.samples.size() < window)
+    layer.samples.push_back(ms);
+  else
+    layer.samples[layer.next] = ms;
+
+  layer.next = (layer.next + 1) % window;
+  layer.count++;
+}
+
+/**
+ * @brief Nearest rank percentile of samples which may be reordered
+ */
+static float percentile(std::vector<float> &samples, float p) {
+  size_t rank = (size_t)(p * (samples.size() - 1) + 0.5f);
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples[rank];
+}
+
+std::vector<LayerStats> LayerProfiler::stats() {
+  std::vector<LayerStats> result;
+  std::vector<float> sorted;
+
+  std::unique_lock<std::mutex> lock(samplesMutex);
+
+  for (int l = 0; l < layers.size(); l++) {
+    LayerSamples &layer = layers[l];
+
+    LayerStats stats;
+    stats.name = layer.name;
+    stats.count = layer.count;
+
+    double sum = 0;
+    for (int s = 0; s < layer.samples.size(); s++)
+      sum += layer.samples[s];
+    stats.mean = (float)(sum / layer.samples.size());
+
+    sorted = layer.samples;
+    stats.p50 = percentile(sorted, 0.50f);
+    stats.p99 = percentile(sorted, 0.99f);
+
+    result.push_back(stats);
+  }
+
+  return result;
+}
+
+std::string LayerProfiler::report() {
+  std::vector<LayerStats> layerStats = stats();
+  if (layerStats.size() == 0)
+    return "";
+
+  float total = 0;
+  size_t nameWidth = 5;
+  for (int l = 0; l < layerStats.size(); l++) {
+    total += layerStats[l].mean;
+    nameWidth = std::max(nameWidth, layerStats[l].name.size());
+  }
+
+  std::stringstream table;
+  char row[256];
+
+  snprintf(row, sizeof(row), "%-*s %10s %10s %10s %10s %7s\n",
+           (int)nameWidth, "Layer", "Calls", "Mean ms", "p50 ms", "p99 ms",
+           "Share");
+  table << row;
+
+  for (int l = 0; l < layerStats.size(); l++) {
+    LayerStats &stats = layerStats[l];
+    float share = total > 0 ? 100.0f * stats.mean / total : 0.0f;
+
+    table << stats.name << std::string(nameWidth - stats.name.size(), ' ');
+    snprintf(row, sizeof(row), " %10zu %10.3f %10.3f %10.3f %6.1f%%\n",
+             stats.count, stats.mean, stats.p50, stats.p99, share);
+    table << row;
+  }
+
+  snprintf(row, sizeof(row), "%-*s %10s %10.3f\n", (int)nameWidth, "Total",
+           "", total);
+  table << row;
+
+  return table.str();
+}
+
+void LayerProfiler::reset() {
+  std::unique_lock<std::mutex> lock(samplesMutex);
+
+  layers.clear();
+  layerIndex.clear();
+}
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,115 @@
+/**
+ * @file	LayerProfiler.h
+ * @author	Carroll Vance
+ * @brief	Rolling per layer timing statistics of a network
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LAYERPROFILER_H_
+#define LAYERPROFILER_H_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BackendTypes.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Timing statistics of one layer over the samples in the window
+ */
+struct LayerStats {
+  std::string name;
+  size_t count;
+  float mean;
+  float p50;
+  float p99;
+};
+
+/**
+ * @brief IProfiler which keeps the latest timings of every layer and
+ * summarizes them as mean, median and 99th percentile.
+ *
+ * TensorRT only profiles synchronous executions, so enqueued predictions are
+ * not reported. Safe to use from every context of an engine at once.
+ */
+class LayerProfiler : public nvinfer1::IProfiler {
+public:
+  static const size_t DEFAULT_WINDOW = 1000;
+
+  /**
+   * @brief	Creates a new LayerProfiler
+   * @param	window	Number of latest timings kept per layer
+   */
+  LayerProfiler(size_t window = DEFAULT_WINDOW);
+
+  /**
+   * @brief	LayerProfiler destructor
+   */
+  virtual ~LayerProfiler();
+
+  /**
+   * @brief	Records the time a layer took, called by TensorRT after each
+   * layer of a profiled execution
+   * @param	layerName	Name of the layer
+   * @param	ms	Execution time of the layer in milliseconds
+   */
+  void reportLayerTime(const char *layerName, float ms) override;
+
+  /**
+   * @brief	Computes the statistics of every layer
+   * @return	Statistics in the order layers were first reported
+   */
+  std::vector<LayerStats> stats();
+
+  /**
+   * @brief	Formats the statistics as a table with each layer's share of
+   * the total time
+   * @return	The table, empty if nothing was recorded
+   */
+  std::string report();
+
+  /**
+   * @brief	Forgets every recorded timing
+   */
+  void reset();
+
+private:
+  struct LayerSamples {
+    std::string name;
+    std::vector<float> samples;
+    size_t next;
+    size_t count;
+  };
+
+  size_t window;
+
+  std::mutex samplesMutex;
+  std::vector<LayerSamples> layers;
+  std::unordered_map<std::string, size_t> layerIndex;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* LAYERPROFILER_H_ */
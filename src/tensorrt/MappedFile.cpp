@@ -0,0 +1,82 @@
+/**
+ * @file	MappedFile.cpp
+ * @author	Carroll Vance
+ * @brief	Read only memory mapping of a file
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+
+namespace jetson_tensorrt {
+
+MappedFile::MappedFile(std::string path, bool sequential) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Unable to open " + path + ": " +
+                             std::string(strerror(errno)));
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0) {
+    int statError = errno;
+    close(fd);
+    throw std::runtime_error("Unable to stat " + path + ": " +
+                             std::string(strerror(statError)));
+  }
+
+  mappingSize = fileStat.st_size;
+  if (mappingSize == 0) {
+    close(fd);
+    throw std::runtime_error("Unable to map empty file " + path);
+  }
+
+  mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  int mapError = errno;
+
+  // The mapping keeps its own reference to the file
+  close(fd);
+
+  if (mapping == MAP_FAILED)
+    throw std::runtime_error("Unable to map " + path + ": " +
+                             std::string(strerror(mapError)));
+
+  // Advice is only a hint, so failures are ignored
+  if (sequential) {
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+    madvise(mapping, mappingSize, MADV_WILLNEED);
+  }
+}
+
+MappedFile::~MappedFile() { munmap(mapping, mappingSize); }
+
+const void *MappedFile::data() { return mapping; }
+
+size_t MappedFile::size() { return mappingSize; }
+
+} // namespace jetson_tensorrt
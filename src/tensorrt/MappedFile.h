@@ -0,0 +1,76 @@
+/**
+ * @file	MappedFile.h
+ * @author	Carroll Vance
+ * @brief	Read only memory mapping of a file
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <string>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief A file mapped read only into memory. Pages are read from the disk
+ * when first touched and are shared with the page cache instead of being
+ * copied into the heap.
+ */
+class MappedFile {
+public:
+  /**
+   * @brief	Maps a whole file into memory
+   * @param	path	Path to the file
+   * @param	sequential	Advise the kernel that the mapping will be read
+   * once from start to end, so it reads ahead and drops pages behind
+   */
+  MappedFile(std::string path, bool sequential = true);
+
+  /**
+   * @brief	Unmaps the file
+   */
+  virtual ~MappedFile();
+
+  /**
+   * @brief	Gets the start of the mapping
+   * @return	Pointer to the first byte of the file
+   */
+  const void *data();
+
+  /**
+   * @brief	Gets the size of the mapping
+   * @return	Size of the file in bytes
+   */
+  size_t size();
+
+private:
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  void *mapping;
+  size_t mappingSize;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* MAPPEDFILE_H_ */
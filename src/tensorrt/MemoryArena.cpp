@@ -0,0 +1,124 @@
+/**
+ * @file	MemoryArena.cpp
+ * @author	Carroll Vance
+ * @brief	One aligned allocation which tensors are carved out of
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+
+#ifndef JETSON_TENSORRT_HOST_ONLY
+#include <cuda_runtime_api.h>
+#endif
+
+#include "MemoryArena.h"
+
+namespace jetson_tensorrt {
+
+MemoryArena::MemoryArena(MemoryLocation location, size_t size,
+                         bool hugePages) {
+  if (size == 0)
+    throw std::invalid_argument("Memory arenas can not be empty");
+
+  this->location = location;
+  this->memory = NULL;
+  this->arenaSize = size;
+  this->mappedSize = 0;
+
+  if (location == MemoryLocation::HOST) {
+    if (hugePages) {
+      memory = mapHugePages(size);
+    } else if (posix_memalign(&memory, ALIGNMENT, size) != 0) {
+      throw std::bad_alloc();
+    }
+#ifndef JETSON_TENSORRT_HOST_ONLY
+  } else if (location == MemoryLocation::DEVICE) {
+    memory = safeCudaMalloc(size);
+  } else if (location == MemoryLocation::MAPPED) {
+    memory = safeCudaHostMalloc(size);
+  } else if (location == MemoryLocation::UNIFIED) {
+    memory = safeCudaUnifiedMalloc(size);
+#endif
+  } else if (location != MemoryLocation::NONE) {
+    throw std::invalid_argument("Only HOST memory is available without CUDA");
+  } else {
+    throw std::invalid_argument("Memory arenas require a location");
+  }
+}
+
+MemoryArena::~MemoryArena() {
+  if (location == MemoryLocation::HOST) {
+    if (mappedSize > 0)
+      munmap(memory, mappedSize);
+    else
+      free(memory);
+#ifndef JETSON_TENSORRT_HOST_ONLY
+  } else if (location == MemoryLocation::DEVICE ||
+             location == MemoryLocation::UNIFIED) {
+    cudaFree(memory);
+  } else if (location == MemoryLocation::MAPPED) {
+    cudaFreeHost(memory);
+#endif
+  }
+}
+
+void *MemoryArena::mapHugePages(size_t size) {
+  size_t pagesSize =
+      (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  void *pages = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  pages = mmap(NULL, pagesSize, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+  // Without reserved huge pages the kernel can still back the mapping with
+  // transparent huge pages
+  if (pages == MAP_FAILED) {
+    pages = mmap(NULL, pagesSize, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED)
+      throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+    madvise(pages, pagesSize, MADV_HUGEPAGE);
+#endif
+  }
+
+  mappedSize = pagesSize;
+  return pages;
+}
+
+void *MemoryArena::data() { return memory; }
+
+size_t MemoryArena::size() { return arenaSize; }
+
+MemoryLocation MemoryArena::getLocation() { return location; }
+
+size_t MemoryArena::align(size_t size) {
+  return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+} // namespace jetson_tensorrt
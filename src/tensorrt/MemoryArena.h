@@ -0,0 +1,103 @@
+/**
+ * @file	MemoryArena.h
+ * @author	Carroll Vance
+ * @brief	One aligned allocation which tensors are carved out of
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MEMORYARENA_H_
+#define MEMORYARENA_H_
+
+#include <cstddef>
+
+#include "CUDACommon.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief A single aligned allocation in one MemoryLocation. Tensors are
+ * carved out of it at aligned offsets, so a whole batch of inputs or outputs
+ * costs one allocation and is freed in one place.
+ */
+class MemoryArena {
+public:
+  /* The alignment cudaMalloc guarantees */
+  static const size_t ALIGNMENT = 256;
+  static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+  /**
+   * @brief	Allocates a new arena or throws an exception
+   * @param	location	Where the arena is allocated
+   * @param	size	Size of the arena in bytes
+   * @param	hugePages	Back a HOST arena with huge pages, which are taken
+   * from the reserved pool when possible and otherwise requested as
+   * transparent huge pages. Ignored for other locations.
+   */
+  MemoryArena(MemoryLocation location, size_t size, bool hugePages = false);
+
+  /**
+   * @brief	Frees the arena
+   */
+  virtual ~MemoryArena();
+
+  /**
+   * @brief	Gets the start of the arena
+   * @return	Pointer aligned to ALIGNMENT
+   */
+  void *data();
+
+  /**
+   * @brief	Gets the usable size of the arena
+   * @return	Size in bytes
+   */
+  size_t size();
+
+  /**
+   * @brief	Gets where the arena is allocated
+   * @return	The location
+   */
+  MemoryLocation getLocation();
+
+  /**
+   * @brief	Rounds a size up to the next multiple of ALIGNMENT
+   * @param	size	Size in bytes
+   * @return	The aligned size
+   */
+  static size_t align(size_t size);
+
+private:
+  MemoryArena(const MemoryArena &) = delete;
+  MemoryArena &operator=(const MemoryArena &) = delete;
+
+  void *mapHugePages(size_t size);
+
+  MemoryLocation location;
+  void *memory;
+  size_t arenaSize;
+
+  /* Size of the mapping when the arena is backed by huge pages */
+  size_t mappedSize;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* MEMORYARENA_H_ */
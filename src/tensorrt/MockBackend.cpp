@@ -0,0 +1,262 @@
+/**
+ * @file	MockBackend.cpp
+ * @author	Carroll Vance
+ * @brief	Deterministic host only ExecutionBackend
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "MockBackend.h"
+
+namespace jetson_tensorrt {
+
+const char MockBackend::MAGIC[8] = {'J', 'T', 'R', 'T', 'M', 'O', 'C', 'K'};
+
+MockContext::MockContext(MockBackend *backend) {
+  this->backend = backend;
+  profiler = NULL;
+}
+
+MockContext::~MockContext() {}
+
+void MockContext::execute(int batchSize, void **bindings) {
+  backend->synchronize();
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  backend->run(batchSize, bindings);
+
+  if (profiler)
+    profiler->reportLayerTime(
+        "mock", std::chrono::duration<float, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+}
+
+void MockContext::enqueue(int batchSize, void **bindings,
+                          cudaStream_t stream) {
+  // Bindings only have to stay valid until enqueue returns
+  std::vector<void *> queuedBindings(bindings,
+                                     bindings + backend->getNbBindings());
+
+  MockBackend *backend = this->backend;
+  backend->submit([backend, batchSize, queuedBindings]() mutable {
+    backend->run(batchSize, &queuedBindings[0]);
+  });
+}
+
+void MockContext::setProfiler(nvinfer1::IProfiler *profiler) {
+  this->profiler = profiler;
+}
+
+MockBackend::MockBackend(std::vector<NetworkInput> inputs,
+                         std::vector<NetworkOutput> outputs,
+                         std::chrono::microseconds latency) {
+  this->inputs = inputs;
+  this->outputs = outputs;
+  this->latency = latency;
+  callbackStatus = cudaSuccess;
+
+  executionCount = 0;
+  working = false;
+  stopping = false;
+
+  worker = std::thread(&MockBackend::work, this);
+}
+
+MockBackend::~MockBackend() {
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  queueChanged.notify_all();
+  worker.join();
+}
+
+void MockBackend::load(const void *blob, size_t size) {
+  int32_t nbBindings;
+
+  if (size != sizeof(MAGIC) + sizeof(nbBindings) ||
+      memcmp(blob, MAGIC, sizeof(MAGIC)) != 0)
+    throw std::invalid_argument(
+        "Unable to create engine from deserialized data");
+
+  memcpy(&nbBindings, (const char *)blob + sizeof(MAGIC), sizeof(nbBindings));
+  if (nbBindings != getNbBindings())
+    throw std::invalid_argument(
+        "Deserialized mock engine has a different number of bindings");
+}
+
+void MockBackend::serialize(std::ostream &out) {
+  int32_t nbBindings = getNbBindings();
+
+  out.write(MAGIC, sizeof(MAGIC));
+  out.write((const char *)&nbBindings, sizeof(nbBindings));
+}
+
+ExecutionContext *MockBackend::createContext() { return new MockContext(this); }
+
+int MockBackend::getNbBindings() { return inputs.size() + outputs.size(); }
+
+bool MockBackend::bindingIsInput(int index) { return index < inputs.size(); }
+
+nvinfer1::Dims MockBackend::getBindingDimensions(int index) {
+  if (index < inputs.size())
+    return inputs[index].dims;
+
+  return outputs[index - inputs.size()].dims;
+}
+
+void *MockBackend::allocBinding(size_t size) {
+  void *binding = malloc(size);
+  if (binding == NULL)
+    throw std::bad_alloc();
+
+  return binding;
+}
+
+void MockBackend::freeBinding(void *binding) { free(binding); }
+
+void *MockBackend::mapBinding(void *host) { return host; }
+
+void MockBackend::copyToBinding(void *binding, const void *host, size_t size,
+                                cudaStream_t stream, bool async) {
+  if (async) {
+    submit([binding, host, size]() { memcpy(binding, host, size); });
+  } else {
+    synchronize();
+    memcpy(binding, host, size);
+  }
+}
+
+void MockBackend::copyFromBinding(void *host, const void *binding, size_t size,
+                                  cudaStream_t stream, bool async) {
+  if (async) {
+    submit([host, binding, size]() { memcpy(host, binding, size); });
+  } else {
+    synchronize();
+    memcpy(host, binding, size);
+  }
+}
+
+void MockBackend::addCallback(cudaStream_t stream,
+                              std::function<void(cudaError_t)> callback) {
+  cudaError_t status = callbackStatus;
+  submit([callback, status]() { callback(status); });
+}
+
+/**
+ * @brief	FNV-1a over a buffer, continuing from hash
+ */
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+void MockBackend::run(int batchSize, void **bindings) {
+
+  if (latency.count() > 0)
+    std::this_thread::sleep_for(latency);
+
+  for (int b = 0; b < batchSize; b++) {
+
+    // Every output of a record depends only on the inputs of that record
+    uint32_t seed = 2166136261u;
+    for (int i = 0; i < inputs.size(); i++) {
+      size_t inputSize = inputs[i].size();
+      seed = fnv1a(seed, (const char *)bindings[i] + b * inputSize, inputSize);
+    }
+
+    for (int o = 0; o < outputs.size(); o++) {
+      size_t outputSize = outputs[o].size();
+      size_t eleSize = outputs[o].eleSize;
+      char *output = (char *)bindings[inputs.size() + o] + b * outputSize;
+
+      for (size_t e = 0; e < outputSize / eleSize; e++) {
+        uint32_t value = seed ^ (uint32_t)((o + 1) * 2654435761u);
+        value = fnv1a(value, &e, sizeof(e));
+
+        if (eleSize == sizeof(float)) {
+          // Floats are kept in [0, 1) so they look like probabilities
+          float probability = (float)(value >> 8) / (float)(1 << 24);
+          memcpy(output + e * eleSize, &probability, sizeof(float));
+        } else {
+          memset(output + e * eleSize, (int)(value & 0xff), eleSize);
+        }
+      }
+    }
+  }
+
+  executionCount++;
+}
+
+void MockBackend::submit(std::function<void()> task) {
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    queue.push_back(task);
+  }
+  queueChanged.notify_all();
+}
+
+void MockBackend::synchronize() {
+  std::unique_lock<std::mutex> lock(queueMutex);
+  queueChanged.wait(lock, [this]() { return queue.empty() && !working; });
+}
+
+size_t MockBackend::executions() { return executionCount; }
+
+void MockBackend::work() {
+  std::unique_lock<std::mutex> lock(queueMutex);
+
+  while (true) {
+    queueChanged.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+    if (queue.empty())
+      return;
+
+    std::function<void()> task = queue.front();
+    queue.pop_front();
+    working = true;
+
+    lock.unlock();
+    task();
+    lock.lock();
+
+    working = false;
+    queueChanged.notify_all();
+  }
+}
+
+} // namespace jetson_tensorrt
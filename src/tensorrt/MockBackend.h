@@ -0,0 +1,171 @@
+/**
+ * @file	MockBackend.h
+ * @author	Carroll Vance
+ * @brief	Deterministic host only ExecutionBackend
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MOCKBACKEND_H_
+#define MOCKBACKEND_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ExecutionBackend.h"
+#include "NetworkIO.h"
+
+namespace jetson_tensorrt {
+
+class MockBackend;
+
+/**
+ * @brief ExecutionContext of a MockBackend
+ */
+class MockContext : public ExecutionContext {
+public:
+  /**
+   * @brief	Creates a new MockContext
+   * @param	backend	The backend which runs the inference
+   */
+  MockContext(MockBackend *backend);
+
+  /**
+   * @brief	MockContext destructor
+   */
+  virtual ~MockContext();
+
+  void execute(int batchSize, void **bindings);
+  void enqueue(int batchSize, void **bindings, cudaStream_t stream);
+
+  /**
+   * @brief	Reports each synchronous execution as a single layer named
+   * "mock"
+   * @param	profiler	The profiler to report to, NULL to stop profiling
+   */
+  void setProfiler(nvinfer1::IProfiler *profiler);
+
+private:
+  MockBackend *backend;
+  nvinfer1::IProfiler *profiler;
+};
+
+/**
+ * @brief ExecutionBackend which runs entirely on the host without a GPU.
+ *
+ * Binding memory is ordinary host memory and every output element is a
+ * deterministic function of the inputs of its batch record, so results are
+ * reproducible. Asynchronous work from every stream is executed in submission
+ * order by a single worker thread, which emulates one in-order device queue.
+ * A fixed latency can be added to each execution to model the GPU.
+ */
+class MockBackend : public ExecutionBackend {
+public:
+  /**
+   * @brief	Creates a new MockBackend
+   * @param	inputs	Inputs of the mocked network
+   * @param	outputs	Outputs of the mocked network
+   * @param	latency	Simulated time each execution takes
+   */
+  MockBackend(std::vector<NetworkInput> inputs,
+              std::vector<NetworkOutput> outputs,
+              std::chrono::microseconds latency = std::chrono::microseconds(0));
+
+  /**
+   * @brief	MockBackend destructor
+   */
+  virtual ~MockBackend();
+
+  void load(const void *blob, size_t size);
+  void serialize(std::ostream &out);
+  ExecutionContext *createContext();
+
+  int getNbBindings();
+  bool bindingIsInput(int index);
+  nvinfer1::Dims getBindingDimensions(int index);
+
+  void *allocBinding(size_t size);
+  void freeBinding(void *binding);
+  void *mapBinding(void *host);
+  void copyToBinding(void *binding, const void *host, size_t size,
+                     cudaStream_t stream, bool async);
+  void copyFromBinding(void *host, const void *binding, size_t size,
+                       cudaStream_t stream, bool async);
+  void addCallback(cudaStream_t stream,
+                   std::function<void(cudaError_t)> callback);
+
+  /**
+   * @brief	Runs inference on the calling thread
+   * @param	batchSize	Number of records in the batch
+   * @param	bindings	One contiguous buffer per binding holding every
+   * record of the batch
+   */
+  void run(int batchSize, void **bindings);
+
+  /**
+   * @brief	Queues work behind everything enqueued so far
+   * @param	task	The work to run on the worker thread
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * @brief	Blocks until every enqueued operation has run
+   */
+  void synchronize();
+
+  /**
+   * @brief	Gets the number of executions run so far
+   * @return	Number of completed execute() or enqueue() calls
+   */
+  size_t executions();
+
+  std::chrono::microseconds latency;
+
+  /* Status every callback is invoked with, to simulate a failing stream */
+  cudaError_t callbackStatus;
+
+private:
+  static const char MAGIC[8];
+
+  std::vector<NetworkInput> inputs;
+  std::vector<NetworkOutput> outputs;
+
+  std::atomic<size_t> executionCount;
+
+  std::thread worker;
+  std::mutex queueMutex;
+  std::condition_variable queueChanged;
+  std::deque<std::function<void()>> queue;
+  bool working;
+  bool stopping;
+
+  void work();
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* MOCKBACKEND_H_ */
@@ -0,0 +1,88 @@
+/**
+ * @file	ModelRepository.cpp
+ * @author	Carroll Vance
+ * @brief	Directory of models holding numbered versions of engine bundles
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+
+#include "ModelRepository.h"
+
+namespace jetson_tensorrt {
+
+const std::string ModelRepository::BUNDLE_NAME = "model.bundle";
+
+ModelRepository::ModelRepository(std::string root) { this->root = root; }
+
+std::vector<int> ModelRepository::versions(std::string model) {
+  std::vector<int> found;
+
+  DIR *directory = opendir((root + "/" + model).c_str());
+  if (!directory)
+    return found;
+
+  for (struct dirent *entry = readdir(directory); entry != NULL;
+       entry = readdir(directory)) {
+    std::string name = entry->d_name;
+
+    // Anything besides positive numbers, i.e. notes or staging directories,
+    // is not a version
+    if (name.empty() ||
+        name.find_first_not_of("0123456789") != std::string::npos)
+      continue;
+
+    // Versions are addressed by their number, so "007" would not be found
+    int version = std::atoi(name.c_str());
+    if (version <= 0 || std::to_string(version) != name)
+      continue;
+
+    struct stat bundleStat;
+    if (stat(bundlePath(model, version).c_str(), &bundleStat) == 0 &&
+        S_ISREG(bundleStat.st_mode))
+      found.push_back(version);
+  }
+
+  closedir(directory);
+
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+int ModelRepository::latestVersion(std::string model) {
+  std::vector<int> found = versions(model);
+  if (found.empty())
+    return 0;
+
+  return found.back();
+}
+
+std::string ModelRepository::bundlePath(std::string model, int version) {
+  return root + "/" + model + "/" + std::to_string(version) + "/" +
+         BUNDLE_NAME;
+}
+
+} // namespace jetson_tensorrt
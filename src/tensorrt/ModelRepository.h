@@ -0,0 +1,84 @@
+/**
+ * @file	ModelRepository.h
+ * @author	Carroll Vance
+ * @brief	Directory of models holding numbered versions of engine bundles
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MODELREPOSITORY_H_
+#define MODELREPOSITORY_H_
+
+#include <string>
+#include <vector>
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Directory holding one subdirectory per model, which holds one
+ * numbered subdirectory per version of the model:
+ *
+ *   <root>/<model>/<version>/model.bundle
+ *
+ * A version exists once its bundle does. Bundles are written under a
+ * temporary name and renamed into place, so a bundle which exists is
+ * complete. Publishing a new version while nodes run means saving its bundle
+ * into the next version directory.
+ */
+class ModelRepository {
+public:
+  static const std::string BUNDLE_NAME;
+
+  /**
+   * @brief	Creates a repository rooted at a directory
+   * @param	root	Directory holding the models
+   */
+  ModelRepository(std::string root);
+
+  /**
+   * @brief	Lists the versions of a model
+   * @param	model	Name of the model
+   * @return	Versions whose bundle exists, ascending
+   */
+  std::vector<int> versions(std::string model);
+
+  /**
+   * @brief	Gets the newest version of a model
+   * @param	model	Name of the model
+   * @return	The version, 0 if the model has none
+   */
+  int latestVersion(std::string model);
+
+  /**
+   * @brief	Gets the path of the bundle of a version
+   * @param	model	Name of the model
+   * @param	version	Version of the model
+   * @return	Path to the bundle, which may not exist yet
+   */
+  std::string bundlePath(std::string model, int version);
+
+private:
+  std::string root;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* MODELREPOSITORY_H_ */
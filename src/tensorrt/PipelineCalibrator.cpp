@@ -0,0 +1,172 @@
+/**
+ * @file	PipelineCalibrator.cpp
+ * @author	Carroll Vance
+ * @brief	INT8 calibrator which streams images through a CUDAPipeline
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cuda_runtime_api.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "CUDACommon.h"
+#include "PipelineCalibrator.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Gets the first line of the tables TensorRT writes with this
+ * calibrator, tables of other versions or algorithms can not be used
+ */
+static std::string tableHeader() {
+#if NV_TENSORRT_MAJOR >= 5
+  return "TRT-" +
+         std::to_string(NV_TENSORRT_MAJOR * 1000 + NV_TENSORRT_MINOR * 100 +
+                        NV_TENSORRT_PATCH) +
+         "-EntropyCalibration";
+#else
+  // Older versions do not name themselves in the table
+  return "";
+#endif
+}
+
+PipelineCalibrator::PipelineCalibrator(ImageSource *images,
+                                       PipelineFactory pipelineFactory,
+                                       NetworkInput input, size_t batchSize,
+                                       std::string tablePath,
+                                       size_t maxBatches)
+    : input(input), table(tablePath, tableHeader()) {
+
+  if (batchSize == 0)
+    throw std::invalid_argument("Calibration batch size must be positive");
+
+  this->images = images;
+  this->pipelineFactory = pipelineFactory;
+  this->batchSize = batchSize;
+  this->maxBatches = maxBatches;
+
+  batcher = new ImageBatcher(images, batchSize);
+  pipeline = NULL;
+  pipelineWidth = 0;
+  pipelineHeight = 0;
+
+  deviceBatch = safeCudaMalloc(batchSize * input.size());
+}
+
+PipelineCalibrator::~PipelineCalibrator() {
+  delete pipeline;
+  delete batcher;
+  delete images;
+  cudaFree(deviceBatch);
+}
+
+int PipelineCalibrator::getBatchSize() const { return batchSize; }
+
+bool PipelineCalibrator::getBatch(void *bindings[], const char *names[],
+                                  int nbBindings) {
+
+  if (!images || (maxBatches > 0 && batcher->batches() >= maxBatches))
+    return false;
+
+  int bindingIdx = -1;
+  for (int n = 0; n < nbBindings; n++)
+    if (input.name == names[n])
+      bindingIdx = n;
+
+  // TensorRT can not handle exceptions, failures just end calibration
+  if (bindingIdx < 0 || nbBindings != 1) {
+    std::cerr << "ERROR: Calibration only supports the single input "
+              << input.name << std::endl;
+    return false;
+  }
+
+  try {
+    // A partial last batch is dropped
+    if (!batcher->next([this](const HostImage &image, size_t position) {
+          feed(image, position);
+        }))
+      return false;
+  } catch (std::exception &e) {
+    std::cerr << "ERROR: Calibration failed: " << e.what() << std::endl;
+    return false;
+  }
+
+  bindings[bindingIdx] = deviceBatch;
+
+  return true;
+}
+
+void PipelineCalibrator::feed(const HostImage &image, size_t position) {
+  if (!pipeline || image.width != pipelineWidth ||
+      image.height != pipelineHeight) {
+    delete pipeline;
+    pipeline = pipelineFactory(image.width, image.height);
+    pipelineWidth = image.width;
+    pipelineHeight = image.height;
+  }
+
+  CUDAPipeIO hostImage(MemoryLocation::HOST, (void *)&image.data[0],
+                       image.data.size());
+  CUDAPipeIO preprocessed = pipeline->pipe(hostImage);
+
+  if (preprocessed.location != MemoryLocation::DEVICE ||
+      preprocessed.size() != input.size())
+    throw std::runtime_error("Calibration pipeline output does not match the "
+                             "network input");
+
+  cudaError_t copyError =
+      cudaMemcpy((char *)deviceBatch + position * input.size(),
+                 preprocessed.data, input.size(), cudaMemcpyDeviceToDevice);
+  if (copyError != cudaSuccess)
+    throw std::runtime_error("Unable to copy calibration image. CUDA Error: " +
+                             std::to_string(copyError));
+}
+
+const void *PipelineCalibrator::readCalibrationCache(size_t &length) {
+  length = 0;
+
+  try {
+    if (!table.load())
+      return NULL;
+  } catch (std::exception &e) {
+    // Calibrating again replaces the table
+    std::cerr << "WARNING: " << e.what() << std::endl;
+    return NULL;
+  }
+
+  length = table.size();
+  return table.data();
+}
+
+void PipelineCalibrator::writeCalibrationCache(const void *cache,
+                                               size_t length) {
+  try {
+    table.save(cache, length);
+  } catch (std::exception &e) {
+    std::cerr << "WARNING: " << e.what() << std::endl;
+  }
+}
+
+size_t PipelineCalibrator::batches() { return batcher->batches(); }
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,110 @@
+/**
+ * @file	PipelineCalibrator.h
+ * @author	Carroll Vance
+ * @brief	INT8 calibrator which streams images through a CUDAPipeline
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PIPELINECALIBRATOR_H_
+#define PIPELINECALIBRATOR_H_
+
+#include <functional>
+#include <string>
+
+#include "NvInfer.h"
+
+#include "CUDAPipeline.h"
+#include "CalibrationImages.h"
+#include "CalibrationTable.h"
+#include "TensorRTEngine.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Creates the preprocessing pipeline for images of a given size
+ */
+typedef std::function<CUDAPipeline *(int width, int height)> PipelineFactory;
+
+/**
+ * @brief Entropy calibrator which feeds TensorRT batches of images that went
+ * through the same CUDAPipeline preprocessing as inference.
+ *
+ * The calibration table is persisted, and once it exists TensorRT builds INT8
+ * engines from the table without reading any images.
+ */
+class PipelineCalibrator : public nvinfer1::IInt8EntropyCalibrator {
+public:
+  /**
+   * @brief	Creates a new PipelineCalibrator
+   * @param	images	Calibration images, owned by the calibrator. May be
+   * NULL when the calibration table already exists.
+   * @param	pipelineFactory	Creates the preprocessing pipeline, which must
+   * output the network input in device memory
+   * @param	input	The network input the images are fed to
+   * @param	batchSize	Number of images in each calibration batch
+   * @param	tablePath	Path the calibration table is read from and saved
+   * to
+   * @param	maxBatches	Stops calibrating after this many batches, 0 to
+   * use every image
+   */
+  PipelineCalibrator(ImageSource *images, PipelineFactory pipelineFactory,
+                     NetworkInput input, size_t batchSize,
+                     std::string tablePath, size_t maxBatches = 0);
+
+  /**
+   * @brief	PipelineCalibrator destructor
+   */
+  virtual ~PipelineCalibrator();
+
+  int getBatchSize() const override;
+  bool getBatch(void *bindings[], const char *names[],
+                int nbBindings) override;
+  const void *readCalibrationCache(size_t &length) override;
+  void writeCalibrationCache(const void *cache, size_t length) override;
+
+  /**
+   * @brief	Gets the number of batches fed to TensorRT so far
+   * @return	Number of calibration batches
+   */
+  size_t batches();
+
+private:
+  ImageSource *images;
+  PipelineFactory pipelineFactory;
+  NetworkInput input;
+  size_t batchSize;
+  size_t maxBatches;
+  ImageBatcher *batcher;
+
+  CalibrationTable table;
+
+  CUDAPipeline *pipeline;
+  int pipelineWidth, pipelineHeight;
+
+  void *deviceBatch;
+
+  void feed(const HostImage &image, size_t position);
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* PIPELINECALIBRATOR_H_ */
@@ -0,0 +1,159 @@
+/**
+ * @file	PreprocessReference.cpp
+ * @author	Carroll Vance
+ * @brief	CPU implementations of the preprocessing kernels
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "PreprocessReference.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief	Input pixels along one axis which make up output pixel o, and
+ * their weights. Every filter is separable, so a 2D sample is the product of
+ * the weights along both axes.
+ */
+static std::vector<std::pair<size_t, float>>
+sampleWeights(size_t o, float scale, size_t inputSize, cudaFilterMode filter) {
+  std::vector<std::pair<size_t, float>> weights;
+  const float last = float(inputSize - 1);
+
+  if (filter == FILTER_LINEAR) {
+    // Center aligned, clamped to the border
+    const float s = std::min(std::max((o + 0.5f) * scale - 0.5f, 0.0f), last);
+    const size_t i0 = (size_t)s;
+    const size_t i1 = std::min(i0 + 1, inputSize - 1);
+    const float f = s - i0;
+
+    weights.push_back(std::make_pair(i0, 1.0f - f));
+    weights.push_back(std::make_pair(i1, f));
+  } else if (filter == FILTER_AREA) {
+    // The output pixel covers [begin, end) of the input
+    const float begin = (float)o * scale;
+    const float end = std::min(begin + scale, float(inputSize));
+
+    for (size_t i = (size_t)begin; i < inputSize && i < end; i++) {
+      const float covered =
+          std::min(i + 1.0f, end) - std::max((float)i, begin);
+      weights.push_back(std::make_pair(i, covered));
+    }
+  } else {
+    weights.push_back(std::make_pair((size_t)(int)((float)o * scale), 1.0f));
+  }
+
+  return weights;
+}
+
+void referenceResize(const float *input, size_t inputWidth,
+                     size_t inputHeight, size_t channels, float *output,
+                     size_t outputWidth, size_t outputHeight,
+                     cudaFilterMode filter) {
+  if (inputWidth == 0 || inputHeight == 0 || outputWidth == 0 ||
+      outputHeight == 0 || channels == 0)
+    throw std::invalid_argument("Image dimensions must not be zero");
+
+  const float scaleX = float(inputWidth) / float(outputWidth);
+  const float scaleY = float(inputHeight) / float(outputHeight);
+
+  for (size_t y = 0; y < outputHeight; y++) {
+    const std::vector<std::pair<size_t, float>> rows =
+        sampleWeights(y, scaleY, inputHeight, filter);
+
+    for (size_t x = 0; x < outputWidth; x++) {
+      const std::vector<std::pair<size_t, float>> columns =
+          sampleWeights(x, scaleX, inputWidth, filter);
+      float *px = output + (y * outputWidth + x) * channels;
+
+      for (size_t c = 0; c < channels; c++) {
+        float sum = 0.0f, total = 0.0f;
+
+        for (size_t r = 0; r < rows.size(); r++)
+          for (size_t i = 0; i < columns.size(); i++) {
+            const float w = rows[r].second * columns[i].second;
+            sum += w * input[(rows[r].first * inputWidth + columns[i].first) *
+                                 channels +
+                             c];
+            total += w;
+          }
+
+        px[c] = sum / total;
+      }
+    }
+  }
+}
+
+void referencePreImageNetRGB(const uchar3 *input, size_t inputWidth,
+                             size_t inputHeight, float *output,
+                             size_t outputWidth, size_t outputHeight,
+                             float3 mean, cudaFilterMode filter) {
+  if (inputWidth == 0 || inputHeight == 0 || outputWidth == 0 ||
+      outputHeight == 0)
+    throw std::invalid_argument("Image dimensions must not be zero");
+
+  const size_t n = outputWidth * outputHeight;
+
+  if (filter == FILTER_POINT) {
+    const float scaleX = float(inputWidth) / float(outputWidth);
+    const float scaleY = float(inputHeight) / float(outputHeight);
+
+    for (size_t y = 0; y < outputHeight; y++) {
+      const int dy = (float)y * scaleY;
+
+      for (size_t x = 0; x < outputWidth; x++) {
+        const int dx = (float)x * scaleX;
+        const uchar3 px = input[dy * inputWidth + dx];
+
+        output[n * 0 + y * outputWidth + x] = px.z - mean.x;
+        output[n * 1 + y * outputWidth + x] = px.y - mean.y;
+        output[n * 2 + y * outputWidth + x] = px.x - mean.z;
+      }
+    }
+    return;
+  }
+
+  // Interpolating filters work on the float image
+  std::vector<float> rgb(inputWidth * inputHeight * 3);
+  for (size_t i = 0; i < inputWidth * inputHeight; i++) {
+    rgb[i * 3 + 0] = input[i].x;
+    rgb[i * 3 + 1] = input[i].y;
+    rgb[i * 3 + 2] = input[i].z;
+  }
+
+  std::vector<float> resized(n * 3);
+  referenceResize(rgb.data(), inputWidth, inputHeight, 3, resized.data(),
+                  outputWidth, outputHeight, filter);
+
+  for (size_t i = 0; i < n; i++) {
+    output[n * 0 + i] = resized[i * 3 + 2] - mean.x;
+    output[n * 1 + i] = resized[i * 3 + 1] - mean.y;
+    output[n * 2 + i] = resized[i * 3 + 0] - mean.z;
+  }
+}
+
+} // namespace jetson_tensorrt
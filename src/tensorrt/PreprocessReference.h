@@ -0,0 +1,83 @@
+/**
+ * @file	PreprocessReference.h
+ * @author	Carroll Vance
+ * @brief	CPU implementations of the preprocessing kernels
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PREPROCESSREFERENCE_H_
+#define PREPROCESSREFERENCE_H_
+
+#include <cstddef>
+
+#include <cuda_runtime.h>
+
+#include "cudaFilterMode.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief	Resizes a packed float image on the CPU, sampling it like
+ * cudaResize() and cudaResizeRGBA() do with the same filter. FILTER_POINT
+ * output is identical, the other filters round differently and match to
+ * within a small tolerance.
+ * @usage	Verifying and benchmarking the CUDA preprocessing, not camera
+ * frames
+ * @param	input	Host image of inputWidth * inputHeight pixels
+ * @param	inputWidth	Width of the input image
+ * @param	inputHeight	Height of the input image
+ * @param	channels	Floats per pixel, 1 for cudaResize(), 4 for
+ * cudaResizeRGBA()
+ * @param	output	Host image of outputWidth * outputHeight pixels
+ * @param	outputWidth	Width of the output image
+ * @param	outputHeight	Height of the output image
+ * @param	filter	How the input is sampled
+ */
+void referenceResize(const float *input, size_t inputWidth,
+                     size_t inputHeight, size_t channels, float *output,
+                     size_t outputWidth, size_t outputHeight,
+                     cudaFilterMode filter = FILTER_POINT);
+
+/**
+ * @brief	Converts a packed RGB8 image to a resized, mean subtracted, planar
+ * BGR float image on the CPU. With FILTER_POINT it samples the same pixels
+ * with the same float arithmetic as cudaPreImageNetRGB(), so their outputs
+ * are identical.
+ * @usage	Verifying and benchmarking the CUDA preprocessing, not camera
+ * frames
+ * @param	input	Host RGB8 image, inputWidth * inputHeight pixels
+ * @param	inputWidth	Width of the input image
+ * @param	inputHeight	Height of the input image
+ * @param	output	Host buffer of 3 * outputWidth * outputHeight floats
+ * @param	outputWidth	Width of the output planes
+ * @param	outputHeight	Height of the output planes
+ * @param	mean	Mean subtracted from the B, G and R planes
+ * @param	filter	How the input is sampled
+ */
+void referencePreImageNetRGB(const uchar3 *input, size_t inputWidth,
+                             size_t inputHeight, float *output,
+                             size_t outputWidth, size_t outputHeight,
+                             float3 mean, cudaFilterMode filter = FILTER_POINT);
+
+} // namespace jetson_tensorrt
+
+#endif /* PREPROCESSREFERENCE_H_ */
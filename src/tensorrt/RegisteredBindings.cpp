@@ -0,0 +1,162 @@
+/**
+ * @file	RegisteredBindings.cpp
+ * @author	Carroll Vance
+ * @brief	Binding pointers resolved once for reuse across predictions
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "RegisteredBindings.h"
+
+#include <stdexcept>
+
+namespace jetson_tensorrt {
+
+void *resolveBinding(ExecutionBackend *backend, MemoryLocation location,
+                     std::vector<void *> &records, size_t recordSize,
+                     std::function<void *()> allocStaging,
+                     std::vector<BindingTransfer> &transfers) {
+
+  if (location == MemoryLocation::NONE)
+    throw std::invalid_argument("Bindings can not be resolved for memory "
+                                "without a location");
+
+  size_t nbNull = 0;
+  bool contiguous = true;
+
+  for (int b = 0; b < records.size(); b++) {
+    if (records[b] == nullptr)
+      nbNull++;
+    else if (records[b] != (char *)records[0] + b * recordSize)
+      contiguous = false;
+  }
+
+  if (nbNull == records.size()) {
+    if (location != MemoryLocation::DEVICE &&
+        location != MemoryLocation::UNIFIED)
+      throw std::invalid_argument("Only DEVICE and UNIFIED memory can be "
+                                  "left unallocated");
+
+    // The records are read straight out of the staging binding
+    char *binding = (char *)allocStaging();
+    for (int b = 0; b < records.size(); b++)
+      records[b] = binding + b * recordSize;
+
+    return binding;
+  } else if (nbNull > 0) {
+    throw std::invalid_argument("Either every record of a batch or none of "
+                                "them has to be allocated");
+  }
+
+  if (contiguous && (location == MemoryLocation::DEVICE ||
+                     location == MemoryLocation::UNIFIED))
+    return records[0];
+
+  if (contiguous && location == MemoryLocation::MAPPED)
+    return backend->mapBinding(records[0]);
+
+  char *binding = (char *)allocStaging();
+
+  if (contiguous) {
+    transfers.push_back(
+        BindingTransfer(binding, records[0], records.size() * recordSize));
+  } else {
+    for (int b = 0; b < records.size(); b++)
+      transfers.push_back(
+          BindingTransfer(binding + b * recordSize, records[b], recordSize));
+  }
+
+  return binding;
+}
+
+RegisteredBindings::RegisteredBindings(
+    ExecutionBackend *backend, std::vector<NetworkInput> &networkInputs,
+    std::vector<NetworkOutput> &networkOutputs, LocatedExecutionMemory &inputs,
+    LocatedExecutionMemory &outputs) {
+
+  if (inputs.size() == 0 || outputs.size() < inputs.size())
+    throw std::invalid_argument(
+        "Every record of the batch needs inputs and outputs");
+
+  this->backend = backend;
+  this->inputs = inputs.view();
+  this->outputs = outputs.view();
+
+  size_t batchCount = inputs.size();
+
+  try {
+    for (int i = 0; i < networkInputs.size(); i++) {
+      size_t inputSize = networkInputs[i].size();
+
+      std::vector<void *> records;
+      for (int b = 0; b < batchCount; b++)
+        records.push_back(inputs[b][i]);
+
+      if (records[0] == nullptr)
+        throw std::invalid_argument("Inputs have to be allocated");
+
+      bindings.push_back(resolveBinding(
+          backend, inputs.location, records, inputSize,
+          [this, batchCount, inputSize]() {
+            stagingBindings.push_back(
+                this->backend->allocBinding(batchCount * inputSize));
+            return stagingBindings.back();
+          },
+          uploads));
+    }
+
+    for (int o = 0; o < networkOutputs.size(); o++) {
+      size_t outputSize = networkOutputs[o].size();
+
+      std::vector<void *> records;
+      for (int b = 0; b < batchCount; b++)
+        records.push_back(outputs[b][o]);
+
+      bindings.push_back(resolveBinding(
+          backend, outputs.location, records, outputSize,
+          [this, batchCount, outputSize]() {
+            stagingBindings.push_back(
+                this->backend->allocBinding(batchCount * outputSize));
+            return stagingBindings.back();
+          },
+          downloads));
+
+      // Unallocated outputs now point into a staging binding
+      for (int b = 0; b < batchCount; b++) {
+        outputs[b][o] = records[b];
+        this->outputs[b][o] = records[b];
+      }
+    }
+  } catch (...) {
+    for (int s = 0; s < stagingBindings.size(); s++)
+      backend->freeBinding(stagingBindings[s]);
+    throw;
+  }
+}
+
+RegisteredBindings::~RegisteredBindings() {
+  for (int s = 0; s < stagingBindings.size(); s++)
+    backend->freeBinding(stagingBindings[s]);
+}
+
+size_t RegisteredBindings::size() { return inputs.size(); }
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,129 @@
+/**
+ * @file	RegisteredBindings.h
+ * @author	Carroll Vance
+ * @brief	Binding pointers resolved once for reuse across predictions
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef REGISTEREDBINDINGS_H_
+#define REGISTEREDBINDINGS_H_
+
+#include <functional>
+#include <vector>
+
+#include "ExecutionBackend.h"
+#include "TensorRTEngine.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief A copy between caller memory and a binding which is the same for
+ * every prediction
+ */
+struct BindingTransfer {
+  BindingTransfer(void *binding, void *memory, size_t size) {
+    this->binding = binding;
+    this->memory = memory;
+    this->size = size;
+  }
+
+  void *binding;
+  /* Memory of the caller, which can be in any location */
+  void *memory;
+  size_t size;
+};
+
+/**
+ * @brief	Resolves the binding of one tensor of a batch. TensorRT reads the
+ * whole batch of a tensor from a single binding, so records which are not
+ * contiguous device memory are gathered into a staging binding.
+ * @param	backend	The backend the binding is resolved with
+ * @param	location	Location of the records
+ * @param	records	Pointer to every record of the batch. When every record
+ * is NULL, DEVICE and UNIFIED records are pointed into the staging binding.
+ * @param	recordSize	Size of one record in bytes
+ * @param	allocStaging	Returns a binding which can hold the whole batch,
+ * only called when one is needed
+ * @param	transfers	Receives the copies between the records and the
+ * staging binding
+ * @return	The binding
+ */
+void *resolveBinding(ExecutionBackend *backend, MemoryLocation location,
+                     std::vector<void *> &records, size_t recordSize,
+                     std::function<void *()> allocStaging,
+                     std::vector<BindingTransfer> &transfers);
+
+/**
+ * @brief Inputs and outputs whose binding pointers have been resolved once so
+ * they can be predicted on repeatedly without any per call setup.
+ *
+ * MAPPED memory is translated to device pointers at registration, and HOST
+ * memory gets its own binding buffers, so registered bindings can be used
+ * with any context of the engine. A registration must only be predicted on by
+ * one thread at a time.
+ */
+class RegisteredBindings {
+public:
+  /**
+   * @brief	Resolves the bindings of a set of inputs and outputs
+   * @usage	Created by TensorRTEngine::registerBindings()
+   * @param	backend	The backend the bindings are resolved with
+   * @param	networkInputs	Inputs of the network
+   * @param	networkOutputs	Outputs of the network
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex], NULL
+   * DEVICE or UNIFIED outputs are pointed into buffers of the registration
+   */
+  RegisteredBindings(ExecutionBackend *backend,
+                     std::vector<NetworkInput> &networkInputs,
+                     std::vector<NetworkOutput> &networkOutputs,
+                     LocatedExecutionMemory &inputs,
+                     LocatedExecutionMemory &outputs);
+
+  /**
+   * @brief	Frees the binding buffers of HOST memory
+   * @usage	Must be deleted before the engine's backend changes
+   */
+  virtual ~RegisteredBindings();
+
+  /**
+   * @brief	Gets the number of records in the registered batch
+   * @return	Number of records in a batch
+   */
+  size_t size();
+
+  /* Views of the registered memory, which stays owned by the caller */
+  LocatedExecutionMemory inputs;
+  LocatedExecutionMemory outputs;
+
+  std::vector<void *> bindings;
+  std::vector<BindingTransfer> uploads;
+  std::vector<BindingTransfer> downloads;
+
+private:
+  ExecutionBackend *backend;
+  std::vector<void *> stagingBindings;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* REGISTEREDBINDINGS_H_ */
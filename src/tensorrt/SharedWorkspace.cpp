@@ -0,0 +1,128 @@
+/**
+ * @file	SharedWorkspace.cpp
+ * @author	Carroll Vance
+ * @brief	Device workspace shared by engines which take turns executing
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <map>
+
+#include "SharedWorkspace.h"
+
+namespace jetson_tensorrt {
+
+SharedWorkspace::SharedWorkspace() {
+  nextTicket = 0;
+  servingTicket = 0;
+}
+
+SharedWorkspace::~SharedWorkspace() {}
+
+std::shared_ptr<SharedWorkspace>
+SharedWorkspace::named(const std::string &name) {
+  static std::mutex registryMutex;
+  static std::map<std::string, std::weak_ptr<SharedWorkspace>> registry;
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+
+  std::shared_ptr<SharedWorkspace> workspace = registry[name].lock();
+  if (!workspace) {
+    workspace = std::make_shared<SharedWorkspace>();
+    registry[name] = workspace;
+  }
+
+  return workspace;
+}
+
+void SharedWorkspace::waitTurn(std::unique_lock<std::mutex> &lock) {
+  // Tickets hand out turns first come first served, so a busy engine cannot
+  // starve the others
+  unsigned long ticket = nextTicket++;
+  turnEnded.wait(lock, [this, ticket]() { return servingTicket == ticket; });
+}
+
+void SharedWorkspace::endTurn(std::unique_lock<std::mutex> &lock) {
+  servingTicket++;
+  lock.unlock();
+  turnEnded.notify_all();
+}
+
+void SharedWorkspace::reserve(size_t size) {
+  std::unique_lock<std::mutex> lock(workspaceMutex);
+  waitTurn(lock);
+
+  try {
+    if (size > 0 && (!arena || arena->size() < size)) {
+      // Free the old workspace first, the point is to never hold both
+      arena.reset();
+      arena.reset(new MemoryArena(MemoryLocation::DEVICE, size));
+    }
+  } catch (...) {
+    endTurn(lock);
+    throw;
+  }
+
+  endTurn(lock);
+}
+
+void SharedWorkspace::acquire(ExecutionContext *context) {
+  std::unique_lock<std::mutex> lock(workspaceMutex);
+  waitTurn(lock);
+
+  try {
+    // The workspace may have moved since the context last used it
+    context->setWorkspace(arena ? arena->data() : NULL);
+  } catch (...) {
+    endTurn(lock);
+    throw;
+  }
+}
+
+void SharedWorkspace::release() {
+  std::unique_lock<std::mutex> lock(workspaceMutex);
+  endTurn(lock);
+}
+
+size_t SharedWorkspace::size() {
+  std::unique_lock<std::mutex> lock(workspaceMutex);
+  return arena ? arena->size() : 0;
+}
+
+BorrowedWorkspace::BorrowedWorkspace(SharedWorkspace *workspace,
+                                     ExecutionContext *context)
+    : workspace(workspace) {
+  if (workspace)
+    workspace->acquire(context);
+}
+
+BorrowedWorkspace::~BorrowedWorkspace() {
+  if (workspace)
+    workspace->release();
+}
+
+SharedWorkspace *BorrowedWorkspace::detach() {
+  SharedWorkspace *detached = workspace;
+  workspace = NULL;
+  return detached;
+}
+
+} // namespace jetson_tensorrt
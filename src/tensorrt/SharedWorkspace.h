@@ -0,0 +1,142 @@
+/**
+ * @file	SharedWorkspace.h
+ * @author	Carroll Vance
+ * @brief	Device workspace shared by engines which take turns executing
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SHAREDWORKSPACE_H_
+#define SHAREDWORKSPACE_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ExecutionBackend.h"
+#include "MemoryArena.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Device memory which engines execute in instead of each keeping its
+ * own activation memory. It is sized to the largest engine and handed out
+ * to one execution at a time, in the order executions asked for it.
+ *
+ * Engines which never run at the same moment, such as the detector and
+ * classifier of one camera, lose nothing by taking turns and only pay for the
+ * largest workspace instead of the sum of all of them.
+ */
+class SharedWorkspace {
+public:
+  /**
+   * @brief	Creates an empty SharedWorkspace
+   */
+  SharedWorkspace();
+
+  /**
+   * @brief	SharedWorkspace destructor
+   */
+  virtual ~SharedWorkspace();
+
+  /**
+   * @brief	Gets the workspace of this process with a name, creating it if
+   * it does not exist yet
+   * @usage	Lets engines loaded by unrelated code, such as nodelets in one
+   * manager, find each other. The workspace is freed with its last user.
+   * @param	name	Name of the workspace
+   * @return	The workspace
+   */
+  static std::shared_ptr<SharedWorkspace> named(const std::string &name);
+
+  /**
+   * @brief	Grows the workspace to hold at least a number of bytes
+   * @usage	Waits for the current execution to finish before reallocating
+   * @param	size	Workspace size an engine needs in bytes
+   */
+  void reserve(size_t size);
+
+  /**
+   * @brief	Waits for the turn of the caller and points a context at the
+   * workspace
+   * @param	context	The context which is about to execute
+   */
+  void acquire(ExecutionContext *context);
+
+  /**
+   * @brief	Ends the turn of the caller
+   * @usage	Must be called once for every acquire(), after the work using
+   * the workspace has completed
+   */
+  void release();
+
+  /**
+   * @brief	Gets the size of the workspace
+   * @return	Size in bytes
+   */
+  size_t size();
+
+private:
+  SharedWorkspace(const SharedWorkspace &) = delete;
+  SharedWorkspace &operator=(const SharedWorkspace &) = delete;
+
+  void waitTurn(std::unique_lock<std::mutex> &lock);
+  void endTurn(std::unique_lock<std::mutex> &lock);
+
+  std::unique_ptr<MemoryArena> arena;
+
+  std::mutex workspaceMutex;
+  std::condition_variable turnEnded;
+  unsigned long nextTicket, servingTicket;
+};
+
+/**
+ * @brief Scoped turn on a SharedWorkspace
+ */
+class BorrowedWorkspace {
+public:
+  /**
+   * @brief	Waits for a turn on a workspace
+   * @param	workspace	The workspace, NULL when the context owns its memory
+   * @param	context	The context which is about to execute
+   */
+  BorrowedWorkspace(SharedWorkspace *workspace, ExecutionContext *context);
+
+  /**
+   * @brief	Ends the turn unless it was detached
+   */
+  virtual ~BorrowedWorkspace();
+
+  /**
+   * @brief	Stops the turn from ending on destruction
+   * @return	The workspace, which now has to be released by the caller.
+   * NULL when nothing was borrowed.
+   */
+  SharedWorkspace *detach();
+
+private:
+  SharedWorkspace *workspace;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* SHAREDWORKSPACE_H_ */
@@ -0,0 +1,136 @@
+/**
+ * @file	StagingPool.cpp
+ * @author	Carroll Vance
+ * @brief	Fixed size pool of reusable host staging buffers
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdexcept>
+
+#include "StagingPool.h"
+
+namespace jetson_tensorrt {
+
+StagingPool::StagingPool(HostAllocator *allocator, size_t nbBuffers,
+                         size_t bufferSize) {
+  if (allocator == NULL)
+    throw std::invalid_argument("StagingPool requires an allocator");
+
+  if (nbBuffers == 0)
+    throw std::invalid_argument("StagingPool must hold at least one buffer");
+
+  this->allocator = allocator;
+
+  for (size_t b = 0; b < nbBuffers; b++) {
+    StagingBuffer *buffer = new StagingBuffer(b);
+    buffers.push_back(buffer);
+
+    if (bufferSize > 0) {
+      buffer->data = allocator->allocate(bufferSize);
+      buffer->capacity = bufferSize;
+    }
+  }
+
+  // Handed out from the back, so the first buffer is used first
+  freeBuffers.assign(buffers.rbegin(), buffers.rend());
+}
+
+StagingPool::~StagingPool() {
+  for (int b = 0; b < buffers.size(); b++) {
+    allocator->deallocate(buffers[b]->data);
+    delete buffers[b];
+  }
+}
+
+StagingBuffer *StagingPool::tryAcquire(size_t size) {
+  StagingBuffer *buffer;
+
+  {
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    if (freeBuffers.empty())
+      return NULL;
+
+    // The most recently released buffer is the most likely to be cached
+    buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+  }
+
+  return reserve(buffer, size);
+}
+
+StagingBuffer *StagingPool::acquire(size_t size) {
+  StagingBuffer *buffer;
+
+  {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    bufferReleased.wait(lock, [this]() { return !freeBuffers.empty(); });
+
+    buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+  }
+
+  return reserve(buffer, size);
+}
+
+StagingBuffer *StagingPool::reserve(StagingBuffer *buffer, size_t size) {
+  // The buffer is owned by the caller now, so it can grow outside the lock
+  if (buffer->capacity < size) {
+    allocator->deallocate(buffer->data);
+    buffer->data = NULL;
+    buffer->capacity = 0;
+
+    try {
+      buffer->data = allocator->allocate(size);
+    } catch (...) {
+      release(buffer);
+      throw;
+    }
+
+    buffer->capacity = size;
+  }
+
+  buffer->size = size;
+
+  return buffer;
+}
+
+void StagingPool::release(StagingBuffer *buffer) {
+  {
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    buffer->size = 0;
+    freeBuffers.push_back(buffer);
+  }
+  bufferReleased.notify_one();
+}
+
+size_t StagingPool::available() {
+  std::unique_lock<std::mutex> lock(poolMutex);
+  return freeBuffers.size();
+}
+
+size_t StagingPool::size() { return buffers.size(); }
+
+StagingBuffer *StagingPool::at(size_t index) { return buffers.at(index); }
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,143 @@
+/**
+ * @file	StagingPool.h
+ * @author	Carroll Vance
+ * @brief	Fixed size pool of reusable host staging buffers
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef STAGINGPOOL_H_
+#define STAGINGPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "HostAllocator.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief A host buffer of a StagingPool
+ */
+struct StagingBuffer {
+  StagingBuffer(size_t index) {
+    this->index = index;
+    data = NULL;
+    capacity = 0;
+    size = 0;
+  }
+
+  /* Position of the buffer in the pool */
+  size_t index;
+
+  void *data;
+  /* Allocated size in bytes */
+  size_t capacity;
+  /* Size in bytes of the data currently staged in the buffer */
+  size_t size;
+};
+
+/**
+ * @brief Fixed number of host buffers which are recycled instead of being
+ * allocated for every frame. Buffers grow to the largest size requested
+ * from them, so the pool adapts to the frame size without a configuration.
+ */
+class StagingPool {
+public:
+  /**
+   * @brief	Creates a new StagingPool
+   * @param	allocator	Allocates the buffers, must outlive the pool
+   * @param	nbBuffers	Number of buffers in the pool
+   * @param	bufferSize	Size in bytes the buffers are allocated with up
+   * front, 0 to allocate them on first use
+   */
+  StagingPool(HostAllocator *allocator, size_t nbBuffers,
+              size_t bufferSize = 0);
+
+  /**
+   * @brief	StagingPool destructor
+   * @usage	Every buffer must have been released
+   */
+  virtual ~StagingPool();
+
+  /**
+   * @brief	Checks a buffer out of the pool without blocking
+   * @usage	A smaller buffer is reallocated, discarding its contents
+   * @param	size	Number of bytes which will be staged in the buffer
+   * @return	The buffer, which must be returned with release(), or NULL if
+   * every buffer is in use
+   */
+  StagingBuffer *tryAcquire(size_t size);
+
+  /**
+   * @brief	Checks a buffer out of the pool, waiting for one to be released
+   * if every buffer is in use
+   * @usage	A smaller buffer is reallocated, discarding its contents
+   * @param	size	Number of bytes which will be staged in the buffer
+   * @return	The buffer, which must be returned with release()
+   */
+  StagingBuffer *acquire(size_t size);
+
+  /**
+   * @brief	Returns a buffer to the pool
+   * @param	buffer	A buffer returned by tryAcquire()
+   */
+  void release(StagingBuffer *buffer);
+
+  /**
+   * @brief	Gets the number of buffers which are not in use
+   * @return	Number of available buffers
+   */
+  size_t available();
+
+  /**
+   * @brief	Gets the number of buffers in the pool
+   * @return	Number of buffers
+   */
+  size_t size();
+
+  /**
+   * @brief	Gets a buffer by its index
+   * @param	index	Index of the buffer, less than size()
+   * @return	The buffer
+   */
+  StagingBuffer *at(size_t index);
+
+private:
+  StagingPool(const StagingPool &) = delete;
+  StagingPool &operator=(const StagingPool &) = delete;
+
+  StagingBuffer *reserve(StagingBuffer *buffer, size_t size);
+
+  HostAllocator *allocator;
+
+  std::vector<StagingBuffer *> buffers;
+  std::vector<StagingBuffer *> freeBuffers;
+
+  std::mutex poolMutex;
+  std::condition_variable bufferReleased;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* STAGINGPOOL_H_ */
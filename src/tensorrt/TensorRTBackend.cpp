@@ -0,0 +1,231 @@
+/**
+ * @file	TensorRTBackend.cpp
+ * @author	Carroll Vance
+ * @brief	ExecutionBackend implemented with nvinfer1
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cuda_runtime_api.h>
+#include <stdexcept>
+#include <string>
+
+#include "NvInfer.h"
+
+#include "CUDACommon.h"
+#include "TensorRTBackend.h"
+
+namespace jetson_tensorrt {
+
+TensorRTContext::TensorRTContext(nvinfer1::IExecutionContext *context) {
+  this->context = context;
+}
+
+TensorRTContext::~TensorRTContext() { context->destroy(); }
+
+void TensorRTContext::execute(int batchSize, void **bindings) {
+  if (!context->execute(batchSize, bindings))
+    throw std::runtime_error(
+        "TensorRT engine execution returned unsuccessfully");
+}
+
+void TensorRTContext::enqueue(int batchSize, void **bindings,
+                              cudaStream_t stream) {
+  if (!context->enqueue(batchSize, bindings, stream, nullptr))
+    throw std::runtime_error("TensorRT engine enqueue returned unsuccessfully");
+}
+
+void TensorRTContext::setProfiler(nvinfer1::IProfiler *profiler) {
+  context->setProfiler(profiler);
+}
+
+void TensorRTContext::setWorkspace(void *workspace) {
+#if NV_TENSORRT_MAJOR >= 5
+  context->setDeviceMemory(workspace);
+#endif
+}
+
+TensorRTBackend::TensorRTBackend(nvinfer1::ILogger &logger) : logger(logger) {
+  engine = NULL;
+}
+
+TensorRTBackend::TensorRTBackend(nvinfer1::ILogger &logger,
+                                 nvinfer1::ICudaEngine *engine)
+    : logger(logger) {
+  this->engine = engine;
+}
+
+TensorRTBackend::~TensorRTBackend() {
+  if (engine)
+    engine->destroy();
+}
+
+void TensorRTBackend::load(const void *blob, size_t size) {
+  nvinfer1::IRuntime *infer = nvinfer1::createInferRuntime(logger);
+
+  nvinfer1::ICudaEngine *loaded =
+      infer->deserializeCudaEngine(blob, size, NULL);
+
+  infer->destroy();
+
+  if (!loaded)
+    throw std::invalid_argument(
+        "Unable to create engine from deserialized data");
+
+  if (engine)
+    engine->destroy();
+  engine = loaded;
+}
+
+void TensorRTBackend::serialize(std::ostream &out) {
+  nvinfer1::IHostMemory *serMem = engine->serialize();
+
+  if (!serMem)
+    throw std::runtime_error("Unable to serialize TensorRT engine");
+
+  out.write((const char *)serMem->data(), serMem->size());
+
+  serMem->destroy();
+}
+
+ExecutionContext *TensorRTBackend::createContext() {
+  nvinfer1::IExecutionContext *context = engine->createExecutionContext();
+  if (!context)
+    throw std::runtime_error("Unable to create TensorRT execution context");
+
+  return new TensorRTContext(context);
+}
+
+ExecutionContext *TensorRTBackend::createSharedContext() {
+#if NV_TENSORRT_MAJOR >= 5
+  nvinfer1::IExecutionContext *context =
+      engine->createExecutionContextWithoutDeviceMemory();
+  if (!context)
+    throw std::runtime_error("Unable to create TensorRT execution context");
+
+  return new TensorRTContext(context);
+#else
+  return createContext();
+#endif
+}
+
+size_t TensorRTBackend::getWorkspaceSize() {
+#if NV_TENSORRT_MAJOR >= 5
+  return engine->getDeviceMemorySize();
+#else
+  return 0;
+#endif
+}
+
+int TensorRTBackend::getNbBindings() { return engine->getNbBindings(); }
+
+bool TensorRTBackend::bindingIsInput(int index) {
+  return engine->bindingIsInput(index);
+}
+
+nvinfer1::Dims TensorRTBackend::getBindingDimensions(int index) {
+  return engine->getBindingDimensions(index);
+}
+
+void *TensorRTBackend::allocBinding(size_t size) {
+  return safeCudaMalloc(size);
+}
+
+void TensorRTBackend::freeBinding(void *binding) {
+  cudaError_t deviceFreeError = cudaFree(binding);
+  if (deviceFreeError != 0)
+    throw std::runtime_error("Error freeing device memory. CUDA Error: " +
+                             std::to_string(deviceFreeError));
+}
+
+void *TensorRTBackend::mapBinding(void *host) {
+  void *device;
+
+  cudaError_t getDevicePtrError = cudaHostGetDevicePointer(&device, host, 0);
+  if (getDevicePtrError != cudaSuccess)
+    throw std::runtime_error(
+        "Unable to get device pointer for CUDA mapped alloc: " +
+        std::to_string(getDevicePtrError));
+
+  return device;
+}
+
+void TensorRTBackend::copyToBinding(void *binding, const void *host,
+                                    size_t size, cudaStream_t stream,
+                                    bool async) {
+  cudaError_t hostDeviceError;
+  if (async)
+    hostDeviceError =
+        cudaMemcpyAsync(binding, host, size, cudaMemcpyDefault, stream);
+  else
+    hostDeviceError = cudaMemcpy(binding, host, size, cudaMemcpyDefault);
+
+  if (hostDeviceError != 0)
+    throw std::runtime_error("Unable to copy host memory to device for "
+                             "prediction. CUDA Error: " +
+                             std::to_string(hostDeviceError));
+}
+
+void TensorRTBackend::copyFromBinding(void *host, const void *binding,
+                                      size_t size, cudaStream_t stream,
+                                      bool async) {
+  cudaError_t deviceHostError;
+  if (async)
+    deviceHostError =
+        cudaMemcpyAsync(host, binding, size, cudaMemcpyDefault, stream);
+  else
+    deviceHostError = cudaMemcpy(host, binding, size, cudaMemcpyDefault);
+
+  if (deviceHostError != 0)
+    throw std::runtime_error("Unable to copy device memory to host for "
+                             "prediction. CUDA Error: " +
+                             std::to_string(deviceHostError));
+}
+
+/**
+ * @brief	Heap allocated state handed to cudaStreamAddCallback
+ */
+struct StreamCallback {
+  std::function<void(cudaError_t)> callback;
+};
+
+static void CUDART_CB onStreamCallback(cudaStream_t stream, cudaError_t status,
+                                       void *userData) {
+  StreamCallback *streamCallback = (StreamCallback *)userData;
+  streamCallback->callback(status);
+  delete streamCallback;
+}
+
+void TensorRTBackend::addCallback(cudaStream_t stream,
+                                  std::function<void(cudaError_t)> callback) {
+  StreamCallback *streamCallback = new StreamCallback();
+  streamCallback->callback = callback;
+
+  cudaError_t callbackError =
+      cudaStreamAddCallback(stream, onStreamCallback, streamCallback, 0);
+  if (callbackError != cudaSuccess) {
+    delete streamCallback;
+    throw std::runtime_error("Unable to add stream callback: " +
+                             std::to_string(callbackError));
+  }
+}
+
+} // namespace jetson_tensorrt
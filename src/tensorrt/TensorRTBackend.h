@@ -0,0 +1,145 @@
+/**
+ * @file	TensorRTBackend.h
+ * @author	Carroll Vance
+ * @brief	ExecutionBackend implemented with nvinfer1
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TENSORRTBACKEND_H_
+#define TENSORRTBACKEND_H_
+
+#include <memory>
+
+#include "NvInfer.h"
+
+#include "ExecutionBackend.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Deleter of TensorRT objects, which are released with destroy()
+ */
+struct TensorRTDeleter {
+  template <typename T> void operator()(T *object) const { object->destroy(); }
+};
+
+/**
+ * @brief Owns a TensorRT object, i.e. a builder while a network is built
+ */
+template <typename T> using TensorRTPtr = std::unique_ptr<T, TensorRTDeleter>;
+
+/**
+ * @brief ExecutionContext wrapping an nvinfer1::IExecutionContext
+ */
+class TensorRTContext : public ExecutionContext {
+public:
+  /**
+   * @brief	Creates a new TensorRTContext
+   * @param	context	The TensorRT context, which is destroyed with this
+   * object
+   */
+  TensorRTContext(nvinfer1::IExecutionContext *context);
+
+  /**
+   * @brief	TensorRTContext destructor
+   */
+  virtual ~TensorRTContext();
+
+  void execute(int batchSize, void **bindings);
+  void enqueue(int batchSize, void **bindings, cudaStream_t stream);
+  void setProfiler(nvinfer1::IProfiler *profiler);
+
+  /**
+   * @brief	Points a context without device memory at its workspace
+   * @usage	Requires TensorRT 5 or newer, older versions ignore it
+   * @param	workspace	Device memory of at least the engine's
+   * getWorkspaceSize()
+   */
+  void setWorkspace(void *workspace);
+
+  nvinfer1::IExecutionContext *context;
+};
+
+/**
+ * @brief ExecutionBackend which runs networks with TensorRT on the GPU
+ */
+class TensorRTBackend : public ExecutionBackend {
+public:
+  /**
+   * @brief	Creates a TensorRTBackend which will be loaded with load()
+   * @param	logger	Logger for the TensorRT runtime. Must outlive the backend.
+   */
+  TensorRTBackend(nvinfer1::ILogger &logger);
+
+  /**
+   * @brief	Creates a TensorRTBackend from an engine that was just built
+   * @param	logger	Logger for the TensorRT runtime. Must outlive the backend.
+   * @param	engine	The built engine, which is destroyed with the backend
+   */
+  TensorRTBackend(nvinfer1::ILogger &logger, nvinfer1::ICudaEngine *engine);
+
+  /**
+   * @brief	TensorRTBackend destructor
+   */
+  virtual ~TensorRTBackend();
+
+  void load(const void *blob, size_t size);
+  void serialize(std::ostream &out);
+  ExecutionContext *createContext();
+
+  /**
+   * @brief	Creates a context without device memory
+   * @usage	Requires TensorRT 5 or newer, older versions create an ordinary
+   * context which keeps its own memory
+   * @return	The context, owned by the caller
+   */
+  ExecutionContext *createSharedContext();
+
+  /**
+   * @brief	Gets the device memory a context of the engine needs
+   * @return	Size in bytes, 0 before TensorRT 5
+   */
+  size_t getWorkspaceSize();
+
+  int getNbBindings();
+  bool bindingIsInput(int index);
+  nvinfer1::Dims getBindingDimensions(int index);
+
+  void *allocBinding(size_t size);
+  void freeBinding(void *binding);
+  void *mapBinding(void *host);
+  void copyToBinding(void *binding, const void *host, size_t size,
+                     cudaStream_t stream, bool async);
+  void copyFromBinding(void *host, const void *binding, size_t size,
+                       cudaStream_t stream, bool async);
+  void addCallback(cudaStream_t stream,
+                   std::function<void(cudaError_t)> callback);
+
+  nvinfer1::ICudaEngine *engine;
+
+private:
+  nvinfer1::ILogger &logger;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* TENSORRTBACKEND_H_ */
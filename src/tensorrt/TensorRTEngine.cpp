@@ -29,9 +29,8 @@
 #include <cassert>
 #include <chrono>
 #include <cstdlib>
-#include <cuda_runtime_api.h>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -39,12 +38,12 @@
 #include <unordered_map>
 #include <vector>
 
-#include "NvInfer.h"
-#include "NvUtils.h"
+#include "BackendTypes.h"
 
 using namespace nvinfer1;
 
 #include "CUDACommon.h"
+#include "RegisteredBindings.h"
 #include "TensorRTEngine.h"
 
 namespace jetson_tensorrt {
@@ -52,250 +51,656 @@ namespace jetson_tensorrt {
 TensorRTEngine::TensorRTEngine() {
   numBindings = 0;
   maxBatchSize = 0;
-  context = NULL;
-  engine = NULL;
-  gpuBufferPreAllocated = false;
+  backend = NULL;
+  contextPoolSize = 1;
+  profiler = NULL;
+  stoppingBuilds = false;
   dataType = nvinfer1::DataType::kFLOAT;
 }
 
 TensorRTEngine::~TensorRTEngine() {
   /* Clean up */
-  context->destroy();
-  engine->destroy();
+  clearFamily();
+  contextPool.destroy();
 
-  freeGPUBuffer();
+  delete backend;
+  delete profiler;
 }
 
-void TensorRTEngine::allocGPUBuffer() {
-  int stepSize = networkInputs.size() + networkOutputs.size();
+void TensorRTEngine::attachBackend(ExecutionBackend *backend,
+                                   size_t maxBatchSize) {
+  // Contexts and buffers belong to the previous backend, and networks of
+  // other batch sizes to the previous model
+  clearFamily();
+  contextPool.destroy();
 
-  preAllocatedGPUBuffers = std::vector<void *>(maxBatchSize * stepSize);
+  if (this->backend != backend)
+    delete this->backend;
 
-  /* Allocate GPU Input memory and move input data to it for each batch*/
-  for (int b = 0; b < maxBatchSize; b++) {
+  this->backend = backend;
+  this->maxBatchSize = maxBatchSize;
+  this->numBindings = backend->getNbBindings();
 
-    /* Allocate GPU Input memory */
-    int bindingIdx = 0;
-    for (int i = 0; i < networkInputs.size(); i++) {
-      size_t inputSize = networkInputs[i].size();
+  createContexts();
+}
 
-      preAllocatedGPUBuffers[bindingIdx + b * stepSize] =
-          safeCudaMalloc(inputSize);
-      bindingIdx++;
-    }
+void TensorRTEngine::setContextPoolSize(size_t size) {
+  {
+    // Networks which finish building read the settings
+    std::lock_guard<std::mutex> lock(familyMutex);
+    contextPoolSize = size;
+  }
+
+  if (backend)
+    createContexts();
+}
+
+void TensorRTEngine::shareWorkspace(
+    std::shared_ptr<SharedWorkspace> workspace) {
+  {
+    std::lock_guard<std::mutex> lock(familyMutex);
+    this->workspace = workspace;
+  }
+
+  if (backend)
+    createContexts();
+}
+
+void TensorRTEngine::createContexts() {
+  createPool(contextPool, backend, maxBatchSize);
+
+  std::lock_guard<std::mutex> lock(familyMutex);
+  for (int f = 0; f < family.size(); f++)
+    if (family[f]->state == BatchEngine::READY)
+      createPool(family[f]->contextPool, family[f]->backend,
+                 family[f]->maxBatchSize);
+}
+
+void TensorRTEngine::createPool(ExecutionContextPool &pool,
+                                ExecutionBackend *backend,
+                                size_t maxBatchSize) {
+  // Contexts owning their memory are freed before the workspace grows
+  pool.create(backend, maxBatchSize, contextPoolSize, workspace != nullptr);
+  pool.setProfiler(profiler);
+
+  if (workspace)
+    workspace->reserve(backend->getWorkspaceSize());
+}
+
+void TensorRTEngine::setBackendFactory(BackendFactory factory) {
+  std::lock_guard<std::mutex> lock(familyMutex);
+  backendFactory = factory;
+}
+
+void TensorRTEngine::setBatchSizes(std::vector<size_t> batchSizes) {
+  if (!backend)
+    throw std::runtime_error("No network has been loaded");
+
+  std::sort(batchSizes.begin(), batchSizes.end());
+  batchSizes.erase(std::unique(batchSizes.begin(), batchSizes.end()),
+                   batchSizes.end());
+
+  for (int b = 0; b < batchSizes.size(); b++)
+    if (batchSizes[b] == 0 || batchSizes[b] > maxBatchSize)
+      throw std::invalid_argument(
+          "Batch sizes must be between 1 and the maximum batch size");
+
+  // The network for maxBatchSize is the one already loaded
+  batchSizes.erase(std::remove(batchSizes.begin(), batchSizes.end(),
+                               (size_t)maxBatchSize),
+                   batchSizes.end());
+
+  clearFamily();
+
+  std::lock_guard<std::mutex> lock(familyMutex);
 
-    /* Allocate GPU Output memory */
-    for (int o = 0; o < networkOutputs.size(); o++) {
-      size_t outputSize = networkOutputs[o].size();
+  if (!batchSizes.empty() && !backendFactory)
+    throw std::invalid_argument("Batch sizes need a backend factory");
 
-      preAllocatedGPUBuffers[bindingIdx + b * stepSize] =
-          safeCudaMalloc(outputSize);
-      bindingIdx++;
+  for (int b = 0; b < batchSizes.size(); b++)
+    family.push_back(new BatchEngine(batchSizes[b]));
+
+  if (!family.empty())
+    familyBuilder = std::thread(&TensorRTEngine::buildFamily, this);
+}
+
+void TensorRTEngine::buildBatchSizes() {
+  std::unique_lock<std::mutex> lock(familyMutex);
+
+  for (int f = 0; f < family.size(); f++)
+    if (family[f]->state == BatchEngine::UNBUILT)
+      family[f]->state = BatchEngine::QUEUED;
+  familyChanged.notify_all();
+
+  familyChanged.wait(lock, [this]() {
+    for (int f = 0; f < family.size(); f++)
+      if (family[f]->state == BatchEngine::QUEUED)
+        return false;
+    return true;
+  });
+}
+
+std::vector<size_t> TensorRTEngine::getBuiltBatchSizes() {
+  std::lock_guard<std::mutex> lock(familyMutex);
+
+  std::vector<size_t> built;
+  for (int f = 0; f < family.size(); f++)
+    if (family[f]->state == BatchEngine::READY)
+      built.push_back(family[f]->maxBatchSize);
+
+  if (backend)
+    built.push_back(maxBatchSize);
+
+  return built;
+}
+
+ExecutionContextPool &TensorRTEngine::selectPool(size_t batchSize) {
+  std::lock_guard<std::mutex> lock(familyMutex);
+
+  bool requested = false;
+  for (int f = 0; f < family.size(); f++) {
+    BatchEngine *member = family[f];
+    if (member->maxBatchSize < batchSize)
+      continue;
+
+    if (member->state == BatchEngine::READY)
+      return member->contextPool;
+
+    // Only the best fitting network is built on demand, larger ones are
+    // only useful once they are built anyway
+    if (!requested && member->state == BatchEngine::UNBUILT) {
+      member->state = BatchEngine::QUEUED;
+      familyChanged.notify_all();
     }
+    if (member->state != BatchEngine::FAILED)
+      requested = true;
   }
 
-  gpuBufferPreAllocated = true;
+  return contextPool;
 }
 
-void TensorRTEngine::freeGPUBuffer() {
+ExecutionContextPool &TensorRTEngine::slotPool(ExecutionSlot *slot) {
+  std::lock_guard<std::mutex> lock(familyMutex);
+
+  for (int f = 0; f < family.size(); f++)
+    if (family[f]->backend == slot->backend)
+      return family[f]->contextPool;
+
+  return contextPool;
+}
 
-  if (gpuBufferPreAllocated) {
+void TensorRTEngine::buildFamily() {
+  std::unique_lock<std::mutex> lock(familyMutex);
+
+  while (true) {
+    BatchEngine *member = NULL;
+    familyChanged.wait(lock, [this, &member]() {
+      for (int f = 0; f < family.size() && !member; f++)
+        if (family[f]->state == BatchEngine::QUEUED)
+          member = family[f];
+      return stoppingBuilds || member;
+    });
+
+    if (stoppingBuilds)
+      return;
+
+    // Building takes long, batches keep running on the other networks
+    BackendFactory factory = backendFactory;
+    lock.unlock();
+
+    ExecutionBackend *built = NULL;
+    std::string error;
+    try {
+      built = factory(member->maxBatchSize);
+      if (!built)
+        throw std::runtime_error("Backend factory returned no network");
+      if (built->getNbBindings() != numBindings)
+        throw std::invalid_argument("Network bindings do not match");
+    } catch (std::exception &e) {
+      error = e.what();
+    }
+
+    lock.lock();
+
+    if (error.empty()) {
+      try {
+        createPool(member->contextPool, built, member->maxBatchSize);
+      } catch (std::exception &e) {
+        member->contextPool.destroy();
+        error = e.what();
+      }
+    }
 
-    /* Move outputs back to host memory for each batch */
-    for (int b = 0; b < preAllocatedGPUBuffers.size(); b++) {
-      cudaError_t deviceFreeError = cudaFree(preAllocatedGPUBuffers[b]);
-      if (deviceFreeError != 0)
-        throw std::runtime_error("Error freeing device memory. CUDA Error: " +
-                                 std::to_string(deviceFreeError));
+    if (error.empty()) {
+      member->backend = built;
+      member->state = BatchEngine::READY;
+    } else {
+      // Batches of this size keep running on a larger network
+      delete built;
+      member->state = BatchEngine::FAILED;
+      logger.log(nvinfer1::ILogger::Severity::kWARNING,
+                 ("Unable to build network for batch size " +
+                  std::to_string(member->maxBatchSize) + ": " + error)
+                     .c_str());
     }
 
-    gpuBufferPreAllocated = false;
+    familyChanged.notify_all();
   }
 }
 
-LocatedExecutionMemory TensorRTEngine::allocInputs(MemoryLocation location,
-                                                   bool skipMalloc) {
+void TensorRTEngine::clearFamily() {
+  {
+    std::lock_guard<std::mutex> lock(familyMutex);
+    stoppingBuilds = true;
+  }
+  familyChanged.notify_all();
+
+  if (familyBuilder.joinable())
+    familyBuilder.join();
+
+  std::lock_guard<std::mutex> lock(familyMutex);
+
+  for (int f = 0; f < family.size(); f++) {
+    family[f]->contextPool.destroy();
+    delete family[f]->backend;
+    delete family[f];
+  }
+
+  family.clear();
+  stoppingBuilds = false;
+}
+
+LayerProfiler *TensorRTEngine::enableProfiling(size_t window) {
+  LayerProfiler *enabled = new LayerProfiler(window);
+  LayerProfiler *previous;
+
+  contextPool.setProfiler(enabled);
+  {
+    std::lock_guard<std::mutex> lock(familyMutex);
+    for (int f = 0; f < family.size(); f++)
+      family[f]->contextPool.setProfiler(enabled);
+
+    previous = profiler;
+    profiler = enabled;
+  }
+
+  delete previous;
+
+  return enabled;
+}
+
+void TensorRTEngine::disableProfiling() {
+  LayerProfiler *previous;
+
+  contextPool.setProfiler(NULL);
+  {
+    std::lock_guard<std::mutex> lock(familyMutex);
+    for (int f = 0; f < family.size(); f++)
+      family[f]->contextPool.setProfiler(NULL);
+
+    previous = profiler;
+    profiler = NULL;
+  }
+
+  delete previous;
+}
+
+LayerProfiler *TensorRTEngine::getProfiler() { return profiler; }
+
+ExecutionSlot *TensorRTEngine::acquireContext(size_t batchSize) {
+  if (batchSize == 0)
+    return contextPool.acquire();
+
+  return selectPool(batchSize).acquire();
+}
+
+void TensorRTEngine::releaseContext(ExecutionSlot *slot) {
+  slotPool(slot).release(slot);
+}
+
+void *TensorRTEngine::slotBinding(ExecutionSlot &slot, int bindingIdx,
+                                  size_t recordSize) {
+  if (slot.preAllocatedGPUBuffers.size() != numBindings)
+    slot.preAllocatedGPUBuffers = std::vector<void *>(numBindings, nullptr);
+
+  // Sized for the largest batch, so it is allocated once per context
+  if (slot.preAllocatedGPUBuffers[bindingIdx] == nullptr)
+    slot.preAllocatedGPUBuffers[bindingIdx] =
+        slot.backend->allocBinding(slot.maxBatchSize * recordSize);
+
+  return slot.preAllocatedGPUBuffers[bindingIdx];
+}
+
+LocatedExecutionMemory TensorRTEngine::allocTensors(std::vector<size_t> sizes,
+                                                    MemoryLocation location,
+                                                    bool skipMalloc,
+                                                    bool hugePages) {
   LocatedExecutionMemory memory = LocatedExecutionMemory(
-      location, std::vector<std::vector<void *>>(maxBatchSize));
-
-  for (int b = 0; b < maxBatchSize; b++) {
-
-    /* Input memory management */
-    for (int i = 0; i < networkInputs.size(); i++) {
-      size_t inputSize = networkInputs[i].size();
-      if (skipMalloc || location == MemoryLocation::NONE) {
-        memory[b].push_back(nullptr);
-      } else if (location == MemoryLocation::HOST) {
-        memory[b].push_back(safeMalloc(inputSize));
-      } else if (location == MemoryLocation::DEVICE) {
-        memory[b].push_back(safeCudaMalloc(inputSize));
-      } else if (location == MemoryLocation::MAPPED) {
-        memory[b].push_back(safeCudaHostMalloc(inputSize));
-      } else if (location == MemoryLocation::UNIFIED) {
-        memory[b].push_back(safeCudaUnifiedMalloc(inputSize));
-      }
-    }
+      location, std::vector<std::vector<void *>>(
+                    maxBatchSize, std::vector<void *>(sizes.size(), nullptr)));
+
+  if (skipMalloc || location == MemoryLocation::NONE)
+    return memory;
+
+  // Tensor major, so the records of a tensor are contiguous like the binding
+  // of a batch, and every tensor starts aligned
+  std::vector<size_t> offsets;
+  size_t arenaSize = 0;
+
+  for (int t = 0; t < sizes.size(); t++) {
+    offsets.push_back(arenaSize);
+    arenaSize += MemoryArena::align(sizes[t] * maxBatchSize);
   }
 
+  if (arenaSize == 0)
+    return memory;
+
+  memory.arena.reset(new MemoryArena(location, arenaSize, hugePages));
+  char *base = (char *)memory.arena->data();
+
+  for (int b = 0; b < maxBatchSize; b++)
+    for (int t = 0; t < sizes.size(); t++)
+      memory[b][t] = base + offsets[t] + b * sizes[t];
+
   return memory;
-} // namespace jetson_tensorrt
+}
+
+LocatedExecutionMemory TensorRTEngine::allocInputs(MemoryLocation location,
+                                                   bool skipMalloc,
+                                                   bool hugePages) {
+  std::vector<size_t> sizes;
+  for (int i = 0; i < networkInputs.size(); i++)
+    sizes.push_back(networkInputs[i].size());
+
+  return allocTensors(sizes, location, skipMalloc, hugePages);
+}
 
 LocatedExecutionMemory TensorRTEngine::allocOutputs(MemoryLocation location,
-                                                    bool skipMalloc) {
-  LocatedExecutionMemory memory = LocatedExecutionMemory(
-      location, std::vector<std::vector<void *>>(maxBatchSize));
-
-  for (int b = 0; b < maxBatchSize; b++) {
-
-    /* Input memory management */
-    for (int o = 0; o < networkOutputs.size(); o++) {
-      size_t outputSize = networkOutputs[o].size();
-      if (skipMalloc || location == MemoryLocation::NONE) {
-        memory[b].push_back(nullptr);
-      } else if (location == MemoryLocation::HOST) {
-        memory[b].push_back(safeMalloc(outputSize));
-      } else if (location == MemoryLocation::DEVICE) {
-        memory[b].push_back(safeCudaMalloc(outputSize));
-      } else if (location == MemoryLocation::MAPPED) {
-        memory[b].push_back(safeCudaHostMalloc(outputSize));
-      } else if (location == MemoryLocation::UNIFIED) {
-        memory[b].push_back(safeCudaUnifiedMalloc(outputSize));
-      }
-    }
+                                                    bool skipMalloc,
+                                                    bool hugePages) {
+  std::vector<size_t> sizes;
+  for (int o = 0; o < networkOutputs.size(); o++)
+    sizes.push_back(networkOutputs[o].size());
+
+  return allocTensors(sizes, location, skipMalloc, hugePages);
+}
+
+void TensorRTEngine::allocMissingOutputs(LocatedExecutionMemory &outputs,
+                                         int batchCount) {
+  // Other locations can not be left unallocated, which resolving rejects
+  if (outputs.location != MemoryLocation::DEVICE &&
+      outputs.location != MemoryLocation::UNIFIED)
+    return;
+
+  std::vector<int> missing;
+  std::vector<size_t> offsets;
+  size_t arenaSize = 0;
+
+  for (int o = 0; o < networkOutputs.size(); o++) {
+    bool unallocated = true;
+    for (int b = 0; b < batchCount; b++)
+      unallocated = unallocated && outputs[b][o] == nullptr;
+
+    if (!unallocated)
+      continue;
+
+    for (int b = batchCount; b < outputs.size(); b++)
+      if (outputs[b][o] != nullptr)
+        throw std::invalid_argument("Either every record of an output or "
+                                    "none of them has to be allocated");
+
+    missing.push_back(o);
+    offsets.push_back(arenaSize);
+    arenaSize += MemoryArena::align(networkOutputs[o].size() * outputs.size());
   }
 
-  return memory;
-} // namespace jetson_tensorrt
+  if (arenaSize == 0)
+    return;
 
-void TensorRTEngine::predict(LocatedExecutionMemory &inputs,
-                             LocatedExecutionMemory &outputs) {
+  if (outputs.arena)
+    throw std::invalid_argument(
+        "Outputs which own memory have to be allocated");
 
-  if (inputs.size() > maxBatchSize)
+  // Every record of the structure, so larger batches reuse the memory
+  outputs.arena.reset(new MemoryArena(outputs.location, arenaSize));
+  char *base = (char *)outputs.arena->data();
+
+  for (int m = 0; m < missing.size(); m++) {
+    size_t outputSize = networkOutputs[missing[m]].size();
+    for (int b = 0; b < outputs.size(); b++)
+      outputs[b][missing[m]] = base + offsets[m] + b * outputSize;
+  }
+}
+
+std::vector<void *>
+TensorRTEngine::bindTransaction(ExecutionSlot &slot,
+                                LocatedExecutionMemory &inputs,
+                                LocatedExecutionMemory &outputs,
+                                std::vector<BindingTransfer> &uploads,
+                                std::vector<BindingTransfer> &downloads) {
+
+  if (inputs.size() > slot.maxBatchSize)
     throw std::invalid_argument(
         "Passed batch is larger than maximum batch size");
 
+  if (inputs.size() == 0 || outputs.size() < inputs.size())
+    throw std::invalid_argument(
+        "Every record of the batch needs inputs and outputs");
+
   int batchCount = inputs.size();
-  int stepSize = networkInputs.size() + networkOutputs.size();
 
-  std::vector<void *> transactionGPUBuffers(inputs.size() * stepSize);
+  // The context's buffers are overwritten by the next prediction once the
+  // slot is released, so unallocated outputs get memory owned by outputs
+  allocMissingOutputs(outputs, batchCount);
 
-  if ((inputs.location == MemoryLocation::HOST ||
-       outputs.location == MemoryLocation::HOST) &&
-      !gpuBufferPreAllocated)
-    allocGPUBuffer();
+  // One binding per tensor which holds the whole batch
+  std::vector<void *> transactionGPUBuffers;
 
-  /* Assign transaction buffers and copy to GPU if neccisary */
-  for (int b = 0; b < batchCount; b++) {
-    int bindingIdx = 0;
+  for (int i = 0; i < networkInputs.size(); i++) {
+    size_t inputSize = networkInputs[i].size();
 
-    /* Input memory management */
-    for (int i = 0; i < networkInputs.size(); i++) {
-      size_t inputSize = networkInputs[i].size();
+    std::vector<void *> records;
+    for (int b = 0; b < batchCount; b++)
+      records.push_back(inputs[b][i]);
 
-      if (inputs.location == MemoryLocation::MAPPED) {
+    if (records[0] == nullptr)
+      throw std::invalid_argument("Inputs have to be allocated");
 
-        cudaError_t getDevicePtrError = cudaHostGetDevicePointer(
-            &transactionGPUBuffers[bindingIdx + b * stepSize], inputs[b][i], 0);
-        if (getDevicePtrError != cudaSuccess) {
-          throw std::runtime_error(
-              "Unable to get device pointer for CUDA mapped alloc: " +
-              std::to_string(getDevicePtrError));
-        }
+    int bindingIdx = transactionGPUBuffers.size();
+    transactionGPUBuffers.push_back(resolveBinding(
+        slot.backend, inputs.location, records, inputSize,
+        [this, &slot, bindingIdx, inputSize]() {
+          return slotBinding(slot, bindingIdx, inputSize);
+        },
+        uploads));
+  }
 
-      } else if (inputs.location == MemoryLocation::HOST) {
+  for (int o = 0; o < networkOutputs.size(); o++) {
+    size_t outputSize = networkOutputs[o].size();
 
-        // If the batches are in host memory, we need to copy them to the device
-        transactionGPUBuffers[bindingIdx + b * stepSize] =
-            preAllocatedGPUBuffers[bindingIdx + b * stepSize];
+    std::vector<void *> records;
+    for (int b = 0; b < batchCount; b++)
+      records.push_back(outputs[b][o]);
 
-        cudaError_t hostDeviceError =
-            cudaMemcpy(transactionGPUBuffers[bindingIdx + b * stepSize],
-                       inputs[b][i], inputSize, cudaMemcpyHostToDevice);
-        if (hostDeviceError != 0)
-          throw std::runtime_error("Unable to copy host memory to device for "
-                                   "prediction. CUDA Error: " +
-                                   std::to_string(hostDeviceError));
+    int bindingIdx = transactionGPUBuffers.size();
+    transactionGPUBuffers.push_back(resolveBinding(
+        slot.backend, outputs.location, records, outputSize,
+        [this, &slot, bindingIdx, outputSize]() {
+          return slotBinding(slot, bindingIdx, outputSize);
+        },
+        downloads));
+  }
 
-      } else if (inputs.location == MemoryLocation::DEVICE ||
-                 inputs.location == MemoryLocation::UNIFIED) {
+  return transactionGPUBuffers;
+}
 
-        // Since the inputs are already in the device, all we need to do is
-        // assign them to the transaction buffer
-        transactionGPUBuffers[bindingIdx + b * stepSize] = inputs[b][i];
-      }
-      bindingIdx++;
+void TensorRTEngine::uploadBindings(ExecutionBackend *backend,
+                                    std::vector<BindingTransfer> &uploads,
+                                    cudaStream_t stream, bool async) {
+  for (int u = 0; u < uploads.size(); u++)
+    backend->copyToBinding(uploads[u].binding, uploads[u].memory,
+                           uploads[u].size, stream, async);
+}
+
+void TensorRTEngine::downloadBindings(ExecutionBackend *backend,
+                                      std::vector<BindingTransfer> &downloads,
+                                      cudaStream_t stream, bool async) {
+  for (int d = 0; d < downloads.size(); d++)
+    backend->copyFromBinding(downloads[d].memory, downloads[d].binding,
+                             downloads[d].size, stream, async);
+}
+
+void TensorRTEngine::enqueueInference(ExecutionSlot *slot, int batchSize,
+                                      void **bindings, cudaStream_t stream) {
+  BorrowedWorkspace borrowed(workspace.get(), slot->context);
+
+  slot->context->enqueue(batchSize, bindings, stream);
+
+  // The next engine may start as soon as the inference is done, the output
+  // copies do not touch the workspace
+  SharedWorkspace *shared = borrowed.detach();
+  if (shared) {
+    try {
+      slot->backend->addCallback(
+          stream, [shared](cudaError_t status) { shared->release(); });
+    } catch (...) {
+      shared->release();
+      throw;
     }
+  }
+}
 
-    /* Output memory management */
-    for (int o = 0; o < networkOutputs.size(); o++) {
+void TensorRTEngine::predict(LocatedExecutionMemory &inputs,
+                             LocatedExecutionMemory &outputs) {
+  PooledExecutionSlot pooled(selectPool(inputs.size()));
 
-      size_t outputSize = networkOutputs[o].size();
+  predict(pooled.slot, inputs, outputs);
+}
 
-      if (outputs.location == MemoryLocation::MAPPED) {
+void TensorRTEngine::predict(ExecutionSlot *slot,
+                             LocatedExecutionMemory &inputs,
+                             LocatedExecutionMemory &outputs) {
 
-        cudaError_t getDevicePtrError = cudaHostGetDevicePointer(
-            &transactionGPUBuffers[bindingIdx + b * stepSize], outputs[b][o],
-            0);
-        if (getDevicePtrError != cudaSuccess) {
-          throw std::runtime_error(
-              "Unable to get device pointer for CUDA mapped alloc: " +
-              std::to_string(getDevicePtrError));
-        }
+  std::vector<BindingTransfer> uploads, downloads;
+  std::vector<void *> transactionGPUBuffers =
+      bindTransaction(*slot, inputs, outputs, uploads, downloads);
 
-      } else if (outputs.location == MemoryLocation::DEVICE ||
-                 outputs.location == MemoryLocation::UNIFIED) {
-        // Since the inputs are already in the device, all we need to do is
-        // assign them to the transaction buffer
-        transactionGPUBuffers[bindingIdx + b * stepSize] = outputs[b][o];
-      } else if (outputs.location == MemoryLocation::HOST) {
+  uploadBindings(slot->backend, uploads, 0, false);
 
-        transactionGPUBuffers[bindingIdx + b * stepSize] =
-            preAllocatedGPUBuffers[bindingIdx + b * stepSize];
-      }
+  /* Do the inference */
+  {
+    BorrowedWorkspace borrowed(workspace.get(), slot->context);
+    slot->context->execute(inputs.size(), &transactionGPUBuffers[0]);
+  }
 
-      bindingIdx++;
-    }
+  downloadBindings(slot->backend, downloads, 0, false);
+}
+
+void TensorRTEngine::predictAsync(LocatedExecutionMemory &inputs,
+                                  LocatedExecutionMemory &outputs,
+                                  cudaStream_t stream,
+                                  std::function<void(cudaError_t)> callback) {
+  ExecutionContextPool *pool = &selectPool(inputs.size());
+  PooledExecutionSlot pooled(*pool);
+  ExecutionSlot *slot = pooled.slot;
+
+  std::vector<BindingTransfer> uploads, downloads;
+  std::vector<void *> transactionGPUBuffers =
+      bindTransaction(*slot, inputs, outputs, uploads, downloads);
+
+  uploadBindings(slot->backend, uploads, stream, true);
+
+  /* Enqueue the inference */
+  enqueueInference(slot, inputs.size(), &transactionGPUBuffers[0], stream);
+
+  downloadBindings(slot->backend, downloads, stream, true);
+
+  // The context stays checked out until the stream reaches this point
+  pooled.detach();
+
+  try {
+    slot->backend->addCallback(
+        stream, [pool, slot, callback](cudaError_t status) {
+          pool->release(slot);
+          callback(status);
+        });
+  } catch (...) {
+    pool->release(slot);
+    throw;
   }
+}
 
-  /* Do the inference */
-  if (!context->execute(batchCount, &transactionGPUBuffers[0]))
-    throw std::runtime_error(
-        "TensorRT engine execution returned unsuccessfully");
+RegisteredBindings *
+TensorRTEngine::registerBindings(LocatedExecutionMemory &inputs,
+                                 LocatedExecutionMemory &outputs) {
 
-  /* Handle outputs for each batch */
-  for (int b = 0; b < batchCount; b++) {
+  if (inputs.size() > maxBatchSize)
+    throw std::invalid_argument(
+        "Passed batch is larger than maximum batch size");
+
+  return new RegisteredBindings(backend, networkInputs, networkOutputs, inputs,
+                                outputs);
+}
+
+void TensorRTEngine::predict(RegisteredBindings &registered) {
+  PooledExecutionSlot pooled(selectPool(registered.size()));
+  ExecutionSlot *slot = pooled.slot;
 
-    int bindingIdx = inputs[b].size();
-    for (int o = 0; o < networkOutputs.size(); o++) {
-      size_t outputSize = networkOutputs[o].size();
+  uploadBindings(slot->backend, registered.uploads, 0, false);
 
-      if (outputs.location == MemoryLocation::MAPPED ||
-          outputs.location == MemoryLocation::UNIFIED) {
+  {
+    BorrowedWorkspace borrowed(workspace.get(), slot->context);
+    slot->context->execute(registered.size(), &registered.bindings[0]);
+  }
 
-        // Don't need to do anything, memory is already mapped
+  downloadBindings(slot->backend, registered.downloads, 0, false);
+}
 
-      } else if (outputs.location == MemoryLocation::DEVICE) {
+void TensorRTEngine::predictAsync(RegisteredBindings &registered,
+                                  cudaStream_t stream,
+                                  std::function<void(cudaError_t)> callback) {
+  ExecutionContextPool *pool = &selectPool(registered.size());
+  PooledExecutionSlot pooled(*pool);
+  ExecutionSlot *slot = pooled.slot;
 
-        // Copy the GPU pointer
-        outputs[b][o] = transactionGPUBuffers[bindingIdx + b * stepSize];
+  uploadBindings(slot->backend, registered.uploads, stream, true);
 
-      } else if (outputs.location == MemoryLocation::HOST) {
+  enqueueInference(slot, registered.size(), &registered.bindings[0], stream);
 
-        // Transfer memory from GPU back to Host
-        cudaError_t deviceHostError = cudaMemcpy(
-            outputs[b][o], transactionGPUBuffers[bindingIdx + b * stepSize],
-            outputSize, cudaMemcpyDeviceToHost);
-        if (deviceHostError != 0)
-          throw std::runtime_error("Unable to copy device memory to host for "
-                                   "prediction. CUDA Error: " +
-                                   std::to_string(deviceHostError));
-      }
+  downloadBindings(slot->backend, registered.downloads, stream, true);
 
-      bindingIdx++;
-    }
+  pooled.detach();
+
+  try {
+    slot->backend->addCallback(
+        stream, [pool, slot, callback](cudaError_t status) {
+          pool->release(slot);
+          callback(status);
+        });
+  } catch (...) {
+    pool->release(slot);
+    throw;
   }
+}
 
-} // namespace jetson_tensorrt
+std::future<void> TensorRTEngine::predictAsync(LocatedExecutionMemory &inputs,
+                                               LocatedExecutionMemory &outputs,
+                                               cudaStream_t stream) {
+
+  std::shared_ptr<std::promise<void>> promise =
+      std::make_shared<std::promise<void>>();
+
+  predictAsync(inputs, outputs, stream, [promise](cudaError_t status) {
+    if (status == cudaSuccess)
+      promise->set_value();
+    else
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(
+          "Asynchronous prediction failed. CUDA Error: " +
+          std::to_string(status))));
+  });
+
+  return promise->get_future();
+}
 
 std::string TensorRTEngine::engineSummary() {
 
@@ -303,11 +708,10 @@ std::string TensorRTEngine::engineSummary() {
 
   for (int i = 0; i < numBindings; ++i) {
 
-    Dims dims = engine->getBindingDimensions(i);
-    DataType dtype = engine->getBindingDataType(i);
+    Dims dims = backend->getBindingDimensions(i);
 
     summary << "--Binding " << i << "--" << std::endl;
-    if (engine->bindingIsInput(i))
+    if (backend->bindingIsInput(i))
       summary << "Type: Input";
     else
       summary << "Type: Output";
@@ -317,64 +721,20 @@ std::string TensorRTEngine::engineSummary() {
       summary << dims.d[j] << ",";
     summary << ")" << std::endl;
   }
-  return summary.str();
-}
-
-void TensorRTEngine::saveCache(std::string cachePath) {
-  // Serialize the loaded model
-  nvinfer1::IHostMemory *serMem = engine->serialize();
 
-  if (!serMem)
-    throw std::runtime_error("Unable to serialize TensorRT engine");
-
-  // Write the cache file to the disk
-  std::ofstream cache;
-  cache.open(cachePath.c_str());
-  cache.write((const char *)serMem->data(), serMem->size());
-  cache.close();
-
-  // Cleanup
-  serMem->destroy();
-}
+  std::vector<size_t> built = getBuiltBatchSizes();
+  summary << "--Batch sizes--" << std::endl;
+  for (int b = 0; b < built.size(); b++)
+    summary << built[b] << (b + 1 < built.size() ? "," : "");
+  summary << std::endl;
 
-void TensorRTEngine::loadCache(std::string cachePath, size_t maxBatchSize) {
-
-  // Read the cache file from the disk and load it into a stringstream
-  std::ifstream cache;
-  cache.open(cachePath);
-  if (!cache.is_open())
-    throw std::runtime_error("Unable to open network cache file");
-
-  std::stringstream gieModelStream;
-
-  gieModelStream.seekg(0, gieModelStream.beg);
-  gieModelStream << cache.rdbuf();
-  cache.close();
-
-  nvinfer1::IRuntime *infer = nvinfer1::createInferRuntime(logger);
-
-  gieModelStream.seekg(0, std::ios::end);
-  const int modelSize = gieModelStream.tellg();
-  gieModelStream.seekg(0, std::ios::beg);
-
-  void *modelMem = malloc(modelSize);
-  if (!modelMem)
-    throw std::bad_alloc();
-
-  gieModelStream.read((char *)modelMem, modelSize);
-  engine = infer->deserializeCudaEngine(modelMem, modelSize, NULL);
-
-  free(modelMem);
-
-  if (!engine)
-    throw std::invalid_argument(
-        "Unable to create engine from deserialized data");
-
-  // Populate things that need to be populated before allocating memory
-  this->numBindings = engine->getNbBindings();
-  this->maxBatchSize = maxBatchSize;
+  if (profiler) {
+    std::string layers = profiler->report();
+    if (!layers.empty())
+      summary << "--Layers--" << std::endl << layers;
+  }
 
-  context = engine->createExecutionContext();
+  return summary.str();
 }
 
 void Logger::log(nvinfer1::ILogger::Severity severity, const char *msg) {
@@ -401,31 +761,4 @@ void Logger::log(nvinfer1::ILogger::Severity severity, const char *msg) {
   std::cerr << msg << std::endl;
 }
 
-NetworkIO::NetworkIO(std::string name, nvinfer1::Dims dims, size_t eleSize) {
-  this->name = name;
-  this->dims = dims;
-  this->eleSize = eleSize;
-}
-
-NetworkIO::~NetworkIO() {}
-
-size_t NetworkIO::size() {
-  int64_t volume = 1;
-  for (int64_t i = 0; i < dims.nbDims; i++)
-    volume *= dims.d[i];
-
-  return (size_t)volume * eleSize;
-}
-
-NetworkInput::NetworkInput(std::string name, nvinfer1::Dims dims,
-                           size_t eleSize)
-    : NetworkIO(name, dims, eleSize) {}
-
-NetworkInput::~NetworkInput() {}
-
-NetworkOutput::NetworkOutput(std::string name, nvinfer1::Dims dims,
-                             size_t eleSize)
-    : NetworkIO(name, dims, eleSize) {}
-
-NetworkOutput::~NetworkOutput() {}
 } // namespace jetson_tensorrt
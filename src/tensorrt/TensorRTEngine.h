@@ -28,86 +28,30 @@
 #ifndef RTENGINE_H_
 #define RTENGINE_H_
 
-#include <cuda_runtime_api.h>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
-#include "NvInfer.h"
-#include "NvUtils.h"
-
+#include "BackendTypes.h"
 #include "CUDACommon.h"
+#include "ExecutionBackend.h"
+#include "ExecutionContextPool.h"
+#include "LayerProfiler.h"
+#include "MemoryArena.h"
+#include "NetworkIO.h"
+#include "SharedWorkspace.h"
 
 namespace jetson_tensorrt {
 
-/**
- * @brief Abstract class representing a node in a neural network which takes
- * input or generates output
- */
-class NetworkIO {
-public:
-  /**
-   * @brief	Creates a new NetworkIO object
-   * @param	name	Name of the network layer
-   * @param	dims	Dimensions of the network layer
-   * @param	eleSize	Size of each individual dimension element
-   */
-  NetworkIO(std::string name, nvinfer1::Dims dims, size_t eleSize);
-
-  /**
-   * @brief	NetworkIO destructor
-   */
-  virtual ~NetworkIO();
-
-  /**
-   * @brief	Returns the size in bytes of the network layer
-   * @returns	Size sum in bytes of every element
-   */
-  size_t size();
-
-  std::string name;
-  nvinfer1::Dims dims;
-  size_t eleSize;
-};
-
-/**
- * @brief Represents an input node in a neural network which accepts a certain
- * dimension and size
- */
-class NetworkInput : public NetworkIO {
-public:
-  /**
-   * @brief	Creates a new NetworkInput object
-   * @param	name	Name of the network input layer
-   * @param	dims	Dimensions of the network input layer
-   * @param	eleSize	Size of each individual dimension element
-   */
-  NetworkInput(std::string name, nvinfer1::Dims dims, size_t eleSize);
-
-  /**
-   * @brief	NetworkInput destructor
-   */
-  virtual ~NetworkInput();
-};
-
-/**
- * @brief Represents an output node in a neural network which outputs a certain
- * dimension and size
- */
-class NetworkOutput : public NetworkIO {
-public:
-  /**
-   * @brief	Creates a new NetworkOutput object
-   * @param	name	Name of the network output layer
-   * @param	dims	Dimensions of the network output layer
-   * @param	eleSize	Size of each individual dimension element
-   */
-  NetworkOutput(std::string name, nvinfer1::Dims dims, size_t eleSize);
-
-  /**
-   * @brief	NetworkOutput destructor
-   */
-  virtual ~NetworkOutput();
-};
+struct BindingTransfer;
+class EngineBundle;
+class RegisteredBindings;
 
 /**
  * @brief Logger for GIE info/warning/errors
@@ -120,16 +64,21 @@ public:
 /**
  * @brief Represents all of a batches inputs or outputs located either in host,
  * device, or mapped memory
+ *
+ * Memory allocated by the engine is owned through a single MemoryArena and is
+ * freed with the structure, which is why it can only be moved. Structures
+ * built from pointers are views of memory owned by the caller.
  */
 struct LocatedExecutionMemory {
 
-  LocatedExecutionMemory() {}
+  LocatedExecutionMemory() { location = MemoryLocation::NONE; }
 
   /**
    * @brief LocatedExecutionMemory constructor
    * @param location	The location of the batch inputs or outputs, either in
    * HOST, MAPPED, or DEVICE memory
-   * @param batch	Batch of inputs or outputs
+   * @param batch	Batch of inputs or outputs, which remain owned by the
+   * caller
    */
   LocatedExecutionMemory(MemoryLocation location,
                          std::vector<std::vector<void *>> batch) {
@@ -137,9 +86,18 @@ struct LocatedExecutionMemory {
     this->location = location;
   }
 
+  LocatedExecutionMemory(LocatedExecutionMemory &&other) = default;
+  LocatedExecutionMemory &operator=(LocatedExecutionMemory &&other) = default;
+
+  LocatedExecutionMemory(const LocatedExecutionMemory &) = delete;
+  LocatedExecutionMemory &operator=(const LocatedExecutionMemory &) = delete;
+
   MemoryLocation location;
   std::vector<std::vector<void *>> batch;
 
+  /* Owns the memory of the batch, NULL for views */
+  std::unique_ptr<MemoryArena> arena;
+
   std::vector<void *> &operator[](const int index) { return batch[index]; }
 
   /**
@@ -149,36 +107,62 @@ struct LocatedExecutionMemory {
   size_t size() { return batch.size(); }
 
   /**
-   * @brief Frees the allocated memory
+   * @brief Creates a view of the same memory which does not own it
+   * @return	The view, which must not outlive this structure
    */
-  void release() {
+  LocatedExecutionMemory view() {
+    return LocatedExecutionMemory(location, batch);
+  }
 
-    for (int b = 0; b < batch.size(); b++) {
-      for (int c = 0; c < batch[b].size(); c++) {
+  /**
+   * @brief Creates a view of the first records of the same memory
+   * @param records	Number of records in the view
+   * @return	The view, which must not outlive this structure
+   */
+  LocatedExecutionMemory view(size_t records) {
+    if (records > batch.size())
+      throw std::invalid_argument("View is larger than the batch");
 
-        if (location == MemoryLocation::HOST) {
+    return LocatedExecutionMemory(
+        location, std::vector<std::vector<void *>>(batch.begin(),
+                                                   batch.begin() + records));
+  }
 
-          free(batch[b][c]);
+  /**
+   * @brief Frees the allocated memory before the structure is destroyed
+   */
+  void release() {
+    arena.reset();
+    batch.clear();
+  }
+};
 
-        } else if (location == MemoryLocation::DEVICE) {
+/**
+ * @brief Builds or loads the network of an engine for a maximum batch size
+ * @param	maxBatchSize	Largest batch the network has to run
+ * @return	The loaded backend, owned by the caller
+ */
+typedef std::function<ExecutionBackend *(size_t maxBatchSize)> BackendFactory;
 
-          cudaError_t deviceFreeError = cudaFree(batch[b][c]);
-          if (deviceFreeError != 0) {
-            throw std::runtime_error(
-                "Error freeing device memory. CUDA Error: " +
-                std::to_string(deviceFreeError));
-          }
+/**
+ * @brief The network built for one batch size of an engine family together
+ * with the contexts executing it
+ */
+struct BatchEngine {
+  enum State { UNBUILT, QUEUED, READY, FAILED };
 
-        } else if (location == location == MemoryLocation::MAPPED) {
-          cudaError_t hostFreeError = cudaFreeHost(batch[b][c]);
-          if (hostFreeError != 0) {
-            throw std::runtime_error("Error freeing host memory. CUDA Error: " +
-                                     std::to_string(hostFreeError));
-          }
-        }
-      }
-    }
+  BatchEngine(size_t maxBatchSize) {
+    this->maxBatchSize = maxBatchSize;
+    backend = NULL;
+    state = UNBUILT;
   }
+
+  size_t maxBatchSize;
+  State state;
+
+  /* NULL until the network is READY */
+  ExecutionBackend *backend;
+  ExecutionContextPool contextPool;
 };
 
 /**
@@ -199,13 +183,180 @@ public:
 
   /**
    * @brief	Does a forward pass of the neural network loaded in TensorRT
-   * @usage	Should be called after loading the graph and calling
-   * allocGPUBuffer()
+   * @usage	Should be called after loading the graph. Safe to call from
+   * several threads at once, each call runs on a context checked out of the
+   * context pool. DEVICE and UNIFIED outputs may be left unallocated, they are
+   * allocated by the first prediction and owned by outputs then.
    * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
-   * @param	outputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
    */
   void predict(LocatedExecutionMemory &inputs, LocatedExecutionMemory &outputs);
 
+  /**
+   * @brief	Does a forward pass of the neural network on a context which was
+   * checked out with acquireContext()
+   * @usage	Same requirements as predict() on the context pool
+   * @param	slot	The checked out context
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   */
+  void predict(ExecutionSlot *slot, LocatedExecutionMemory &inputs,
+               LocatedExecutionMemory &outputs);
+
+  /**
+   * @brief	Resolves the bindings of inputs and outputs which will be
+   * predicted on repeatedly
+   * @usage	Should be called after loading the graph. The memory must stay
+   * allocated and at the same address while the bindings are used.
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   * @return	The registered bindings, owned by the caller
+   */
+  RegisteredBindings *registerBindings(LocatedExecutionMemory &inputs,
+                                       LocatedExecutionMemory &outputs);
+
+  /**
+   * @brief	Does a forward pass of the neural network on registered bindings
+   * without allocating or resolving anything
+   * @param	registered	Bindings returned by registerBindings()
+   */
+  void predict(RegisteredBindings &registered);
+
+  /**
+   * @brief	Enqueues a forward pass of the neural network on registered
+   * bindings and invokes a callback once it completes
+   * @usage	Same requirements as predictAsync() on LocatedExecutionMemory
+   * @param	registered	Bindings returned by registerBindings()
+   * @param	stream	The CUDA stream to enqueue the copies and inference on
+   * @param	callback	Called with the stream status once the outputs are
+   * available
+   */
+  void predictAsync(RegisteredBindings &registered, cudaStream_t stream,
+                    std::function<void(cudaError_t)> callback);
+
+  /**
+   * @brief	Checks an execution context out of the context pool, blocking
+   * until one is free
+   * @param	batchSize	Size of the batches which will be predicted on it,
+   * which picks the network like predict() does. 0 for the network built for
+   * maxBatchSize.
+   * @return	The context, which must be returned with releaseContext()
+   */
+  ExecutionSlot *acquireContext(size_t batchSize = 0);
+
+  /**
+   * @brief	Returns an execution context to the context pool
+   * @param	slot	A context returned by acquireContext()
+   */
+  void releaseContext(ExecutionSlot *slot);
+
+  /**
+   * @brief	Sets how many execution contexts share the loaded network, which
+   * is how many predictions can run concurrently
+   * @usage	Can be called before or after loading. Must not be called while
+   * predictions are running.
+   * @param	size	Number of execution contexts
+   */
+  void setContextPoolSize(size_t size);
+
+  /**
+   * @brief	Executes in a workspace shared with other engines instead of
+   * device memory owned by every context
+   * @usage	Can be called before or after loading. Must not be called while
+   * predictions are running. Executions of every engine sharing the
+   * workspace take turns, including the contexts of this engine. Has no
+   * effect before TensorRT 5.
+   * @param	workspace	The workspace, NULL to go back to owned memory
+   */
+  void shareWorkspace(std::shared_ptr<SharedWorkspace> workspace);
+
+  /**
+   * @brief	Sets how networks for batch sizes other than maxBatchSize are
+   * built
+   * @usage	Engines loaded from an EngineCache set this themselves
+   * @param	factory	Builds or loads the network for a batch size
+   */
+  void setBackendFactory(BackendFactory factory);
+
+  /**
+   * @brief	Runs smaller batches on networks built for their size, which are
+   * faster than the network built for maxBatchSize
+   * @usage	Should be called after loading. Must not be called while
+   * predictions are running. Each network is built by the backend factory in
+   * the background the first time a batch would run on it, until then the
+   * batch runs on the next larger network that is built. Loading the engine
+   * again drops every batch size.
+   * @param	batchSizes	Batch sizes to build networks for, none of which may
+   * be larger than maxBatchSize
+   */
+  void setBatchSizes(std::vector<size_t> batchSizes);
+
+  /**
+   * @brief	Builds the network of every batch size which is not built yet
+   * instead of waiting for batches of its size
+   * @usage	Blocks until every build finished
+   */
+  void buildBatchSizes();
+
+  /**
+   * @brief	Gets the batch sizes which currently have a network to run on
+   * @return	Built batch sizes in ascending order, including maxBatchSize
+   */
+  std::vector<size_t> getBuiltBatchSizes();
+
+  /**
+   * @brief	Starts collecting per layer timings of every synchronous
+   * prediction
+   * @usage	Must not be called while predictions are running. Stays enabled
+   * when the network is reloaded.
+   * @param	window	Number of latest timings kept per layer
+   * @return	The profiler, owned by the engine
+   */
+  LayerProfiler *enableProfiling(size_t window = LayerProfiler::DEFAULT_WINDOW);
+
+  /**
+   * @brief	Stops collecting per layer timings and frees the profiler
+   * @usage	Must not be called while predictions are running
+   */
+  void disableProfiling();
+
+  /**
+   * @brief	Gets the profiler collecting per layer timings
+   * @return	The profiler, NULL if profiling is disabled
+   */
+  LayerProfiler *getProfiler();
+
+  /**
+   * @brief	Enqueues a forward pass of the neural network on a CUDA stream
+   * and returns immediately
+   * @usage	inputs and outputs must stay valid until the returned future is
+   * ready. HOST inputs and outputs should be page-locked for the copies to
+   * overlap with other work. Each call holds a context from the context pool
+   * until it completes. Unallocated outputs are allocated like by predict().
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   * @param	stream	The CUDA stream to enqueue the copies and inference on
+   * @return	A future which becomes ready once the outputs are available
+   */
+  std::future<void> predictAsync(LocatedExecutionMemory &inputs,
+                                 LocatedExecutionMemory &outputs,
+                                 cudaStream_t stream);
+
+  /**
+   * @brief	Enqueues a forward pass of the neural network on a CUDA stream
+   * and invokes a callback once it completes
+   * @usage	Same requirements as the future based predictAsync(). The
+   * callback runs on a CUDA driver thread and must not make CUDA calls.
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   * @param	stream	The CUDA stream to enqueue the copies and inference on
+   * @param	callback	Called with the stream status once the outputs are
+   * available
+   */
+  void predictAsync(LocatedExecutionMemory &inputs,
+                    LocatedExecutionMemory &outputs, cudaStream_t stream,
+                    std::function<void(cudaError_t)> callback);
+
   /**
    * @brief	Quick load the TensorRT optimized network
    * @usage	Should be called after addInput and addOutput without calling
@@ -217,6 +368,16 @@ public:
    */
   void loadCache(std::string cachePath, size_t maxBatchSize = 1);
 
+  /**
+   * @brief	Runs the network on a different execution backend
+   * @usage	Should be called after addInput and addOutput. A backend which
+   * still needs a network can be loaded afterwards with loadCache, which
+   * otherwise loads into a TensorRTBackend.
+   * @param	backend	The backend, which is deleted with the engine
+   * @param	maxBatchSize	The max batch size of the network
+   */
+  void attachBackend(ExecutionBackend *backend, size_t maxBatchSize = 1);
+
   /**
    * @brief	Save the TensorRT optimized network for quick loading in the
    * future
@@ -226,7 +387,26 @@ public:
   void saveCache(std::string cachePath);
 
   /**
-   * @brief	Returns a summary of the loaded network, inputs, and outputs
+   * @brief	Saves the TensorRT optimized network together with its inputs,
+   * outputs, data type and max batch size
+   * @usage	Should be called after loadModel()
+   * @param	bundlePath	Path to the bundle file
+   * @param	description	Class labels and preprocessing params saved with
+   * the network. Its network description is overwritten.
+   */
+  void saveBundle(std::string bundlePath, EngineBundle &description);
+
+  /**
+   * @brief	Quick load a network saved with saveBundle()
+   * @usage	Registers the inputs and outputs of the bundle, so it is called
+   * instead of addInput, addOutput and loadModel
+   * @param	bundle	The opened bundle
+   */
+  void loadBundle(EngineBundle &bundle);
+
+  /**
+   * @brief	Returns a summary of the loaded network, inputs, and outputs, and
+   * the cost of each layer if profiling is enabled
    * @return	String containing the summary
    */
   std::string engineSummary();
@@ -255,20 +435,24 @@ public:
     @param location Whether the memory should be allocated on the HOST, DEVICE,
     or MAPPED
     @param skipMalloc Create the input structure but do not allocate memory
+    @param hugePages Back HOST memory with huge pages
     @return The allocated or mapped inputs
   */
   LocatedExecutionMemory allocInputs(MemoryLocation location,
-                                     bool skipMalloc = false);
+                                     bool skipMalloc = false,
+                                     bool hugePages = false);
 
   /**
     @brief Allocates a located execution memory structure for outputs
     @param location Whether the memory should be allocated on the HOST, DEVICE,
     or MAPPED
     @param skipMalloc Create the input structure but do not allocate memory
+    @param hugePages Back HOST memory with huge pages
     @return The allocated or mapped outputs
    */
   LocatedExecutionMemory allocOutputs(MemoryLocation location,
-                                      bool skipMalloc = false);
+                                      bool skipMalloc = false,
+                                      bool hugePages = false);
 
   int maxBatchSize;
   int numBindings;
@@ -279,27 +463,150 @@ public:
   std::vector<NetworkOutput> networkOutputs;
 
 protected:
-  nvinfer1::ICudaEngine *engine;
-  nvinfer1::IExecutionContext *context;
+  ExecutionBackend *backend;
+  ExecutionContextPool contextPool;
   Logger logger;
 
+  /**
+   * @brief	Stops building and frees the network of every batch size
+   * @usage	Waits for a running build to finish. Engines whose backend
+   * factory uses their own members call it first thing in their destructor.
+   */
+  void clearFamily();
+
 private:
-  std::vector<void *> preAllocatedGPUBuffers;
+  size_t contextPoolSize;
+  LayerProfiler *profiler;
+  std::shared_ptr<SharedWorkspace> workspace;
+
+  /* Networks for batch sizes below maxBatchSize, ascending */
+  BackendFactory backendFactory;
+  std::vector<BatchEngine *> family;
+  std::mutex familyMutex;
+  std::condition_variable familyChanged;
+  std::thread familyBuilder;
+  bool stoppingBuilds;
+
+  /**
+   * @brief	Loads a serialized network into the attached backend, or a new
+   * TensorRTBackend if there is none, and attaches it
+   * @param	blob	The serialized network
+   * @param	size	Size of the network in bytes
+   * @param	maxBatchSize	The max batch size of the network
+   */
+  void loadSerialized(const void *blob, size_t size, size_t maxBatchSize);
+
+  /**
+   * @brief	Creates every context pool from its backend and the current
+   * settings
+   */
+  void createContexts();
+
+  /**
+   * @brief	Creates one context pool from the current settings
+   * @param	pool	The pool to create
+   * @param	backend	The network of the pool
+   * @param	maxBatchSize	Largest batch the network runs
+   */
+  void createPool(ExecutionContextPool &pool, ExecutionBackend *backend,
+                  size_t maxBatchSize);
+
+  /**
+   * @brief	Picks the smallest built network a batch fits in, queueing the
+   * build of a better fitting one
+   * @param	batchSize	Number of records in the batch
+   * @return	The context pool of the network
+   */
+  ExecutionContextPool &selectPool(size_t batchSize);
 
   /**
-   * @brief	Allocates the buffers required to copy batches to and from the
-   * GPU
-   * @usage	Should be called before the first prediction from host memory if
-   * not using mapped memory
+   * @brief	Gets the context pool a slot was checked out of
+   * @param	slot	The checked out slot
+   * @return	The context pool
    */
-  void allocGPUBuffer();
+  ExecutionContextPool &slotPool(ExecutionSlot *slot);
 
   /**
-   * @brief	Frees buffers required to copy batches to the GPU
+   * @brief	Builds queued batch sizes until the family is cleared
    */
-  void freeGPUBuffer();
+  void buildFamily();
+
 
-  bool gpuBufferPreAllocated;
+  /**
+   * @brief	Gets the staging binding of a context, allocating it on first use
+   * @param	slot	The context
+   * @param	bindingIdx	Index of the binding
+   * @param	recordSize	Size of one record of the binding in bytes
+   * @return	Binding which holds maxBatchSize records
+   */
+  void *slotBinding(ExecutionSlot &slot, int bindingIdx, size_t recordSize);
+
+  /**
+   * @brief	Allocates one arena holding maxBatchSize records of every tensor
+   * @param	sizes	Size in bytes of one record of each tensor
+   * @param	location	Where the arena is allocated
+   * @param	skipMalloc	Only create the structure
+   * @param	hugePages	Back HOST memory with huge pages
+   * @return	Memory indexed by [batchIndex][tensorIndex]
+   */
+  LocatedExecutionMemory allocTensors(std::vector<size_t> sizes,
+                                      MemoryLocation location, bool skipMalloc,
+                                      bool hugePages);
+
+  /**
+   * @brief	Allocates the outputs of which no record of the batch is
+   * allocated in one arena owned by the outputs
+   * @usage	Only DEVICE and UNIFIED outputs can be left unallocated
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   * @param	batchCount	Number of records in the batch
+   */
+  void allocMissingOutputs(LocatedExecutionMemory &outputs, int batchCount);
+
+  /**
+   * @brief	Resolves the device pointer of every binding for a transaction
+   * @param	slot	The context the transaction runs on
+   * @param	inputs Graph inputs indexed by [batchIndex][inputIndex]
+   * @param	outputs Graph outputs indexed by [batchIndex][outputIndex]
+   * @param	uploads	Receives the copies into the bindings
+   * @param	downloads	Receives the copies out of the bindings
+   * @return	One device pointer per binding, each holding the whole batch
+   */
+  std::vector<void *> bindTransaction(ExecutionSlot &slot,
+                                      LocatedExecutionMemory &inputs,
+                                      LocatedExecutionMemory &outputs,
+                                      std::vector<BindingTransfer> &uploads,
+                                      std::vector<BindingTransfer> &downloads);
+
+  /**
+   * @brief	Copies caller memory into bindings
+   * @param	backend	The backend of the bindings
+   * @param	stream	Stream to copy on when async is set
+   * @param	async	Whether to enqueue the copies instead of blocking
+   */
+  void uploadBindings(ExecutionBackend *backend,
+                      std::vector<BindingTransfer> &uploads,
+                      cudaStream_t stream, bool async);
+
+  /**
+   * @brief	Copies bindings back into caller memory
+   * @param	backend	The backend of the bindings
+   * @param	stream	Stream to copy on when async is set
+   * @param	async	Whether to enqueue the copies instead of blocking
+   */
+  void downloadBindings(ExecutionBackend *backend,
+                        std::vector<BindingTransfer> &downloads,
+                        cudaStream_t stream, bool async);
+
+  /**
+   * @brief	Enqueues the inference of a context, holding the shared workspace
+   * until the stream has finished it
+   * @param	slot	The context
+   * @param	batchSize	Number of records in the batch
+   * @param	bindings	One device pointer per binding
+   * @param	stream	The stream to enqueue on
+   */
+  void enqueueInference(ExecutionSlot *slot, int batchSize, void **bindings,
+                        cudaStream_t stream);
 };
 
 } // namespace jetson_tensorrt
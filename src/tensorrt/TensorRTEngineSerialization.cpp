@@ -0,0 +1,91 @@
+/**
+ * @file	TensorRTEngineSerialization.cpp
+ * @author	Carroll Vance
+ * @brief	Saving and loading serialized TensorRTEngine networks
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string>
+
+#include "AtomicFile.h"
+#include "EngineBundle.h"
+#include "MappedFile.h"
+#include "TensorRTBackend.h"
+#include "TensorRTEngine.h"
+
+// Kept out of TensorRTEngine.cpp, which builds without TensorRT libraries
+
+namespace jetson_tensorrt {
+
+void TensorRTEngine::saveCache(std::string cachePath) {
+  // Nodes loading the cache while it is written see the previous file
+  AtomicFile cache(cachePath);
+  backend->serialize(cache.stream());
+  cache.commit();
+}
+
+void TensorRTEngine::loadCache(std::string cachePath, size_t maxBatchSize) {
+
+  // Deserialize straight from the page cache instead of copying the file
+  // into the heap
+  MappedFile cache(cachePath);
+  loadSerialized(cache.data(), cache.size(), maxBatchSize);
+}
+
+void TensorRTEngine::saveBundle(std::string bundlePath,
+                                EngineBundle &description) {
+  description.inputs = networkInputs;
+  description.outputs = networkOutputs;
+  description.dataType = dataType;
+  description.maxBatchSize = maxBatchSize;
+
+  description.save(bundlePath, backend);
+}
+
+void TensorRTEngine::loadBundle(EngineBundle &bundle) {
+  networkInputs = bundle.inputs;
+  networkOutputs = bundle.outputs;
+  dataType = bundle.dataType;
+
+  loadSerialized(bundle.engineData(), bundle.engineSize(),
+                 bundle.maxBatchSize);
+}
+
+void TensorRTEngine::loadSerialized(const void *blob, size_t size,
+                                    size_t maxBatchSize) {
+  // Load into the attached backend, or TensorRT if there is none
+  ExecutionBackend *serializedBackend = backend;
+  if (!serializedBackend)
+    serializedBackend = new TensorRTBackend(logger);
+
+  try {
+    serializedBackend->load(blob, size);
+  } catch (...) {
+    if (serializedBackend != backend)
+      delete serializedBackend;
+    throw;
+  }
+
+  attachBackend(serializedBackend, maxBatchSize);
+}
+
+} // namespace jetson_tensorrt
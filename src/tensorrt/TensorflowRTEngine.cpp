@@ -33,6 +33,7 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <sys/stat.h>
 #include <unordered_map>
@@ -42,6 +43,7 @@
 #include "NvUffParser.h"
 #include "NvUtils.h"
 
+#include "TensorRTBackend.h"
 #include "TensorflowRTEngine.h"
 
 using namespace nvuffparser;
@@ -86,46 +88,45 @@ void TensorflowRTEngine::addOutput(std::string layer, nvinfer1::Dims dims,
 
 void TensorflowRTEngine::loadModel(std::string uffFile, size_t maxBatchSize,
                                    nvinfer1::DataType dataType,
-                                   size_t maxNetworkSize) {
+                                   size_t maxNetworkSize,
+                                   nvinfer1::IInt8Calibrator *calibrator) {
 
   assert(networkInputs.size() > 0 && networkOutputs.size() > 0);
 
+  if (dataType == DataType::kINT8 && !calibrator)
+    throw std::invalid_argument("INT8 networks need a calibrator");
+
   this->dataType = dataType;
   this->maxBatchSize = maxBatchSize;
 
-  IBuilder *builder = createInferBuilder(logger);
-
-  INetworkDefinition *network = builder->createNetwork();
+  // Both are released when building throws
+  TensorRTPtr<IBuilder> builder(createInferBuilder(logger));
+  TensorRTPtr<INetworkDefinition> network(builder->createNetwork());
 
   if (dataType == DataType::kFLOAT) {
     if (!parser->parse(uffFile.c_str(), *network, nvinfer1::DataType::kFLOAT))
       throw std::runtime_error("Failed to parse .uff file");
   } else if (dataType == DataType::kHALF) {
-    if (!parser->parse(uffFile.c_str(), *network, nvinfer1::DataType::kINT8))
+    if (!parser->parse(uffFile.c_str(), *network, nvinfer1::DataType::kHALF))
       throw std::runtime_error("Failed to parse .uff file");
     builder->setHalf2Mode(true);
   } else if (dataType == DataType::kINT8) {
-    if (!parser->parse(uffFile.c_str(), *network, nvinfer1::DataType::kINT8))
+    // INT8 networks are built from float weights and calibrated
+    if (!parser->parse(uffFile.c_str(), *network, nvinfer1::DataType::kFLOAT))
       throw std::runtime_error("Failed to parse .uff file");
     builder->setInt8Mode(true);
+    builder->setInt8Calibrator(calibrator);
   }
 
   builder->setMaxBatchSize(maxBatchSize);
 
   builder->setMaxWorkspaceSize(maxNetworkSize);
 
-  engine = builder->buildCudaEngine(*network);
+  ICudaEngine *engine = builder->buildCudaEngine(*network);
   if (!engine)
     throw std::runtime_error("Failed to create TensorRT engine");
 
-  /* Reclaim memory */
-  network->destroy();
-  builder->destroy();
-  parser->destroy();
-
-  context = engine->createExecutionContext();
-
-  numBindings = engine->getNbBindings();
+  attachBackend(new TensorRTBackend(logger, engine), maxBatchSize);
 }
 
 } // namespace jetson_tensorrt
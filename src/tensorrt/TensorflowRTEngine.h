@@ -63,10 +63,12 @@ public:
    * TensorRT
    * @param	maxNetworkSize	Maximum amount of GPU RAM the Tensorflow graph is
    * allowed to use
+   * @param	calibrator	Provides calibration data for kINT8 networks
    */
   void loadModel(std::string uffFile, size_t maxBatchSize = 1,
                  nvinfer1::DataType dataType = nvinfer1::DataType::kFLOAT,
-                 size_t maxNetworkSize = (1 << 30));
+                 size_t maxNetworkSize = (1 << 30),
+                 nvinfer1::IInt8Calibrator *calibrator = NULL);
 
   /**
    * @brief	Registers an input to the Tensorflow network. Assumes inputs have
@@ -0,0 +1,212 @@
+/**
+ * @file	TuningReport.cpp
+ * @author	Carroll Vance
+ * @brief	Writes the results of an Autotuner sweep
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "TuningReport.h"
+
+namespace jetson_tensorrt {
+
+static const size_t MEGABYTE = 1 << 20;
+
+/**
+ * @brief Quotes a string for JSON
+ */
+static std::string jsonString(std::string value) {
+  std::string quoted = "\"";
+
+  for (int c = 0; c < value.size(); c++) {
+    unsigned char character = value[c];
+
+    if (character == '"' || character == '\\') {
+      quoted += '\\';
+      quoted += character;
+    } else if (character < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+      quoted += escaped;
+    } else {
+      quoted += character;
+    }
+  }
+
+  return quoted + "\"";
+}
+
+/**
+ * @brief Quotes a string for CSV
+ */
+static std::string csvString(std::string value) {
+  std::string quoted = "\"";
+
+  for (int c = 0; c < value.size(); c++) {
+    if (value[c] == '"')
+      quoted += '"';
+    quoted += value[c] == '\n' ? ' ' : value[c];
+  }
+
+  return quoted + "\"";
+}
+
+TuningReport::TuningReport(std::vector<TuningResult> results,
+                           double latencyBudgetMs) {
+  this->results = results;
+  this->latencyBudgetMs = latencyBudgetMs;
+
+  best = -1;
+  bestWithinBudget = false;
+
+  for (int r = 0; r < results.size(); r++) {
+    TuningResult &result = results[r];
+    if (!result.succeeded)
+      continue;
+
+    bool within = latencyBudgetMs <= 0 || result.p99Ms <= latencyBudgetMs;
+
+    bool better;
+    if (best < 0 || within != bestWithinBudget)
+      better = best < 0 || within;
+    else if (within)
+      // Throughput decides, latency breaks ties
+      better = result.recordsPerSecond > results[best].recordsPerSecond ||
+               (result.recordsPerSecond == results[best].recordsPerSecond &&
+                result.p99Ms < results[best].p99Ms);
+    else
+      better = result.p99Ms < results[best].p99Ms;
+
+    if (better) {
+      best = r;
+      bestWithinBudget = within;
+    }
+  }
+}
+
+int TuningReport::recommended() { return best; }
+
+bool TuningReport::withinBudget() { return bestWithinBudget; }
+
+int TuningReport::dataTypeBits(nvinfer1::DataType dataType) {
+  switch (dataType) {
+  case nvinfer1::DataType::kFLOAT:
+    return 32;
+  case nvinfer1::DataType::kHALF:
+    return 16;
+  case nvinfer1::DataType::kINT8:
+    return 8;
+  default:
+    throw std::invalid_argument("Unsupported data type");
+  }
+}
+
+void TuningReport::writeCSV(std::ostream &out) {
+  out << "data_type,max_network_size,batch_size,succeeded,build_s,mean_ms,"
+         "p50_ms,p90_ms,p99_ms,max_ms,records_per_s,recommended,error"
+      << std::endl;
+
+  out << std::fixed << std::setprecision(3);
+
+  for (int r = 0; r < results.size(); r++) {
+    TuningResult &result = results[r];
+
+    out << dataTypeBits(result.config.dataType) << ","
+        << result.config.maxNetworkSize << "," << result.config.batchSize
+        << "," << (result.succeeded ? 1 : 0) << "," << result.buildSeconds
+        << "," << result.meanMs << "," << result.p50Ms << "," << result.p90Ms
+        << "," << result.p99Ms << "," << result.maxMs << ","
+        << result.recordsPerSecond << "," << (r == best ? 1 : 0) << ","
+        << csvString(result.error) << std::endl;
+  }
+}
+
+void TuningReport::writeJSON(std::ostream &out) {
+  out << std::fixed << std::setprecision(3);
+
+  out << "{" << std::endl;
+  out << "  \"latency_budget_ms\": " << latencyBudgetMs << "," << std::endl;
+  out << "  \"recommended\": " << best << "," << std::endl;
+  out << "  \"within_budget\": " << (bestWithinBudget ? "true" : "false")
+      << "," << std::endl;
+  out << "  \"results\": [";
+
+  for (int r = 0; r < results.size(); r++) {
+    TuningResult &result = results[r];
+
+    out << (r > 0 ? "," : "") << std::endl;
+    out << "    {\"data_type\": " << dataTypeBits(result.config.dataType)
+        << ", \"max_network_size\": " << result.config.maxNetworkSize
+        << ", \"batch_size\": " << result.config.batchSize
+        << ", \"succeeded\": " << (result.succeeded ? "true" : "false")
+        << ", \"build_s\": " << result.buildSeconds
+        << ", \"mean_ms\": " << result.meanMs
+        << ", \"p50_ms\": " << result.p50Ms << ", \"p90_ms\": " << result.p90Ms
+        << ", \"p99_ms\": " << result.p99Ms << ", \"max_ms\": " << result.maxMs
+        << ", \"records_per_s\": " << result.recordsPerSecond
+        << ", \"error\": " << jsonString(result.error) << "}";
+  }
+
+  out << std::endl << "  ]" << std::endl << "}" << std::endl;
+}
+
+void TuningReport::writeRecommendation(std::ostream &out) {
+  if (best < 0) {
+    out << "# No configuration could be built" << std::endl;
+    return;
+  }
+
+  TuningResult &result = results[best];
+
+  out << std::fixed << std::setprecision(3);
+  out << "# Recommended by autotune: " << result.recordsPerSecond
+      << " records/s, p99 " << result.p99Ms << " ms per batch";
+  if (latencyBudgetMs > 0)
+    out << (bestWithinBudget ? " within" : ", over") << " the budget of "
+        << latencyBudgetMs << " ms";
+  out << std::endl;
+
+  out << "data_type: " << dataTypeBits(result.config.dataType) << std::endl;
+  out << "max_network_size_mb: "
+      << (result.config.maxNetworkSize + MEGABYTE - 1) / MEGABYTE << std::endl;
+  out << "max_batch_size: " << result.config.batchSize << std::endl;
+}
+
+void TuningReport::save(std::string prefix) {
+  std::ofstream csv((prefix + ".csv").c_str());
+  writeCSV(csv);
+
+  std::ofstream json((prefix + ".json").c_str());
+  writeJSON(json);
+
+  std::ofstream yaml((prefix + ".yaml").c_str());
+  writeRecommendation(yaml);
+
+  if (!csv.good() || !json.good() || !yaml.good())
+    throw std::runtime_error("Unable to write the tuning report " + prefix);
+}
+
+} // namespace jetson_tensorrt
@@ -0,0 +1,112 @@
+/**
+ * @file	TuningReport.h
+ * @author	Carroll Vance
+ * @brief	Writes the results of an Autotuner sweep
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TUNINGREPORT_H_
+#define TUNINGREPORT_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Autotuner.h"
+
+namespace jetson_tensorrt {
+
+/**
+ * @brief Results of an Autotuner sweep together with the configuration
+ * recommended from them
+ *
+ * The recommendation has the highest throughput of every configuration
+ * whose p99 latency is within the budget. When none is, the one with the
+ * lowest p99 latency is recommended instead.
+ */
+class TuningReport {
+public:
+  /**
+   * @brief	Creates a report and picks the recommended configuration
+   * @param	results	Results of the sweep
+   * @param	latencyBudgetMs	Largest acceptable p99 latency of a batch, 0
+   * for no limit
+   */
+  TuningReport(std::vector<TuningResult> results, double latencyBudgetMs = 0);
+
+  /**
+   * @brief	Gets the recommended result
+   * @return	Index into results, -1 if no configuration succeeded
+   */
+  int recommended();
+
+  /**
+   * @brief	Gets whether the recommendation meets the latency budget
+   * @return	False if no configuration met it
+   */
+  bool withinBudget();
+
+  /**
+   * @brief	Writes one line per result with a header line
+   * @param	out	Stream the CSV is written to
+   */
+  void writeCSV(std::ostream &out);
+
+  /**
+   * @brief	Writes every result, the budget and the recommended index
+   * @param	out	Stream the JSON is written to
+   */
+  void writeJSON(std::ostream &out);
+
+  /**
+   * @brief	Writes the recommended configuration as ROS parameters
+   * @usage	The file can be loaded into the private namespace of the
+   * digits_detect and digits_classify nodes with rosparam
+   * @param	out	Stream the YAML is written to
+   */
+  void writeRecommendation(std::ostream &out);
+
+  /**
+   * @brief	Writes the CSV, JSON and recommendation files
+   * @param	prefix	Path the .csv, .json and .yaml extensions are appended
+   * to
+   */
+  void save(std::string prefix);
+
+  /**
+   * @brief	Gets the value of the data_type parameter of the nodes
+   * @param	dataType	The precision
+   * @return	Bits per element, 32, 16 or 8
+   */
+  static int dataTypeBits(nvinfer1::DataType dataType);
+
+  std::vector<TuningResult> results;
+  double latencyBudgetMs;
+
+private:
+  int best;
+  bool bestWithinBudget;
+};
+
+} // namespace jetson_tensorrt
+
+#endif /* TUNINGREPORT_H_ */
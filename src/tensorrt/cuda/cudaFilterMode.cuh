@@ -0,0 +1,120 @@
+/**
+ * @file	cudaFilterMode.cuh
+ * @author	Carroll Vance
+ * @brief	Device side sampling of resized images
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CUDA_FILTER_MODE_CUH__
+#define __CUDA_FILTER_MODE_CUH__
+
+
+#include "cudaFilterMode.h"
+#include "cudaUtility.h"
+
+
+// float4 helpers, accumulating in the order the CPU references do
+inline __device__ float4 filterScale( const float4& a, float b )
+{
+	return make_float4(a.x * b, a.y * b, a.z * b, a.w * b);
+}
+
+inline __device__ float4 filterAdd( const float4& a, const float4& b )
+{
+	return make_float4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+
+inline __device__ float4 filterLerp( const float4& a, const float4& b, float t )
+{
+	return filterAdd(a, filterScale(make_float4(b.x - a.x, b.y - a.y, b.z - a.z, b.w - a.w), t));
+}
+
+
+/**
+ * Sample output pixel (x,y) of an image resized by scale (input size divided
+ * by output size). fetch(x,y) returns input pixel (x,y) as a float4, so one
+ * sampler serves every input format. FILTER_POINT samples exactly the pixel
+ * the original nearest neighbour kernels did.
+ * @ingroup util
+ */
+template <typename Fetch>
+inline __device__ float4 cudaFilterPixel( cudaFilterMode filter, const Fetch& fetch, float2 scale,
+                                          int iWidth, int iHeight, int x, int y )
+{
+	if( filter == FILTER_LINEAR )
+	{
+		// input coordinates of the output pixel's center, clamped to the border
+		const float sx = fminf(fmaxf((x + 0.5f) * scale.x - 0.5f, 0.0f), float(iWidth - 1));
+		const float sy = fminf(fmaxf((y + 0.5f) * scale.y - 0.5f, 0.0f), float(iHeight - 1));
+
+		const int x0 = sx;
+		const int y0 = sy;
+		const int x1 = min(x0 + 1, iWidth - 1);
+		const int y1 = min(y0 + 1, iHeight - 1);
+
+		const float fx = sx - x0;
+		const float fy = sy - y0;
+
+		const float4 top    = filterLerp(fetch(x0, y0), fetch(x1, y0), fx);
+		const float4 bottom = filterLerp(fetch(x0, y1), fetch(x1, y1), fx);
+
+		return filterLerp(top, bottom, fy);
+	}
+	else if( filter == FILTER_AREA )
+	{
+		// the output pixel covers [x0,x1) x [y0,y1) of the input
+		const float x0 = (float)x * scale.x;
+		const float y0 = (float)y * scale.y;
+		const float x1 = fminf(x0 + scale.x, float(iWidth));
+		const float y1 = fminf(y0 + scale.y, float(iHeight));
+
+		const int ix1 = min((int)ceilf(x1), iWidth);
+		const int iy1 = min((int)ceilf(y1), iHeight);
+
+		float4 sum = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+		float area = 0.0f;
+
+		for( int iy = (int)y0; iy < iy1; iy++ )
+		{
+			const float wy = fminf(iy + 1.0f, y1) - fmaxf((float)iy, y0);
+
+			for( int ix = (int)x0; ix < ix1; ix++ )
+			{
+				const float w = (fminf(ix + 1.0f, x1) - fmaxf((float)ix, x0)) * wy;
+
+				sum   = filterAdd(sum, filterScale(fetch(ix, iy), w));
+				area += w;
+			}
+		}
+
+		return filterScale(sum, 1.0f / area);
+	}
+
+	// FILTER_POINT
+	const int dx = ((float)x * scale.x);
+	const int dy = ((float)y * scale.y);
+
+	return fetch(dx, dy);
+}
+
+
+#endif
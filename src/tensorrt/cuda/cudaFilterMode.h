@@ -0,0 +1,86 @@
+/**
+ * @file	cudaFilterMode.h
+ * @author	Carroll Vance
+ * @brief	Sampling filters used when resizing images
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CUDA_FILTER_MODE_H__
+#define __CUDA_FILTER_MODE_H__
+
+
+#include <string.h>
+
+
+/**
+ * How the pixels of a resized image are sampled from the input image.
+ *   FILTER_POINT   nearest neighbour, the input pixel the output pixel starts in
+ *   FILTER_LINEAR  bilinear interpolation of the 4 input pixels around the
+ *                  output pixel's center
+ *   FILTER_AREA    average of the input pixels the output pixel covers,
+ *                  weighted by the covered area (box filter)
+ * @ingroup util
+ */
+enum cudaFilterMode
+{
+	FILTER_POINT = 0,
+	FILTER_LINEAR,
+	FILTER_AREA
+};
+
+
+/**
+ * Name of a filter mode, "point", "linear" or "area".
+ * @ingroup util
+ */
+inline const char* cudaFilterModeToStr( cudaFilterMode filter )
+{
+	if( filter == FILTER_LINEAR )
+		return "linear";
+	else if( filter == FILTER_AREA )
+		return "area";
+
+	return "point";
+}
+
+
+/**
+ * Parse the name of a filter mode, returning default_value if it is unknown.
+ * @ingroup util
+ */
+inline cudaFilterMode cudaFilterModeFromStr( const char* filter, cudaFilterMode default_value=FILTER_POINT )
+{
+	if( !filter )
+		return default_value;
+
+	if( strcmp(filter, "point") == 0 || strcmp(filter, "nearest") == 0 )
+		return FILTER_POINT;
+	else if( strcmp(filter, "linear") == 0 || strcmp(filter, "bilinear") == 0 )
+		return FILTER_LINEAR;
+	else if( strcmp(filter, "area") == 0 )
+		return FILTER_AREA;
+
+	return default_value;
+}
+
+
+#endif
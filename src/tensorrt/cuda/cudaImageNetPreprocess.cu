@@ -20,12 +20,41 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
-#include "cudaUtility.h"
+#include "cudaFilterMode.cuh"
+#include "cudaImageNetPreprocess.h"
+
+
+
+// fetches pixels of a packed RGBAf image
+struct RGBAfFetch
+{
+	const float4* image;
+	int width;
+
+	inline __device__ float4 operator()( int x, int y ) const
+	{
+		return image[y * width + x];
+	}
+};
+
+
+// fetches pixels of a packed 8-bit RGB image, converted to float
+struct RGB8Fetch
+{
+	const uchar3* image;
+	int width;
+
+	inline __device__ float4 operator()( int x, int y ) const
+	{
+		const uchar3 px = image[y * width + x];
+		return make_float4(px.x, px.y, px.z, 255.0f);
+	}
+};
 
 
 
 // gpuPreImageNet
-__global__ void gpuPreImageNet( float2 scale, float4* input, int iWidth, float* output, int oWidth, int oHeight )
+__global__ void gpuPreImageNet( float2 scale, float4* input, int iWidth, int iHeight, float* output, int oWidth, int oHeight, cudaFilterMode filter )
 {
 	const int x = blockIdx.x * blockDim.x + threadIdx.x;
 	const int y = blockIdx.y * blockDim.y + threadIdx.y;
@@ -34,10 +63,8 @@ __global__ void gpuPreImageNet( float2 scale, float4* input, int iWidth, float*
 	if( x >= oWidth || y >= oHeight )
 		return;
 
-	const int dx = ((float)x * scale.x);
-	const int dy = ((float)y * scale.y);
-
-	const float4 px  = input[ dy * iWidth + dx ];
+	const RGBAfFetch fetch = { input, iWidth };
+	const float4 px = cudaFilterPixel(filter, fetch, scale, iWidth, iHeight, x, y);
 	const float3 bgr = make_float3(px.z, px.y, px.x);
 
 	output[n * 0 + y * oWidth + x] = bgr.x;
@@ -48,7 +75,7 @@ __global__ void gpuPreImageNet( float2 scale, float4* input, int iWidth, float*
 
 // cudaPreImageNet
 cudaError_t cudaPreImageNet( float4* input, size_t inputWidth, size_t inputHeight,
-				         float* output, size_t outputWidth, size_t outputHeight )
+				         float* output, size_t outputWidth, size_t outputHeight, cudaFilterMode filter )
 {
 	if( !input || !output )
 		return cudaErrorInvalidDevicePointer;
@@ -63,7 +90,7 @@ cudaError_t cudaPreImageNet( float4* input, size_t inputWidth, size_t inputHeigh
 	const dim3 blockDim(8, 8);
 	const dim3 gridDim(iDivUp(outputWidth,blockDim.x), iDivUp(outputHeight,blockDim.y));
 
-	gpuPreImageNet<<<gridDim, blockDim>>>(scale, input, inputWidth, output, outputWidth, outputHeight);
+	gpuPreImageNet<<<gridDim, blockDim>>>(scale, input, inputWidth, inputHeight, output, outputWidth, outputHeight, filter);
 
 	return CUDA(cudaGetLastError());
 }
@@ -72,7 +99,7 @@ cudaError_t cudaPreImageNet( float4* input, size_t inputWidth, size_t inputHeigh
 
 
 // gpuPreImageNetMean
-__global__ void gpuPreImageNetMean( float2 scale, float4* input, int iWidth, float* output, int oWidth, int oHeight, float3 mean_value )
+__global__ void gpuPreImageNetMean( float2 scale, float4* input, int iWidth, int iHeight, float* output, int oWidth, int oHeight, float3 mean_value, cudaFilterMode filter )
 {
 	const int x = blockIdx.x * blockDim.x + threadIdx.x;
 	const int y = blockIdx.y * blockDim.y + threadIdx.y;
@@ -81,10 +108,8 @@ __global__ void gpuPreImageNetMean( float2 scale, float4* input, int iWidth, flo
 	if( x >= oWidth || y >= oHeight )
 		return;
 
-	const int dx = ((float)x * scale.x);
-	const int dy = ((float)y * scale.y);
-
-	const float4 px  = input[ dy * iWidth + dx ];
+	const RGBAfFetch fetch = { input, iWidth };
+	const float4 px = cudaFilterPixel(filter, fetch, scale, iWidth, iHeight, x, y);
 	const float3 bgr = make_float3(px.z - mean_value.x, px.y - mean_value.y, px.x - mean_value.z);
 
 	output[n * 0 + y * oWidth + x] = bgr.x;
@@ -95,7 +120,7 @@ __global__ void gpuPreImageNetMean( float2 scale, float4* input, int iWidth, flo
 
 // cudaPreImageNetMean
 cudaError_t cudaPreImageNetMean( float4* input, size_t inputWidth, size_t inputHeight,
-				             float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value )
+				             float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value, cudaFilterMode filter )
 {
 	if( !input || !output )
 		return cudaErrorInvalidDevicePointer;
@@ -110,9 +135,132 @@ cudaError_t cudaPreImageNetMean( float4* input, size_t inputWidth, size_t inputH
 	const dim3 blockDim(8, 8);
 	const dim3 gridDim(iDivUp(outputWidth,blockDim.x), iDivUp(outputHeight,blockDim.y));
 
-	gpuPreImageNetMean<<<gridDim, blockDim>>>(scale, input, inputWidth, output, outputWidth, outputHeight, mean_value);
+	gpuPreImageNetMean<<<gridDim, blockDim>>>(scale, input, inputWidth, inputHeight, output, outputWidth, outputHeight, mean_value, filter);
 
 	return CUDA(cudaGetLastError());
 }
 
 
+
+
+// gpuPreImageNetRGB
+__global__ void gpuPreImageNetRGB( float2 scale, uchar3* input, int iWidth, int iHeight, float* output, int oWidth, int oHeight, float3 mean_value, cudaFilterMode filter )
+{
+	const int x = blockIdx.x * blockDim.x + threadIdx.x;
+	const int y = blockIdx.y * blockDim.y + threadIdx.y;
+	const int n = oWidth * oHeight;
+
+	if( x >= oWidth || y >= oHeight )
+		return;
+
+	// only the sampled pixels of the camera frame are ever read
+	const RGB8Fetch fetch = { input, iWidth };
+	const float4 px = cudaFilterPixel(filter, fetch, scale, iWidth, iHeight, x, y);
+	const float3 bgr = make_float3(px.z - mean_value.x, px.y - mean_value.y, px.x - mean_value.z);
+
+	output[n * 0 + y * oWidth + x] = bgr.x;
+	output[n * 1 + y * oWidth + x] = bgr.y;
+	output[n * 2 + y * oWidth + x] = bgr.z;
+}
+
+
+// cudaPreImageNetRGB
+cudaError_t cudaPreImageNetRGB( uchar3* input, size_t inputWidth, size_t inputHeight,
+				            float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value, cudaFilterMode filter )
+{
+	if( !input || !output )
+		return cudaErrorInvalidDevicePointer;
+
+	if( inputWidth == 0 || outputWidth == 0 || inputHeight == 0 || outputHeight == 0 )
+		return cudaErrorInvalidValue;
+
+	const float2 scale = make_float2( float(inputWidth) / float(outputWidth),
+							    float(inputHeight) / float(outputHeight) );
+
+	// launch kernel, a warp per row segment so the planar stores coalesce
+	const dim3 blockDim(32, 8);
+	const dim3 gridDim(iDivUp(outputWidth,blockDim.x), iDivUp(outputHeight,blockDim.y));
+
+	gpuPreImageNetRGB<<<gridDim, blockDim>>>(scale, input, inputWidth, inputHeight, output, outputWidth, outputHeight, mean_value, filter);
+
+	return CUDA(cudaGetLastError());
+}
+
+
+
+
+// cudaLetterboxRect
+void cudaLetterboxRect( size_t inputWidth, size_t inputHeight, size_t outputWidth, size_t outputHeight,
+				    int2& offset, int2& size )
+{
+	const float scale = fminf(float(outputWidth) / float(inputWidth),
+					  float(outputHeight) / float(inputHeight));
+
+	size.x = min((int)(inputWidth * scale + 0.5f), (int)outputWidth);
+	size.y = min((int)(inputHeight * scale + 0.5f), (int)outputHeight);
+
+	offset.x = ((int)outputWidth - size.x) / 2;
+	offset.y = ((int)outputHeight - size.y) / 2;
+}
+
+
+// gpuPreImageNetLetterbox
+__global__ void gpuPreImageNetLetterbox( float2 scale, int2 offset, int2 size, float4* input, int iWidth, int iHeight,
+                                         float* output, int oWidth, int oHeight, float3 mean_value, float3 padding,
+                                         cudaFilterMode filter )
+{
+	const int x = blockIdx.x * blockDim.x + threadIdx.x;
+	const int y = blockIdx.y * blockDim.y + threadIdx.y;
+	const int n = oWidth * oHeight;
+
+	if( x >= oWidth || y >= oHeight )
+		return;
+
+	const int cx = x - offset.x;
+	const int cy = y - offset.y;
+
+	float3 bgr = padding;
+
+	if( cx >= 0 && cy >= 0 && cx < size.x && cy < size.y )
+	{
+		const RGBAfFetch fetch = { input, iWidth };
+		const float4 px = cudaFilterPixel(filter, fetch, scale, iWidth, iHeight, cx, cy);
+
+		bgr = make_float3(px.z, px.y, px.x);
+	}
+
+	output[n * 0 + y * oWidth + x] = bgr.x - mean_value.x;
+	output[n * 1 + y * oWidth + x] = bgr.y - mean_value.y;
+	output[n * 2 + y * oWidth + x] = bgr.z - mean_value.z;
+}
+
+
+// cudaPreImageNetLetterbox
+cudaError_t cudaPreImageNetLetterbox( float4* input, size_t inputWidth, size_t inputHeight,
+				                  float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value,
+				                  const float3& padding, cudaFilterMode filter )
+{
+	if( !input || !output )
+		return cudaErrorInvalidDevicePointer;
+
+	if( inputWidth == 0 || outputWidth == 0 || inputHeight == 0 || outputHeight == 0 )
+		return cudaErrorInvalidValue;
+
+	int2 offset, size;
+	cudaLetterboxRect(inputWidth, inputHeight, outputWidth, outputHeight, offset, size);
+
+	if( size.x == 0 || size.y == 0 )
+		return cudaErrorInvalidValue;
+
+	// the image is resized to the letterbox, not the whole output
+	const float2 scale = make_float2( float(inputWidth) / float(size.x),
+							    float(inputHeight) / float(size.y) );
+
+	// launch kernel
+	const dim3 blockDim(8, 8);
+	const dim3 gridDim(iDivUp(outputWidth,blockDim.x), iDivUp(outputHeight,blockDim.y));
+
+	gpuPreImageNetLetterbox<<<gridDim, blockDim>>>(scale, offset, size, input, inputWidth, inputHeight, output, outputWidth, outputHeight, mean_value, padding, filter);
+
+	return CUDA(cudaGetLastError());
+}
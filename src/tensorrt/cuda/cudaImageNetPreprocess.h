@@ -1,7 +1,36 @@
 #include <cuda_runtime.h>
 #include <cuda.h>
 
+#include "cudaFilterMode.h"
+
 cudaError_t cudaPreImageNet( float4* input, size_t inputWidth, size_t inputHeight,
-				         float* output, size_t outputWidth, size_t outputHeight );
+				         float* output, size_t outputWidth, size_t outputHeight,
+				         cudaFilterMode filter=FILTER_POINT );
 cudaError_t cudaPreImageNetMean( float4* input, size_t inputWidth, size_t inputHeight,
-				             float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value );
+				             float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value,
+				             cudaFilterMode filter=FILTER_POINT );
+
+/**
+ * Convert a packed 8-bit RGB image straight to a resized, mean subtracted,
+ * planar BGR float image, without an intermediate RGBAf image. Samples the
+ * same pixels as cudaPreImageNetMean() with the same filter.
+ */
+cudaError_t cudaPreImageNetRGB( uchar3* input, size_t inputWidth, size_t inputHeight,
+				            float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value,
+				            cudaFilterMode filter=FILTER_POINT );
+
+/**
+ * Position and size of an image scaled to fit the output with its aspect
+ * ratio preserved and centered, as used by cudaPreImageNetLetterbox().
+ */
+void cudaLetterboxRect( size_t inputWidth, size_t inputHeight, size_t outputWidth, size_t outputHeight,
+				    int2& offset, int2& size );
+
+/**
+ * Convert an RGBAf image to a mean subtracted, planar BGR float image scaled
+ * to fit the output with its aspect ratio preserved. The borders left over
+ * are filled with the padding pixel, given in the same BGR order as the mean.
+ */
+cudaError_t cudaPreImageNetLetterbox( float4* input, size_t inputWidth, size_t inputHeight,
+				                  float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value,
+				                  const float3& padding, cudaFilterMode filter=FILTER_POINT );
@@ -21,12 +21,35 @@
  */
 
 #include "cudaResize.h"
+#include "cudaFilterMode.cuh"
 
 
 
+// convert between resized pixel types and the float4 the samplers work in
+inline __device__ float4 resizeToFloat4( float px )		{ return make_float4(px, 0.0f, 0.0f, 0.0f); }
+inline __device__ float4 resizeToFloat4( const float4& px )	{ return px; }
+
+inline __device__ void resizeFromFloat4( const float4& px, float& out )	{ out = px.x; }
+inline __device__ void resizeFromFloat4( const float4& px, float4& out )	{ out = px; }
+
+
+// fetches pixels of a packed image
+template <typename T>
+struct ResizeFetch
+{
+	const T* image;
+	int width;
+
+	inline __device__ float4 operator()( int x, int y ) const
+	{
+		return resizeToFloat4(image[y * width + x]);
+	}
+};
+
+
 // gpuResample
 template <typename T>
-__global__ void gpuResize( float2 scale, T* input, int iWidth, T* output, int oWidth, int oHeight )
+__global__ void gpuResize( float2 scale, T* input, int iWidth, int iHeight, T* output, int oWidth, int oHeight, cudaFilterMode filter )
 {
 	const int x = blockIdx.x * blockDim.x + threadIdx.x;
 	const int y = blockIdx.y * blockDim.y + threadIdx.y;
@@ -34,18 +57,16 @@ __global__ void gpuResize( float2 scale, T* input, int iWidth, T* output, int oW
 	if( x >= oWidth || y >= oHeight )
 		return;
 
-	const int dx = ((float)x * scale.x);
-	const int dy = ((float)y * scale.y);
-
-	const T px = input[ dy * iWidth + dx ];
+	const ResizeFetch<T> fetch = { input, iWidth };
+	const float4 px = cudaFilterPixel(filter, fetch, scale, iWidth, iHeight, x, y);
 
-	output[y*oWidth+x] = px;
+	resizeFromFloat4(px, output[y*oWidth+x]);
 }
 
 
 // cudaResize
 cudaError_t cudaResize( float* input, size_t inputWidth, size_t inputHeight,
-				        float* output, size_t outputWidth, size_t outputHeight )
+				        float* output, size_t outputWidth, size_t outputHeight, cudaFilterMode filter )
 {
 	if( !input || !output )
 		return cudaErrorInvalidDevicePointer;
@@ -60,7 +81,7 @@ cudaError_t cudaResize( float* input, size_t inputWidth, size_t inputHeight,
 	const dim3 blockDim(8, 8);
 	const dim3 gridDim(iDivUp(outputWidth,blockDim.x), iDivUp(outputHeight,blockDim.y));
 
-	gpuResize<float><<<gridDim, blockDim>>>(scale, input, inputWidth, output, outputWidth, outputHeight);
+	gpuResize<float><<<gridDim, blockDim>>>(scale, input, inputWidth, inputHeight, output, outputWidth, outputHeight, filter);
 
 	return CUDA(cudaGetLastError());
 }
@@ -68,7 +89,7 @@ cudaError_t cudaResize( float* input, size_t inputWidth, size_t inputHeight,
 
 // cudaResizeRGBA
 cudaError_t cudaResizeRGBA( float4* input,  size_t inputWidth, size_t inputHeight,
-				            float4* output, size_t outputWidth, size_t outputHeight )
+				            float4* output, size_t outputWidth, size_t outputHeight, cudaFilterMode filter )
 {
 	if( !input || !output )
 		return cudaErrorInvalidDevicePointer;
@@ -83,7 +104,7 @@ cudaError_t cudaResizeRGBA( float4* input,  size_t inputWidth, size_t inputHeigh
 	const dim3 blockDim(8, 8);
 	const dim3 gridDim(iDivUp(outputWidth,blockDim.x), iDivUp(outputHeight,blockDim.y));
 
-	gpuResize<float4><<<gridDim, blockDim>>>(scale, input, inputWidth, output, outputWidth, outputHeight);
+	gpuResize<float4><<<gridDim, blockDim>>>(scale, input, inputWidth, inputHeight, output, outputWidth, outputHeight, filter);
 
 	return CUDA(cudaGetLastError());
 }
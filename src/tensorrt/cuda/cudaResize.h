@@ -25,22 +25,27 @@
 
 
 #include "cudaUtility.h"
+#include "cudaFilterMode.h"
 
 
 /**
- * Function for increasing or decreasing the size of an image on the GPU.
+ * Function for increasing or decreasing the size of an image on the GPU,
+ * sampling the input with the given filter.
  * @ingroup util
  */
 cudaError_t cudaResize( float* input,  size_t inputWidth,  size_t inputHeight,
-				    float* output, size_t outputWidth, size_t outputHeight );
+				    float* output, size_t outputWidth, size_t outputHeight,
+				    cudaFilterMode filter=FILTER_POINT );
 
 
 /**
- * Function for increasing or decreasing the size of an image on the GPU.
+ * Function for increasing or decreasing the size of an image on the GPU,
+ * sampling the input with the given filter.
  * @ingroup util
  */
 cudaError_t cudaResizeRGBA( float4* input,  size_t inputWidth,  size_t inputHeight,
-				        float4* output, size_t outputWidth, size_t outputHeight );
+				        float4* output, size_t outputWidth, size_t outputHeight,
+				        cudaFilterMode filter=FILTER_POINT );
 
 
 						
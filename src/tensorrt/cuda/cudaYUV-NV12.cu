@@ -21,6 +21,7 @@
  */
 
 #include "cudaYUV.h"
+#include "cudaFilterMode.cuh"
 
 
 #define COLOR_COMPONENT_MASK            0x3FF
@@ -390,6 +391,89 @@ cudaError_t cudaNV12ToRGBAf( uint8_t* srcDev, float4* destDev, size_t width, siz
 }
 
 
+//-------------------------------------------------------------------------------------------------------------------------
+
+// fetches pixels of an NV12 image, converted like NV12ToRGBAf
+struct NV12Fetch
+{
+	const uint8_t* srcImage;
+	uint32_t width;
+	uint32_t height;
+
+	inline __device__ float4 operator()( int dx, int dy ) const
+	{
+		// Chroma is shared by the pixel pair starting at an even column, and
+		// interpolated vertically on odd scanlines, like NV12ToRGBAf
+		const int x_chroma = dx & ~1;
+		const int y_chroma = dy >> 1;
+		const uint32_t chromaOffset = width * height;
+
+		uint32_t chromaCb = srcImage[chromaOffset + y_chroma * width + x_chroma    ];
+		uint32_t chromaCr = srcImage[chromaOffset + y_chroma * width + x_chroma + 1];
+
+		if( (dy & 1) && y_chroma < ((height >> 1) - 1) )
+		{
+			chromaCb = (chromaCb + srcImage[chromaOffset + (y_chroma + 1) * width + x_chroma    ] + 1) >> 1;
+			chromaCr = (chromaCr + srcImage[chromaOffset + (y_chroma + 1) * width + x_chroma + 1] + 1) >> 1;
+		}
+
+		uint32_t yuvi[3];
+		float red, green, blue;
+
+		yuvi[0] = (uint32_t)srcImage[dy * width + dx] << 2;
+		yuvi[1] = chromaCb << 2;
+		yuvi[2] = chromaCr << 2;
+
+		YUV2RGB(&yuvi[0], &red, &green, &blue);
+
+		const float s = 1.0f / 1024.0f * 255.0f;
+
+		return make_float4(red * s, green * s, blue * s, 255.0f);
+	}
+};
+
+
+__global__ void NV12ToImageNet( float2 scale, uint8_t* srcImage, uint32_t width, uint32_t height,
+                                float* output, int oWidth, int oHeight, float3 mean_value, cudaFilterMode filter )
+{
+	const int x = blockIdx.x * blockDim.x + threadIdx.x;
+	const int y = blockIdx.y * blockDim.y + threadIdx.y;
+	const int n = oWidth * oHeight;
+
+	if( x >= oWidth || y >= oHeight )
+		return;
+
+	const NV12Fetch fetch = { srcImage, width, height };
+	const float4 px = cudaFilterPixel(filter, fetch, scale, width, height, x, y);
+
+	output[n * 0 + y * oWidth + x] = px.z - mean_value.x;
+	output[n * 1 + y * oWidth + x] = px.y - mean_value.y;
+	output[n * 2 + y * oWidth + x] = px.x - mean_value.z;
+}
+
+
+// cudaNV12ToImageNet
+cudaError_t cudaNV12ToImageNet( uint8_t* srcDev, size_t width, size_t height,
+				    float* destDev, size_t outputWidth, size_t outputHeight, const float3& mean_value, cudaFilterMode filter )
+{
+	if( !srcDev || !destDev )
+		return cudaErrorInvalidDevicePointer;
+
+	if( width == 0 || height == 0 || outputWidth == 0 || outputHeight == 0 )
+		return cudaErrorInvalidValue;
+
+	const float2 scale = make_float2( float(width) / float(outputWidth),
+							    float(height) / float(outputHeight) );
+
+	const dim3 blockDim(32,8,1);
+	const dim3 gridDim(iDivUp(outputWidth,blockDim.x), iDivUp(outputHeight,blockDim.y), 1);
+
+	NV12ToImageNet<<<gridDim, blockDim>>>( scale, srcDev, width, height, destDev, outputWidth, outputHeight, mean_value, filter );
+
+	return CUDA(cudaGetLastError());
+}
+
+
 // cudaNV12SetupColorspace
 cudaError_t cudaNV12SetupColorspace( float hue )
 {
@@ -26,6 +26,7 @@
 
 #include "cudaUtility.h"
 #include <stdint.h>
+#include "cudaFilterMode.h"
 
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -135,6 +136,16 @@ cudaError_t cudaNV12ToRGBA( uint8_t* input, uchar4* output, size_t width, size_t
 cudaError_t cudaNV12ToRGBAf( uint8_t* input, size_t inputPitch, float4* output, size_t outputPitch, size_t width, size_t height );
 cudaError_t cudaNV12ToRGBAf( uint8_t* input, float4* output, size_t width, size_t height );
 
+/**
+ * Convert an NV12 image straight to a resized, mean subtracted, planar BGR
+ * float image, without an intermediate RGBAf image. Converts the sampled
+ * pixels exactly like cudaNV12ToRGBAf() followed by cudaPreImageNetMean()
+ * with the same filter.
+ */
+cudaError_t cudaNV12ToImageNet( uint8_t* input, size_t inputWidth, size_t inputHeight,
+				    float* output, size_t outputWidth, size_t outputHeight, const float3& mean_value,
+				    cudaFilterMode filter=FILTER_POINT );
+
 /**
  * Setup NV12 color conversion constants.
  * cudaNV12SetupColorspace() isn't necessary for the user to call, it will be
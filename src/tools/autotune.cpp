@@ -0,0 +1,409 @@
+/**
+ * @file	autotune.cpp
+ * @author	Carroll Vance
+ * @brief	Finds the fastest precision, workspace and batch size of a network
+ *
+ * Copyright (c) 2018 Carroll Vance.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "NvInfer.h"
+
+#include "Autotuner.h"
+#include "CaffeRTEngine.h"
+#include "CalibrationImages.h"
+#include "MockBackend.h"
+#include "PipelineCalibrator.h"
+#include "TensorflowRTEngine.h"
+#include "TuningReport.h"
+
+using namespace jetson_tensorrt;
+
+/**
+ * @brief Engine running on a MockBackend, which lets the sweep and the
+ * report be tried without a GPU
+ */
+class MockTunedEngine : public TensorRTEngine {
+public:
+  void addInput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkInputs.push_back(NetworkInput(layerName, dims, eleSize));
+  }
+
+  void addOutput(std::string layerName, nvinfer1::Dims dims, size_t eleSize) {
+    networkOutputs.push_back(NetworkOutput(layerName, dims, eleSize));
+  }
+};
+
+struct TensorSpec {
+  std::string name;
+  nvinfer1::Dims dims;
+};
+
+struct Options {
+  std::string prototxt, caffemodel, uff;
+  std::vector<TensorSpec> inputs, outputs;
+
+  std::vector<nvinfer1::DataType> dataTypes;
+  std::vector<size_t> workspaces, batchSizes;
+  size_t warmup, iterations;
+  double latencyBudgetMs;
+
+  std::string calibrationTable, calibrationImages;
+  float3 mean;
+
+  long mockLatencyMicros;
+  std::string report;
+};
+
+static void usage(const char *program) {
+  fprintf(
+      stderr,
+      "Usage: %s MODEL --input NAME:DIMS --output NAME:DIMS [options]\n"
+      "\n"
+      "Models:\n"
+      "  --prototxt FILE --caffemodel FILE  Caffe model\n"
+      "  --uff FILE                          Tensorflow model\n"
+      "  --mock LATENCY_US                   MockBackend, no GPU needed\n"
+      "\n"
+      "Tensors, repeated for every input and output:\n"
+      "  --input NAME:C,H,W  --output NAME:D1,D2,...\n"
+      "\n"
+      "Sweep:\n"
+      "  --data-types LIST      32, 16 and/or 8 (default 32,16)\n"
+      "  --workspaces LIST      builder workspace sizes, K, M or G suffix\n"
+      "                         (default 256M,1G)\n"
+      "  --batch-sizes LIST     (default 1,2,4,8)\n"
+      "  --warmup N             untimed predictions (default %zu)\n"
+      "  --iterations N         timed predictions (default %zu)\n"
+      "  --latency-budget MS    largest p99 latency of a batch to recommend\n"
+      "\n"
+      "INT8:\n"
+      "  --calibration-table FILE   table to read, or to write when\n"
+      "  --calibration-images DIR   PPM images to calibrate with are given\n"
+      "  --mean R,G,B               ImageNet means of the preprocessing\n"
+      "\n"
+      "  --report PREFIX        writes PREFIX.csv, .json and .yaml\n"
+      "                         (default autotune)\n",
+      program, Autotuner::DEFAULT_WARMUP, Autotuner::DEFAULT_ITERATIONS);
+}
+
+static std::vector<std::string> split(std::string text, char separator) {
+  std::vector<std::string> parts;
+
+  size_t start = 0;
+  while (true) {
+    size_t end = text.find(separator, start);
+    parts.push_back(text.substr(start, end - start));
+    if (end == std::string::npos)
+      return parts;
+    start = end + 1;
+  }
+}
+
+static size_t parseSize(std::string text) {
+  char *suffix;
+  unsigned long long value = std::strtoull(text.c_str(), &suffix, 10);
+
+  switch (*suffix) {
+  case 'G':
+    return value << 30;
+  case 'M':
+    return value << 20;
+  case 'K':
+    return value << 10;
+  case '\0':
+    return value;
+  default:
+    throw std::invalid_argument("Invalid size: " + text);
+  }
+}
+
+static std::vector<size_t> parseSizes(std::string text) {
+  std::vector<size_t> sizes;
+  std::vector<std::string> parts = split(text, ',');
+
+  for (int p = 0; p < parts.size(); p++) {
+    sizes.push_back(parseSize(parts[p]));
+    if (sizes.back() == 0)
+      throw std::invalid_argument("Sizes must not be 0: " + text);
+  }
+
+  return sizes;
+}
+
+static std::vector<nvinfer1::DataType> parseDataTypes(std::string text) {
+  std::vector<nvinfer1::DataType> dataTypes;
+  std::vector<std::string> parts = split(text, ',');
+
+  for (int p = 0; p < parts.size(); p++) {
+    if (parts[p] == "32")
+      dataTypes.push_back(nvinfer1::DataType::kFLOAT);
+    else if (parts[p] == "16")
+      dataTypes.push_back(nvinfer1::DataType::kHALF);
+    else if (parts[p] == "8")
+      dataTypes.push_back(nvinfer1::DataType::kINT8);
+    else
+      throw std::invalid_argument("Invalid data type: " + parts[p]);
+  }
+
+  return dataTypes;
+}
+
+static TensorSpec parseTensor(std::string text) {
+  size_t colon = text.rfind(':');
+  if (colon == std::string::npos)
+    throw std::invalid_argument("Tensors are given as NAME:DIMS: " + text);
+
+  TensorSpec tensor;
+  tensor.name = text.substr(0, colon);
+
+  std::vector<size_t> dims = parseSizes(text.substr(colon + 1));
+  if (dims.size() > nvinfer1::Dims::MAX_DIMS)
+    throw std::invalid_argument("Too many dimensions: " + text);
+
+  if (dims.size() == 3) {
+    tensor.dims = nvinfer1::DimsCHW(dims[0], dims[1], dims[2]);
+  } else {
+    tensor.dims.nbDims = dims.size();
+    for (int d = 0; d < dims.size(); d++)
+      tensor.dims.d[d] = dims[d];
+  }
+
+  return tensor;
+}
+
+static Options parseOptions(int argc, char **argv) {
+  Options options;
+  options.dataTypes = parseDataTypes("32,16");
+  options.workspaces = parseSizes("256M,1G");
+  options.batchSizes = parseSizes("1,2,4,8");
+  options.warmup = Autotuner::DEFAULT_WARMUP;
+  options.iterations = Autotuner::DEFAULT_ITERATIONS;
+  options.latencyBudgetMs = 0;
+  options.mean = make_float3(0, 0, 0);
+  options.mockLatencyMicros = -1;
+  options.report = "autotune";
+
+  for (int a = 1; a < argc; a++) {
+    std::string option = argv[a];
+    if (a + 1 >= argc)
+      throw std::invalid_argument("Missing value of " + option);
+    std::string value = argv[++a];
+
+    if (option == "--prototxt")
+      options.prototxt = value;
+    else if (option == "--caffemodel")
+      options.caffemodel = value;
+    else if (option == "--uff")
+      options.uff = value;
+    else if (option == "--mock")
+      options.mockLatencyMicros = std::atol(value.c_str());
+    else if (option == "--input")
+      options.inputs.push_back(parseTensor(value));
+    else if (option == "--output")
+      options.outputs.push_back(parseTensor(value));
+    else if (option == "--data-types")
+      options.dataTypes = parseDataTypes(value);
+    else if (option == "--workspaces")
+      options.workspaces = parseSizes(value);
+    else if (option == "--batch-sizes")
+      options.batchSizes = parseSizes(value);
+    else if (option == "--warmup")
+      options.warmup = std::strtoul(value.c_str(), NULL, 10);
+    else if (option == "--iterations")
+      options.iterations = std::strtoul(value.c_str(), NULL, 10);
+    else if (option == "--latency-budget")
+      options.latencyBudgetMs = std::atof(value.c_str());
+    else if (option == "--calibration-table")
+      options.calibrationTable = value;
+    else if (option == "--calibration-images")
+      options.calibrationImages = value;
+    else if (option == "--report")
+      options.report = value;
+    else if (option == "--mean") {
+      std::vector<std::string> mean = split(value, ',');
+      if (mean.size() != 3)
+        throw std::invalid_argument("Means are given as R,G,B: " + value);
+      options.mean = make_float3(std::atof(mean[0].c_str()),
+                                 std::atof(mean[1].c_str()),
+                                 std::atof(mean[2].c_str()));
+    } else
+      throw std::invalid_argument("Unknown option " + option);
+  }
+
+  int models = (!options.prototxt.empty() || !options.caffemodel.empty()) +
+               !options.uff.empty() + (options.mockLatencyMicros >= 0);
+  if (models != 1)
+    throw std::invalid_argument("Exactly one model has to be given");
+
+  if (options.prototxt.empty() != options.caffemodel.empty())
+    throw std::invalid_argument("Caffe models need a prototxt and weights");
+
+  if (options.inputs.empty() || options.outputs.empty())
+    throw std::invalid_argument("Inputs and outputs have to be given");
+
+  return options;
+}
+
+/**
+ * @brief Creates the calibrator shared by every INT8 build, NULL when the
+ * sweep has no INT8 configurations or nothing to calibrate from
+ */
+static PipelineCalibrator *createCalibrator(Options &options) {
+  bool int8 = false;
+  for (int d = 0; d < options.dataTypes.size(); d++)
+    int8 |= options.dataTypes[d] == nvinfer1::DataType::kINT8;
+
+  if (!int8 || options.calibrationTable.empty() ||
+      options.mockLatencyMicros >= 0)
+    return NULL;
+
+  TensorSpec &input = options.inputs[0];
+  if (input.dims.nbDims != 3)
+    throw std::invalid_argument("INT8 calibration needs a CHW image input");
+
+  int width = input.dims.d[2], height = input.dims.d[1];
+  float3 mean = options.mean;
+  PipelineFactory pipelineFactory = [width, height, mean](int w, int h) {
+    return CUDAPipeline::createRGBImageNetPipeline(w, h, width, height, mean);
+  };
+
+  ImageSource *images = NULL;
+  if (!options.calibrationImages.empty())
+    images = new PPMDirectorySource(options.calibrationImages);
+
+  return new PipelineCalibrator(
+      images, pipelineFactory,
+      NetworkInput(input.name, input.dims, sizeof(float)), 8,
+      options.calibrationTable);
+}
+
+/**
+ * @brief Registers the tensors of the options with an engine
+ */
+template <typename Engine>
+static void addTensors(Engine *engine, Options &options) {
+  for (int i = 0; i < options.inputs.size(); i++)
+    engine->addInput(options.inputs[i].name, options.inputs[i].dims,
+                     sizeof(float));
+
+  for (int o = 0; o < options.outputs.size(); o++)
+    engine->addOutput(options.outputs[o].name, options.outputs[o].dims,
+                      sizeof(float));
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  try {
+    options = parseOptions(argc, argv);
+  } catch (std::exception &e) {
+    fprintf(stderr, "%s\n\n", e.what());
+    usage(argv[0]);
+    return 1;
+  }
+
+  PipelineCalibrator *calibrator = createCalibrator(options);
+
+  TuningEngineFactory factory =
+      [&options, calibrator](const TuningConfig &config) -> TensorRTEngine * {
+    if (options.mockLatencyMicros >= 0) {
+      MockTunedEngine *engine = new MockTunedEngine();
+      addTensors(engine, options);
+      engine->attachBackend(
+          new MockBackend(
+              engine->networkInputs, engine->networkOutputs,
+              std::chrono::microseconds(options.mockLatencyMicros)),
+          config.batchSize);
+      return engine;
+    }
+
+    if (!options.uff.empty()) {
+      TensorflowRTEngine *engine = new TensorflowRTEngine();
+      try {
+        addTensors(engine, options);
+        engine->loadModel(options.uff, config.batchSize, config.dataType,
+                          config.maxNetworkSize, calibrator);
+      } catch (...) {
+        delete engine;
+        throw;
+      }
+      return engine;
+    }
+
+    CaffeRTEngine *engine = new CaffeRTEngine();
+    try {
+      addTensors(engine, options);
+      engine->loadModel(options.prototxt, options.caffemodel,
+                        config.batchSize, config.dataType,
+                        config.maxNetworkSize, calibrator);
+    } catch (...) {
+      delete engine;
+      throw;
+    }
+    return engine;
+  };
+
+  Autotuner tuner(factory, options.warmup, options.iterations,
+                  options.mockLatencyMicros >= 0 ? MemoryLocation::HOST
+                                                 : MemoryLocation::DEVICE);
+
+  std::vector<TuningConfig> configs = Autotuner::combinations(
+      options.dataTypes, options.workspaces, options.batchSizes);
+
+  std::vector<TuningResult> results =
+      tuner.sweep(configs, [](const TuningResult &result) {
+        printf("data_type %2d workspace %5zu MB batch %3zu: ",
+               TuningReport::dataTypeBits(result.config.dataType),
+               result.config.maxNetworkSize >> 20, result.config.batchSize);
+
+        if (result.succeeded)
+          printf("%10.1f records/s, p99 %8.3f ms\n", result.recordsPerSecond,
+                 result.p99Ms);
+        else
+          printf("failed: %s\n", result.error.c_str());
+        fflush(stdout);
+      });
+
+  delete calibrator;
+
+  TuningReport report(results, options.latencyBudgetMs);
+  try {
+    report.save(options.report);
+  } catch (std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  if (report.recommended() < 0) {
+    fprintf(stderr, "No configuration could be built\n");
+    return 1;
+  }
+
+  printf("Recommendation written to %s.yaml\n", options.report.c_str());
+
+  return 0;
+}